@@ -0,0 +1,523 @@
+#include "NMSCatalogue.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <thread>
+
+#include <Core/ErrorHandling.h>
+#include <Core/LogStream.h>
+
+// Smaller files are quicker parsed on one thread than by starting more.
+static const size_t ParallelBytes = 1 << 20;
+
+// Text catalogues have no colours.
+static const unsigned int DefaultColour = 0xFFFFFFFF;
+
+/*
+	The baked file is this header followed by the sections it points to,
+	each starting on a 16 byte boundary. Everything is in the byte order of
+	the machine that baked it; a file that does not match is baked again.
+	positions	3 * count floats, the x's then the y's then the z's
+	colours		count RGBA8
+	labelStart	count + 1 offsets into labels
+	labels		labelsSize characters
+	cells		cellCount NMSCatalogueCell, the stars sorted by cell
+*/
+struct BakedHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int count;
+	unsigned int cellCount;
+	float scaleToWorld;
+	float cellSize;
+	unsigned int labelsSize;
+	unsigned int unused;
+	unsigned long long positions;
+	unsigned long long colours;
+	unsigned long long labelStart;
+	unsigned long long labels;
+	unsigned long long cells;
+};
+
+static const char BakedMagic[4] = { 'N', 'M', 'S', 'C' };
+// Change when the layout changes so old files are baked again.
+static const unsigned int BakedVersion = 1;
+static const unsigned long long BakedAlignment = 16;
+
+// What one thread parses from part of the text.
+struct ParsedPiece
+{
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<char> labels;
+	std::vector<unsigned int> labelStart = { 0 };
+
+	// Parses the lines in [begin, end) of text.
+	void parseLines(std::string_view text, size_t begin, size_t end, float scaleToWorld);
+};
+
+static std::string_view trim(std::string_view s)
+{
+	size_t first = s.find_first_not_of(" \t\r");
+	if (first == std::string_view::npos)
+		return std::string_view();
+	size_t last = s.find_last_not_of(" \t\r");
+	return s.substr(first, last - first + 1);
+}
+
+// Splits s at delim into at most maxFields fields, skipping empty ones as
+// OWUtils::split does. Returns the number of fields in s which may be
+// more than maxFields.
+static size_t split(std::string_view s, char delim,
+	std::string_view* fields, size_t maxFields)
+{
+	size_t count = 0;
+	size_t pos = 0;
+	while (pos < s.size())
+	{
+		if (s[pos] == delim)
+		{
+			pos++;
+			continue;
+		}
+		size_t end = s.find(delim, pos);
+		if (end == std::string_view::npos)
+			end = s.size();
+		if (count < maxFields)
+			fields[count] = s.substr(pos, end - pos);
+		count++;
+		pos = end;
+	}
+	return count;
+}
+
+static bool hexValue(std::string_view s, long long& value)
+{
+	if (s.empty() || s.size() > 15)
+		return false;
+	value = 0;
+	for (char c : s)
+	{
+		int digit;
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else
+			return false;
+		value = value * 16 + digit;
+	}
+	return true;
+}
+
+static bool decimalValue(std::string_view s, long long& value)
+{
+	if (s.empty() || s.size() > 18)
+		return false;
+	value = 0;
+	for (char c : s)
+	{
+		if (c < '0' || c > '9')
+			return false;
+		value = value * 10 + (c - '0');
+	}
+	return true;
+}
+
+NMSCatalogue NMSCatalogue::parse(std::string_view text, float scaleToWorld)
+{
+	// The first empty line ends the file.
+	size_t stop = std::min(text.find("\n\n"), text.find("\n\r\n"));
+	if (text.substr(0, 1) == "\n" || text.substr(0, 2) == "\r\n")
+		stop = 0;
+	text = text.substr(0, std::min(stop, text.size()));
+
+	unsigned int threads = 1;
+	if (text.size() >= ParallelBytes)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<ParsedPiece> pieces(1);
+	if (threads == 1)
+	{
+		pieces[0].parseLines(text, 0, text.size(), scaleToWorld);
+	}
+	else
+	{
+		// Pieces of about the same size, each ending at the end of a line.
+		std::vector<std::future<ParsedPiece>> futures;
+		size_t begin = 0;
+		for (unsigned int t = 0; t < threads && begin < text.size(); t++)
+		{
+			size_t end = text.size();
+			if (t + 1 < threads)
+			{
+				end = text.find('\n', std::max(begin, text.size() * (t + 1) / threads));
+				end = end == std::string_view::npos ? text.size() : end + 1;
+			}
+			futures.push_back(std::async(std::launch::async, [text, begin, end, scaleToWorld]()
+			{
+				ParsedPiece piece;
+				piece.parseLines(text, begin, end, scaleToWorld);
+				return piece;
+			}));
+			begin = end;
+		}
+		// In order so the stars are in file order. get() rethrows parse errors.
+		pieces.clear();
+		for (std::future<ParsedPiece>& f : futures)
+			pieces.push_back(f.get());
+	}
+
+	NMSCatalogue retval;
+	retval.mScaleToWorld = scaleToWorld;
+	for (const ParsedPiece& piece : pieces)
+		retval.mCount += piece.x.size();
+	retval.mOwnedPositions.reserve(3 * retval.mCount);
+	for (const ParsedPiece& piece : pieces)
+		retval.mOwnedPositions.insert(retval.mOwnedPositions.end(), piece.x.begin(), piece.x.end());
+	for (const ParsedPiece& piece : pieces)
+		retval.mOwnedPositions.insert(retval.mOwnedPositions.end(), piece.y.begin(), piece.y.end());
+	for (const ParsedPiece& piece : pieces)
+		retval.mOwnedPositions.insert(retval.mOwnedPositions.end(), piece.z.begin(), piece.z.end());
+	retval.mOwnedColours.assign(retval.mCount, DefaultColour);
+	for (const ParsedPiece& piece : pieces)
+	{
+		unsigned int base = static_cast<unsigned int>(retval.mOwnedLabels.size());
+		retval.mOwnedLabels.insert(retval.mOwnedLabels.end(), piece.labels.begin(), piece.labels.end());
+		for (size_t i = 1; i < piece.labelStart.size(); i++)
+			retval.mOwnedLabelStart.push_back(base + piece.labelStart[i]);
+	}
+	retval.useOwned();
+	return retval;
+}
+
+void ParsedPiece::parseLines(std::string_view text, size_t begin,
+	size_t end, float scaleToWorld)
+{
+	// Most lines are 30 to 50 characters.
+	size_t estimate = (end - begin) / 32;
+	x.reserve(estimate);
+	y.reserve(estimate);
+	z.reserve(estimate);
+	labelStart.reserve(estimate + 1);
+	labels.reserve(estimate * 12);
+
+	size_t pos = begin;
+	while (pos < end)
+	{
+		size_t lineStart = pos;
+		size_t eol = text.find('\n', pos);
+		if (eol == std::string_view::npos || eol > end)
+			eol = end;
+		std::string_view line = text.substr(pos, eol - pos);
+		pos = eol + 1;
+		if (!line.empty() && line.back() == '\r')
+			line.remove_suffix(1);
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::string_view fields[4];
+		size_t fieldCount = split(line, ',', fields, 4);
+		long long px = 0;
+		long long py = 0;
+		long long pz = 0;
+		bool valid = true;
+		if (fieldCount == 2)
+		{
+			std::string_view coords[5];
+			size_t coordCount = split(fields[1], ':', coords, 5);
+			if (coordCount == 5)
+			{
+				// Signal Booster: AAAA:XXXX:YYYY:ZZZZ:SSSS
+				// AAAA - something to do with the location on a planet's surface
+				// SSSS - is the index of the system within the galactic region. Each region is, roughly, a 400 LY cube.
+				//      - Same as Portal address System ID
+				std::copy(coords + 1, coords + 5, coords);
+				coordCount = 4;
+			}
+
+			if (coordCount == 4)
+			{
+				// https://nomanssky.gamepedia.com/Portal_address#Galactic_Coordinates_System
+				// Values begin at the bottom northwest corner of the chart and end at the
+				// top southeast corner, at Delta Majoris, where it ends
+				// at 0FFE:00FE : 0FFE : 0000
+				// format is label, galactic coords: screenX:screenY:z:w
+				// This mapping to the Game world asuming 0,0,0 is at the center.
+				valid = hexValue(trim(coords[0]), px) && hexValue(trim(coords[1]), py)
+					&& hexValue(trim(coords[2]), pz);
+				px -= 0x7FF;
+				py -= 0x7F;
+				pz -= 0x7FF;
+			}
+			else if (coordCount == 1)
+			{
+				// https://nomanssky.gamepedia.com/Portal_address#Portal_Coordinates_System
+				// Portal Coordinates can be confirmed at
+				// https://pahefu.github.io/pilgrimstarpath/
+				// format is label, PortalAddress. Comes from the 12 Glyph
+				// characters that a Portal Terminal uses. Format is PSSSYYZZZXXX
+				// P - Planet Index in a system. Max value == 6
+				// SSS - Solar System Index. The address for a specific
+				// star system within the given region. So far the max
+				// number of systems in a region is 555
+				// Voxel Position x=0, y=0, z=0 is at the center.
+				//				Y Values. Y axis is height. Ranges from [01, FF)
+				// Increases from 0 to Up Pole at 7F
+				// Starts again at Down Pole at 81 increasing to FF (which is back at the center)
+				// Entering Y=80 returns Y=81.
+				//				X Values. [001, FFF]
+				// X Values have East and West Poles. They increase easterly beginning
+				// with 0 at the center. 7FF is  the East (right) Pole
+				// Resumes with West Pole = X=801 and increasing towards the center.
+				// Entering X=800 returns X=801
+				//				Z Values. [001, FFF] (details same as X)
+				// Z values have South and North Poles. They increase southerly until
+				// z=7FF then numbering resumes from the northern pole with Z=801 and
+				// increasing as it nears centre
+				std::string_view portal = trim(coords[0]);
+				if (portal.size() == 12)
+				{
+					valid = hexValue(portal.substr(9, 3), px) && hexValue(portal.substr(4, 2), py)
+						&& hexValue(portal.substr(6, 3), pz);
+					if (px > 0x7FF)
+						px -= 0xFFF;
+					if (py > 0x7F)
+						py -= 0xFF;
+					if (pz > 0x7FF)
+						pz -= 0xFFF;
+				}
+			}
+		}
+		else if (fieldCount == 4)
+		{
+			// format is label, screenX, screenY, z
+			valid = decimalValue(trim(fields[1]), px) && decimalValue(trim(fields[2]), pz);
+		}
+		if (!valid)
+		{
+			throw NMSException(std::stringstream() << "Star map line ["
+				<< std::count(text.begin(), text.begin() + lineStart, '\n') + 1
+				<< "] has a bad address [" << line << "]");
+		}
+		x.push_back(static_cast<float>(px) * scaleToWorld);
+		y.push_back(static_cast<float>(py) * scaleToWorld);
+		z.push_back(static_cast<float>(pz) * scaleToWorld);
+		if (fieldCount > 0)
+			labels.insert(labels.end(), fields[0].begin(), fields[0].end());
+		labelStart.push_back(static_cast<unsigned int>(labels.size()));
+	}
+}
+
+NMSCatalogue NMSCatalogue::loadText(const std::string& fileName, float scaleToWorld)
+{
+	MappedFile file(fileName);
+	return parse(file.view(), scaleToWorld);
+}
+
+NMSCatalogue NMSCatalogue::loadBaked(const std::string& fileName)
+{
+	NMSCatalogue retval;
+	if (!retval.useBaked(std::make_unique<MappedFile>(fileName)))
+	{
+		throw NMSException(std::stringstream() << "File [" << fileName
+			<< "] is not a version [" << BakedVersion << "] baked star catalogue.");
+	}
+	return retval;
+}
+
+NMSCatalogue NMSCatalogue::load(const std::string& textFile,
+	const std::string& bakedFile, float scaleToWorld, float cellSize)
+{
+	std::error_code ec;
+	if (std::filesystem::exists(bakedFile, ec))
+	{
+		bool current = !std::filesystem::exists(textFile, ec)
+			|| std::filesystem::last_write_time(bakedFile, ec)
+				>= std::filesystem::last_write_time(textFile, ec);
+		if (current)
+		{
+			NMSCatalogue retval;
+			if (retval.useBaked(std::make_unique<MappedFile>(bakedFile))
+				&& retval.mScaleToWorld == scaleToWorld && retval.mCellSize == cellSize)
+				return retval;
+		}
+	}
+
+	NMSCatalogue retval = loadText(textFile, scaleToWorld);
+	try
+	{
+		retval.bake(bakedFile, cellSize);
+	}
+	catch (const NMSException& e)
+	{
+		LogStream(LogStreamLevel::Warning) << e.what() << " Using [" << textFile << "].\n";
+		return retval;
+	}
+	// From the file just baked so the stars are in cell order as they are
+	// on the next run.
+	NMSCatalogue baked;
+	if (baked.useBaked(std::make_unique<MappedFile>(bakedFile)))
+		return baked;
+	return retval;
+}
+
+void NMSCatalogue::bake(const std::string& fileName, float cellSize) const
+{
+	// The order the stars are written in: by cell if there are cells.
+	std::vector<unsigned int> order(mCount);
+	for (unsigned int i = 0; i < mCount; i++)
+		order[i] = i;
+	std::vector<NMSCatalogueCell> cells;
+	if (cellSize > 0.0f)
+	{
+		std::vector<std::array<int, 3>> starCells(mCount);
+		for (size_t i = 0; i < mCount; i++)
+		{
+			starCells[i] = { static_cast<int>(std::floor(x(i) / cellSize)),
+							 static_cast<int>(std::floor(y(i) / cellSize)),
+							 static_cast<int>(std::floor(z(i) / cellSize)) };
+		}
+		std::stable_sort(order.begin(), order.end(), [&starCells](unsigned int a, unsigned int b)
+		{
+			return starCells[a] < starCells[b];
+		});
+		for (unsigned int i = 0; i < mCount; i++)
+		{
+			const std::array<int, 3>& c = starCells[order[i]];
+			if (cells.empty() || cells.back().x != c[0]
+				|| cells.back().y != c[1] || cells.back().z != c[2])
+				cells.push_back({ c[0], c[1], c[2], i, 0 });
+			cells.back().count++;
+		}
+	}
+
+	std::vector<float> positions(3 * mCount);
+	std::vector<unsigned int> colours(mCount);
+	std::vector<char> labels;
+	labels.reserve(mLabelStart[mCount]);
+	std::vector<unsigned int> labelStart = { 0 };
+	labelStart.reserve(mCount + 1);
+	for (size_t i = 0; i < mCount; i++)
+	{
+		size_t from = order[i];
+		positions[i] = x(from);
+		positions[mCount + i] = y(from);
+		positions[2 * mCount + i] = z(from);
+		colours[i] = mColours[from];
+		std::string_view l = label(from);
+		labels.insert(labels.end(), l.begin(), l.end());
+		labelStart.push_back(static_cast<unsigned int>(labels.size()));
+	}
+
+	auto aligned = [](unsigned long long offset)
+	{
+		return (offset + BakedAlignment - 1) / BakedAlignment * BakedAlignment;
+	};
+	BakedHeader header = {};
+	std::memcpy(header.magic, BakedMagic, sizeof(BakedMagic));
+	header.version = BakedVersion;
+	header.count = static_cast<unsigned int>(mCount);
+	header.cellCount = static_cast<unsigned int>(cells.size());
+	header.scaleToWorld = mScaleToWorld;
+	header.cellSize = cellSize;
+	header.labelsSize = static_cast<unsigned int>(labels.size());
+	header.positions = aligned(sizeof(BakedHeader));
+	header.colours = aligned(header.positions + positions.size() * sizeof(float));
+	header.labelStart = aligned(header.colours + colours.size() * sizeof(unsigned int));
+	header.labels = aligned(header.labelStart + labelStart.size() * sizeof(unsigned int));
+	header.cells = aligned(header.labels + labels.size());
+
+	// Written to one side and renamed so a failed bake never leaves half a
+	// file to be loaded next time.
+	std::string tempName = fileName + ".tmp";
+	{
+		std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw NMSException(std::stringstream() << "Cannot write baked star catalogue [" << tempName << "].");
+		auto write = [&out](unsigned long long offset, const void* data, size_t bytes)
+		{
+			static const char zeros[BakedAlignment] = {};
+			out.write(zeros, static_cast<std::streamsize>(offset
+				- static_cast<unsigned long long>(out.tellp())));
+			out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+		};
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		write(header.positions, positions.data(), positions.size() * sizeof(float));
+		write(header.colours, colours.data(), colours.size() * sizeof(unsigned int));
+		write(header.labelStart, labelStart.data(), labelStart.size() * sizeof(unsigned int));
+		write(header.labels, labels.data(), labels.size());
+		write(header.cells, cells.data(), cells.size() * sizeof(NMSCatalogueCell));
+		if (!out)
+			throw NMSException(std::stringstream() << "Cannot write baked star catalogue [" << tempName << "].");
+	}
+	std::error_code ec;
+	std::filesystem::rename(tempName, fileName, ec);
+	if (ec)
+	{
+		std::filesystem::remove(tempName, ec);
+		throw NMSException(std::stringstream() << "Cannot write baked star catalogue [" << fileName << "].");
+	}
+}
+
+void NMSCatalogue::useOwned()
+{
+	mPositions = mOwnedPositions.data();
+	mColours = mOwnedColours.data();
+	mLabels = mOwnedLabels.data();
+	mLabelStart = mOwnedLabelStart.data();
+	mCells = nullptr;
+	mCellCount = 0;
+	mCellSize = 0.0f;
+}
+
+bool NMSCatalogue::useBaked(std::unique_ptr<MappedFile> file)
+{
+	std::string_view data = file->view();
+	if (data.size() < sizeof(BakedHeader))
+		return false;
+	BakedHeader header;
+	std::memcpy(&header, data.data(), sizeof(header));
+	if (std::memcmp(header.magic, BakedMagic, sizeof(BakedMagic)) != 0
+		|| header.version != BakedVersion)
+		return false;
+	// Each section must be aligned and inside the file.
+	auto fits = [&data](unsigned long long offset, unsigned long long bytes)
+	{
+		return offset % BakedAlignment == 0 && offset <= data.size()
+			&& bytes <= data.size() - offset;
+	};
+	if (!fits(header.positions, 3ull * header.count * sizeof(float))
+		|| !fits(header.colours, 1ull * header.count * sizeof(unsigned int))
+		|| !fits(header.labelStart, (header.count + 1ull) * sizeof(unsigned int))
+		|| !fits(header.labels, header.labelsSize)
+		|| !fits(header.cells, 1ull * header.cellCount * sizeof(NMSCatalogueCell)))
+		return false;
+	const char* base = data.data();
+	mLabelStart = reinterpret_cast<const unsigned int*>(base + header.labelStart);
+	if (mLabelStart[header.count] > header.labelsSize)
+		return false;
+	mCells = reinterpret_cast<const NMSCatalogueCell*>(base + header.cells);
+	for (unsigned int i = 0; i < header.cellCount; i++)
+	{
+		if (mCells[i].first > header.count || mCells[i].count > header.count - mCells[i].first)
+			return false;
+	}
+	mCount = header.count;
+	mScaleToWorld = header.scaleToWorld;
+	mCellSize = header.cellSize;
+	mCellCount = header.cellCount;
+	mPositions = reinterpret_cast<const float*>(base + header.positions);
+	mColours = reinterpret_cast<const unsigned int*>(base + header.colours);
+	mLabels = base + header.labels;
+	mFile = std::move(file);
+	return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <Core/MappedFile.h>
+
+// The stars [first, first + count) are in the cell x, y, z (world position
+// / cellSize rounded down).
+struct NMSCatalogueCell
+{
+	int x;
+	int y;
+	int z;
+	unsigned int first;
+	unsigned int count;
+};
+
+/*
+	The systems in an NMS map file (e.g. NMSMap.txt). Each line is
+	label, coordinates
+	where the coordinates are a signal booster, galactic or portal address,
+	or label, x, y, z. Lines starting with # are comments and the first empty
+	line ends the file.
+	The file is memory mapped and scanned in place with string_views; large
+	files are split at line ends and the pieces parsed in parallel.
+	A catalogue can be baked into a binary file (see NMSCatalogue.cpp) which
+	is loaded by mapping it and pointing into the pages, so the positions
+	and colours can go to glBufferData with no parsing or copying. Baked
+	catalogues also have the stars sorted into a grid of cells.
+	Either way the positions are all the x's then all the y's then all the
+	z's, the colours RGBA8 (red in the lowest byte) and the labels one block
+	of characters with an offset table.
+*/
+class NMSCatalogue
+{
+public:
+	NMSCatalogue() = default;
+	NMSCatalogue(NMSCatalogue&&) = default;
+	NMSCatalogue& operator=(NMSCatalogue&&) = default;
+	NMSCatalogue(const NMSCatalogue&) = delete;
+	NMSCatalogue& operator=(const NMSCatalogue&) = delete;
+
+	size_t size() const { return mCount; }
+	// 3 * size() floats
+	const float* positions() const { return mPositions; }
+	float x(size_t i) const { return mPositions[i]; }
+	float y(size_t i) const { return mPositions[mCount + i]; }
+	float z(size_t i) const { return mPositions[2 * mCount + i]; }
+	const unsigned int* colours() const { return mColours; }
+	std::string_view label(size_t i) const
+	{
+		return std::string_view(mLabels + mLabelStart[i],
+			mLabelStart[i + 1] - mLabelStart[i]);
+	}
+	float scaleToWorld() const { return mScaleToWorld; }
+	// 0 and no cells unless baked with cells.
+	float cellSize() const { return mCellSize; }
+	size_t cellCount() const { return mCellCount; }
+	const NMSCatalogueCell* cells() const { return mCells; }
+	bool baked() const { return mFile != nullptr; }
+
+	// bakedFile if it is newer than textFile and was baked with the same
+	// scaleToWorld and cellSize. Otherwise textFile is parsed and baked to
+	// bakedFile for next time. If bakedFile cannot be written the parsed
+	// catalogue is used as it is.
+	static NMSCatalogue load(const std::string& textFile,
+		const std::string& bakedFile, float scaleToWorld, float cellSize);
+	static NMSCatalogue loadText(const std::string& fileName, float scaleToWorld);
+	static NMSCatalogue loadBaked(const std::string& fileName);
+	static NMSCatalogue parse(std::string_view text, float scaleToWorld);
+	// cellSize 0 for no cells.
+	void bake(const std::string& fileName, float cellSize) const;
+private:
+	// Points the accessors at the owned vectors.
+	void useOwned();
+	// false if file is not a baked catalogue of this version.
+	bool useBaked(std::unique_ptr<MappedFile> file);
+
+	size_t mCount = 0;
+	float mScaleToWorld = 1.0f;
+	float mCellSize = 0.0f;
+	size_t mCellCount = 0;
+	const float* mPositions = nullptr;
+	const unsigned int* mColours = nullptr;
+	const char* mLabels = nullptr;
+	const unsigned int* mLabelStart = nullptr;
+	const NMSCatalogueCell* mCells = nullptr;
+	// Parsed from text. Moving a vector keeps its buffer so the pointers
+	// above stay good when the catalogue is moved.
+	std::vector<float> mOwnedPositions;
+	std::vector<unsigned int> mOwnedColours;
+	std::vector<char> mOwnedLabels;
+	std::vector<unsigned int> mOwnedLabelStart = { 0 };
+	// Baked
+	std::unique_ptr<MappedFile> mFile;
+};
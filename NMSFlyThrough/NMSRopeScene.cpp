@@ -34,16 +34,19 @@ void NMSRopeScenePhysics::setup()
 	* 9239 - Original used for testing
 	*/
 	rd->ropeData.ropeDBId = 9239;
+	rd->ropeData.construction = RCConstruction::RCSeale;
+	rd->ropeData.strands = 6;
 	rd->ropeData.numDepthLayers = 45;
+	mDepthLayers = rd->ropeData.numDepthLayers;
 	rd->ropeVisibility.ends = true;
 	rd->ropeVisibility.lines = true;
 	rd->ropeVisibility.surfaces = true;
 	rd->ropeVisibility.strandLabels = false;
 	rd->ropeVisibility.bannerLabel = false;
 	OWRopeScript* rs = new OWRopeScript(rd);
-	Rope* rope = new Rope(this->owner(), rs);
-	rope->init();
-	mCameraFocus = rope->bounds().center();
+	mRope = new Rope(this->owner(), rs);
+	mRope->init();
+	mCameraFocus = mRope->bounds().center();
 	//LightSource* ls = new LightSource(new Physical({ 160.0f, 60.0f, 50.0f }), nullptr);
 	//RendererBase* lightSource = NMS::createLightSource(glm::vec3(160.0f, 60.0f, 50.0f));
 	//RendererBase* lightSource = NMS::createLightSource(glm::vec3(60.0f, 60.0f, -150.0f));
@@ -95,8 +98,14 @@ bool NMSRopeScenePhysics::processUserCommands(const UserInput::AnyInput& userInp
 		}
 		else if (userInput.keyInput.userCommand == NMSUserInput::LogicalOperator::Special1)
 		{
-			const AABB& _world = NMSScene::world();
-			//drawRope(_world);
+			// Doubles the rings along the instanced wires up to 8 times
+			// the start, then goes back. Nothing is built again.
+			if (mRope != nullptr && mRope->constData()->ropeData.instancedWires
+				&& !mRope->constData()->ropeData.useRopeDLL)
+			{
+				unsigned int layers = mRope->depthLayers() * 2;
+				mRope->depthLayers(layers > 8 * mDepthLayers ? mDepthLayers : layers);
+			}
 			return true;
 		}
 		else if (userInput.keyInput.userCommand == NMSUserInput::LogicalOperator::OptionsScreen)
@@ -2,6 +2,8 @@
 
 #include "NMSScene.h"
 
+class Rope;
+
 /*
 	An implementation of a Scene for the NMS game.
 	Will be moved out of the engine to a different repo
@@ -22,6 +24,8 @@ struct NMSRopeScenePhysics : public ScenePhysicsState
 	void copy(ScenePhysicsState* source) override;
 	ScenePhysicsState* clone() override;
 	glm::vec3 mCameraFocus;
+	Rope* mRope = nullptr;
+	unsigned int mDepthLayers = 0;
 };
 
 class NMSRopeScene : public NMSScene
@@ -3,12 +3,16 @@
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include <climits>
 #include <regex>
 #include <random>
 #include <algorithm>
+#include <filesystem>
+#include <unordered_map>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <json/single_include/nlohmann/json.hpp>
 
@@ -19,6 +23,7 @@
 
 #include <Geometry/GeometricShapes.h>
 #include <Component/TextComponent.h>
+#include <Helpers/CellKey.h>
 
 #include <Renderers/InstanceRenderer.h>
 #include <Renderers/TextRendererStatic.h>
@@ -65,48 +70,140 @@ void NoMansSky::setUp(const std::string& fileName, const AABB& world)
 				 glm::vec3(0x7FF, 0x7F, 0x7FF));
 	float scaleNMStoWorld = world.size().x / NMSSize.size().x;
 #ifdef DEBUG_GRID
-	createGrid(NMSSize, gridSizes, scaleNMStoWorld);
-	MeshComponentLightData* mcld = &data()->nmsData.meshComponentLightData;
-	mcld->meshData.vertices(mGrid, GL_LINES, 0);
-	mcld->meshData.colour({ 0, 1.0, 0.5, 1 }, "uColour");
-	mcld->shaderData.shaderV = "Lines.v.glsl";
-	mcld->shaderData.shaderF = "Lines.f.glsl";
-	mcld->shaderData.PVMName = "pvm";
-	Shader* shader = new Shader(&mcld->shaderData);
-	MeshComponentLight* grid = new MeshComponentLight(this, mcld);
+	if (data()->nmsData.proceduralGrid)
+	{
+		// Each unique line is made in grid.v.glsl. Nothing is stored here.
+		GridComponentData* gcd = &data()->nmsData.gridComponentData;
+		gcd->box = AABB(NMSSize.minPoint() * scaleNMStoWorld,
+						NMSSize.maxPoint() * scaleNMStoWorld);
+		gcd->spacing = glm::vec3(gridSizes) * scaleNMStoWorld;
+		gcd->colour = { 0, 1.0, 0.5, 1 };
+		gcd->fadeStart = world.size().x * 0.5f;
+		gcd->fadeEnd = world.size().x * 1.5f;
+		gcd->shaderData.shaderV = "grid.v.glsl";
+		gcd->shaderData.shaderF = "grid.f.glsl";
+		gcd->shaderData.PVMName = "";
+		gcd->name = "grid";
+		GridComponent* grid = new GridComponent(this, gcd);
+	}
+	else
+	{
+		createGrid(NMSSize, gridSizes, scaleNMStoWorld);
+		MeshComponentLightData* mcld = &data()->nmsData.meshComponentLightData;
+		mcld->meshData.vertices(mGrid, GL_LINES, 0);
+		mcld->meshData.colour({ 0, 1.0, 0.5, 1 }, "uColour");
+		mcld->shaderData.shaderV = "Lines.v.glsl";
+		mcld->shaderData.shaderF = "Lines.f.glsl";
+		mcld->shaderData.PVMName = "pvm";
+		Shader* shader = new Shader(&mcld->shaderData);
+		MeshComponentLight* grid = new MeshComponentLight(this, mcld);
+	}
 #endif
 
 #ifdef DEBUG_STARS
 	loadStars(fileName, NMSSize, scaleNMStoWorld);
-	MeshComponentInstanceData* mcid = &data()->nmsData.meshComponentInstanceData;
+	StarComponentData* scd = &data()->nmsData.starComponentData;
 	mStarRadius = data()->nmsData.starRadius;
-	std::vector<glm::vec3> squareVertices =
-		GeometricShapes::star(mStarRadius.x / 5.0f, mStarRadius.x / 3.3f, 15);
+	// Only the stars near the camera are drawn with this. The rest are point sprites.
+	scd->mesh = GeometricShapes::star(mStarRadius.x / 5.0f, mStarRadius.x / 3.3f, 15);
 //		GeometricShapes::rectangle(mStarRadius * 2.0f, -mStarRadius);
-	mcid->meshData.vertices(squareVertices, GL_TRIANGLES, 0);
+	scd->nearDistance = data()->nmsData.nearStarDistance;
 
 	const int numStars = data()->nmsData.numberOfStars;
-	mRandomMinorStars = createRandomVectors(NMSSize, numStars, scaleNMStoWorld);
-	mcid->meshData.positions(mRandomMinorStars, 1, 1);
-
-	const int numColours = 4;
-	const int numColourIterations = ceil( numStars * 1.0 / numColours);
-	std::vector<glm::vec4> instanceColours;
-	for (int i = 0; i < numColourIterations; i++)
+	std::vector<glm::vec4> palette =
+	{
+		OWUtils::colour(OWUtils::SolidColours::BLUE),
+		OWUtils::colour(OWUtils::SolidColours::GREEN),
+		OWUtils::colour(OWUtils::SolidColours::YELLOW),
+		//OWUtils::colour(OWUtils::SolidColours::RED),
+		OWUtils::colour(OWUtils::SolidColours::MAGENTA)
+		//OWUtils::colour(OWUtils::SolidColours::CYAN)
+	};
+	scd->pointShaderData.shaderF = "starPoints.f.glsl";
+	scd->pointShaderData.PVMName = "";
+	scd->pointShaderData.uniforms.push_back({ ShaderDataUniforms::UniformType::UFloat,
+		"starRadius", OWUtils::to_string(mStarRadius.x / 3.3f) });
+	if (data()->nmsData.pagedStars)
+	{
+		// The same every time for a seed, with the density falling off from
+		// the centre as for createRandomVectors().
+		scd->regionSize = glm::vec3(data()->nmsData.starBlockRegions) * scaleNMStoWorld;
+		glm::vec3 blockSize = scd->regionSize;
+		glm::vec3 stddev = NMSSize.size() * scaleNMStoWorld / 6.0f;
+		GLsizei maxStars = scd->maxRegionStars;
+		int seed = data()->nmsData.starSeed;
+		// The points are quantised across the map so stars off it are dropped.
+		AABB bounds(NMSSize.minPoint() * scaleNMStoWorld, NMSSize.maxPoint() * scaleNMStoWorld);
+		scd->regionBounds = bounds;
+		scd->regionLoader = [blockSize, stddev, maxStars, seed, palette, bounds](RegionPager::Region& region)
+		{
+			std::seed_seq seq = { seed, region.key.x, region.key.y, region.key.z };
+			std::mt19937 generator(seq);
+			glm::vec3 centre = (glm::vec3(region.key) + 0.5f) * blockSize / stddev;
+			float density = std::exp(-0.5f * glm::dot(centre, centre));
+			// Far out the density underflows to 0, which poisson_distribution
+			// does not allow as a mean.
+			if (!(maxStars * density > 0.0f))
+				return;
+			std::poisson_distribution<int> counts(maxStars * density);
+			std::uniform_real_distribution<float> within(0.0f, 1.0f);
+			std::exponential_distribution<float> magnitudes(0.5f);
+			std::uniform_int_distribution<size_t> colours(0, palette.size() - 1);
+			int count = std::min(counts(generator), static_cast<int>(maxStars));
+			glm::vec3 origin = glm::vec3(region.key) * blockSize;
+			for (int i = 0; i < count; i++)
+			{
+				glm::vec3 p = origin + blockSize * glm::vec3(within(generator),
+					within(generator), within(generator));
+				if (!bounds.inside(p))
+					continue;
+				float magnitude = std::max(0.0f, 6.0f - magnitudes(generator));
+				region.stars.push_back(glm::vec4(p, magnitude));
+				region.colours.push_back(palette[colours(generator)]);
+			}
+		};
+		scd->regionLoadRadius = 3;
+		scd->regionKeepRadius = 4;
+		scd->pointShaderData.shaderV = "starPoints.v.glsl";
+	}
+	else if (data()->nmsData.proceduralStars)
+	{
+		// Made in starProcedural.v.glsl with the same distribution as
+		// createRandomVectors(). Nothing is generated or stored here.
+		scd->proceduralStars = numStars;
+		scd->proceduralSeed = data()->nmsData.starSeed;
+		scd->proceduralSpread = NMSSize.size() * scaleNMStoWorld / 6.0f;
+		scd->proceduralPalette = palette;
+		scd->pointShaderData.shaderV = "starProcedural.v.glsl";
+	}
+	else
 	{
-		instanceColours.push_back(OWUtils::colour(OWUtils::SolidColours::BLUE));
-		instanceColours.push_back(OWUtils::colour(OWUtils::SolidColours::GREEN));
-		instanceColours.push_back(OWUtils::colour(OWUtils::SolidColours::YELLOW));
-		//instanceColours.push_back(OWUtils::colour(OWUtils::SolidColours::RED));
-		instanceColours.push_back(OWUtils::colour(OWUtils::SolidColours::MAGENTA));
-		//instanceColours.push_back(OWUtils::colour(OWUtils::SolidColours::CYAN));
+		std::vector<glm::vec3> randomStars
+			= createRandomVectors(NMSSize, numStars, scaleNMStoWorld);
+		// Mostly faint stars with the odd bright one.
+		std::default_random_engine generator;
+		std::exponential_distribution<float> magnitudes(0.5f);
+		scd->stars.reserve(randomStars.size());
+		scd->colours.reserve(randomStars.size());
+		for (size_t i = 0; i < randomStars.size(); i++)
+		{
+			scd->stars.push_back(glm::vec4(randomStars[i],
+				std::max(0.0f, 6.0f - magnitudes(generator))));
+			scd->colours.push_back(palette[i % palette.size()]);
+		}
+		scd->pointShaderData.shaderV = "starPoints.v.glsl";
+		// Only the stars in view and bright enough to see reach the point pass.
+		scd->cullShaderData.shaderV = "starCull.v.glsl";
+		scd->cullShaderData.shaderG = "starCull.g.glsl";
+		scd->cullShaderData.PVMName = "";
+		scd->cullShaderData.feedbackVaryings = { "culledStar", "culledColour" };
+		scd->cullShaderData.uniforms = scd->pointShaderData.uniforms;
 	}
-	mcid->meshData.colours(instanceColours, instanceColours.size(), 2);
-	mcid->shaderData.shaderV = "instanced.v.glsl";
-	mcid->shaderData.shaderF = "glow.f.glsl";
-	mcid->shaderData.PVMName = "VP";
-	mcid->name = "stars";
-	mcid->shaderData.uniforms.push_back({ ShaderDataUniforms::UniformType::UFloat,
+	scd->meshShaderData.shaderV = "instanced.v.glsl";
+	scd->meshShaderData.shaderF = "glow.f.glsl";
+	scd->meshShaderData.PVMName = "VP";
+	scd->name = "stars";
+	scd->meshShaderData.uniforms.push_back({ ShaderDataUniforms::UniformType::UFloat,
 		"cutoffRadius", OWUtils::to_string(mStarRadius.x) });
 	glm::vec2 w = globals->physicalWindowSize();
 	auto pointRender = [w](
@@ -124,9 +221,70 @@ void NoMansSky::setUp(const std::string& fileName, const AABB& world)
 			shader->setFloat("u_time", globals->secondsSinceLoad());
 			shader->setVector2f("u_resolution", w);
 		};
-	mcid->shaderData.mutatorCallbacks.push_back(pointRender);
-	Shader* starShader = new Shader(&mcid->shaderData);
-	MeshComponentInstance* stars = new MeshComponentInstance(this, mcid);
+	scd->meshShaderData.mutatorCallbacks.push_back(pointRender);
+	StarComponent* stars = new StarComponent(this, scd);
+
+	if (mCatalogue->size() > 0)
+	{
+		StarComponentData* ccd = &data()->nmsData.catalogueComponentData;
+		ccd->pointShaderData.shaderF = "starPoints.f.glsl";
+		ccd->pointShaderData.PVMName = "";
+		ccd->pointShaderData.uniforms = scd->pointShaderData.uniforms;
+		const float magnitude = data()->nmsData.catalogueMagnitude;
+		if (data()->nmsData.pagedCatalogue && mCatalogue->cellCount() > 0)
+		{
+			// Each region is a cell of the baked file. Its systems are read
+			// from the mapped pages on the pager's thread as the camera
+			// comes near, so the catalogue is never resident as a whole.
+			// The cells also bound the systems for quantising them.
+			std::unordered_map<unsigned long long, unsigned int> cellIndex;
+			unsigned int largest = 1;
+			glm::ivec3 low(INT_MAX);
+			glm::ivec3 high(INT_MIN);
+			for (unsigned int i = 0; i < mCatalogue->cellCount(); i++)
+			{
+				const NMSCatalogueCell& c = mCatalogue->cells()[i];
+				cellIndex[CellKey::key({ c.x, c.y, c.z })] = i;
+				largest = std::max(largest, c.count);
+				low = glm::min(low, glm::ivec3(c.x, c.y, c.z));
+				high = glm::max(high, glm::ivec3(c.x, c.y, c.z));
+			}
+			ccd->regionSize = glm::vec3(mCatalogue->cellSize());
+			ccd->regionBounds = AABB(glm::vec3(low) * ccd->regionSize,
+				glm::vec3(high + 1) * ccd->regionSize);
+			ccd->maxRegionStars = static_cast<GLsizei>(largest);
+			std::shared_ptr<const NMSCatalogue> catalogue = mCatalogue;
+			ccd->regionLoader = [catalogue, cellIndex, magnitude](RegionPager::Region& region)
+			{
+				auto iter = cellIndex.find(CellKey::key(region.key));
+				if (iter == cellIndex.end())
+					return;
+				const NMSCatalogueCell& c = catalogue->cells()[iter->second];
+				region.stars.reserve(c.count);
+				region.colours.reserve(c.count);
+				for (unsigned int i = c.first; i < c.first + c.count; i++)
+				{
+					region.stars.push_back({ catalogue->x(i), catalogue->y(i),
+						catalogue->z(i), magnitude });
+					region.colours.push_back(glm::unpackUnorm4x8(catalogue->colours()[i]));
+				}
+			};
+			ccd->pointShaderData.shaderV = "starPoints.v.glsl";
+		}
+		else
+		{
+			// Uploaded straight from the catalogue, which may be the pages
+			// of the baked file.
+			ccd->catalogueStars = static_cast<GLsizei>(mCatalogue->size());
+			ccd->cataloguePositions = mCatalogue->positions();
+			ccd->catalogueColours = mCatalogue->colours();
+			ccd->pointShaderData.shaderV = "starCatalogue.v.glsl";
+			ccd->pointShaderData.uniforms.push_back({ ShaderDataUniforms::UniformType::UFloat,
+				"magnitude", OWUtils::to_string(magnitude) });
+		}
+		ccd->name = "systems";
+		StarComponent* systems = new StarComponent(this, ccd);
+	}
 #endif
 }
 
@@ -169,135 +327,32 @@ void NoMansSky::loadStars(const std::string& fileName,
 {
 	const glm::vec2 niceFontSpacing = { 0.00625f, 2 * 0.00625f };
 
-	std::string line;
-	std::ifstream myfile(fileName);
-	if (myfile.is_open())
+	// See NMSCatalogue.cpp for the file formats.
+	std::string bakedFile = std::filesystem::path(fileName)
+		.replace_extension(data()->nmsData.bakedStarExtension).string();
+	mCatalogue = std::make_shared<const NMSCatalogue>(NMSCatalogue::load(fileName,
+		bakedFile, scaleToWorld, data()->nmsData.catalogueCellRegions * scaleToWorld));
+	// Only the names that can be read are drawn. Every system in the map
+	// has been visited so there are no priorities; the nearer name wins.
+	LabelComponentData* lcd = &data()->nmsData.labelComponentData;
+	lcd->textData.tdt = TextData::TextDisplayType::Static;
+	lcd->textData.colour = { 0.0, 0.0, 0.0, 1.0f };
+	lcd->textData.fontSpacing = niceFontSpacing;
+	lcd->textData.referencePos = TextData::PositionType::Right;
+	lcd->physics.scale({ 1.0, 1.0, 1.0 });
+	lcd->anchors.reserve(mCatalogue->size());
+	for (size_t i = 0; i < mCatalogue->size(); i++)
+		lcd->anchors.push_back({ mCatalogue->x(i), mCatalogue->y(i), mCatalogue->z(i) });
+	// The names stay in the catalogue until a label is made.
+	std::shared_ptr<const NMSCatalogue> catalogue = mCatalogue;
+	lcd->labelProvider = [catalogue](unsigned int index)
 	{
-		while (getline(myfile, line))
-		{
-			if (line.size() == 0) // Test for empty line (CR?)
-				break;
-			if (line[0] == '#')
-				continue;
-			glm::vec4 point(0);
-			std::vector<std::string> elms = OWUtils::split(line, ',');
-
-			if (elms.size() == 2)
-			{
-				std::vector<std::string> coords = OWUtils::split(elms[1], ':');
-				for (auto& s : coords)
-					OWUtils::trim(s);
-				if (coords.size() == 5)
-				{
-					// Signal Booster: AAAA:XXXX:YYYY:ZZZZ:SSSS
-					// AAAA - something to do with the location on a planet's surface
-					// SSSS - is the index of the system within the galactic region. Each region is, roughly, a 400 LY cube.
-					//      - Same as Portal address System ID
-					coords.erase(coords.begin());
-				}
-
-				if (coords.size() == 4)
-				{
-					// https://nomanssky.gamepedia.com/Portal_address#Galactic_Coordinates_System
-					// Values begin at the bottom northwest corner of the chart and end at the 
-					// top southeast corner, at Delta Majoris, where it ends 
-					// at 0FFE:00FE : 0FFE : 0000
-					// format is label, galactic coords: screenX:screenY:z:w
-					// This mapping to the Game world asuming 0,0,0 is at the center.
-					__int64 x = std::stoull(coords[0], 0, 16) - 0x7FF;
-					__int64 y = std::stoull(coords[1], 0, 16) - 0x7F;
-					__int64 z = std::stoull(coords[2], 0, 16) - 0x7FF;
-					point.x = static_cast<glm::vec4::value_type>(x);
-					point.y = static_cast<glm::vec4::value_type>(y);
-					point.z = static_cast<glm::vec4::value_type>(z);
-				}
-				else if (coords.size() == 1)
-				{
-					// https://nomanssky.gamepedia.com/Portal_address#Portal_Coordinates_System
-					std::string portalNum = coords[0];
-					if (portalNum.size() == 12)
-					{
-						// Portal Coordinates can be confirmed at 
-						// https://pahefu.github.io/pilgrimstarpath/
-												
-						// format is label, PortalAddress. Comes from the 12 Glyph 
-						// characters that a Portal Terminal uses. Format is:
-						// Planet Index(1)/Solar System Index(3)/Voxel Position(8)
-						// Voxel Position x=0, y=0, z=0 is at the center.
-						//				Y Values. Y axis is height. Ranges from [01, FF)
-						// Increases from 0 to Up Pole at 7F
-						// Starts again at Down Pole at 81 increasing to FF (which is back at the center)
-						// Entering Y=80 returns Y=81.
-						//				X Values. [001, FFF]
-						// X Values have East and West Poles. They increase easterly beginning 
-						// with 0 at the center. 7FF is  the East (right) Pole
-						// Resumes with West Pole = X=801 and increasing towards the center.
-						// Entering X=800 returns X=801
-						//				Z Values. [001, FFF] (details same as X)
-						// Z values have South and North Poles. They increase southerly until
-						// z=7FF then numbering resumes from the northern pole with Z=801 and 
-						// increasing as it nears centre
-
-						// PSSSYYZZZXXX
-							
-						// P -  Planet Index in a system/ Max value == 6
-						std::string planetIndex = portalNum.substr(0, 1);
-						// SSS - Solar System Index. The address for a specific 
-						// star system within the given region. SO far the max 
-						// number of systems in a region iss 555
-						std::string solarSystemIndex = portalNum.substr(1, 3);
-
-						// x,y,z voxel positions
-						std::string sY = portalNum.substr(4, 2);
-						std::string sZ = portalNum.substr(6, 3);
-						std::string sX = portalNum.substr(9, 3);
-
-						// This mapping to the Game world asuming 0,0,0 is at the center.
-						__int64 x = std::stoull(sX, 0, 16);
-						if (x > 0x7FF)
-							x -= 0xFFF;
-
-						__int64 y = std::stoull(sY, 0, 16);
-						if (y > 0x7F)
-							y -= 0xFF;
-
-						__int64 z = std::stoull(sZ, 0, 16);
-						if (z > 0x7FF)
-							z -= 0xFFF;
-						point.x = static_cast<glm::vec4::value_type>(x);
-						point.y = static_cast<glm::vec4::value_type>(y);
-						point.z = static_cast<glm::vec4::value_type>(z);
-
-					}
-				}
-			}
-			else if (elms.size() == 4)
-			{
-				// format is label, screenX, screenY, z
-				point.x = static_cast<glm::vec4::value_type>(std::stoull(elms[1]));
-				point.y = 0;
-				point.z = static_cast<glm::vec4::value_type>(std::stoull(elms[2]));
-			}
-			point.x *= scaleToWorld;
-			point.y *= scaleToWorld;
-			point.z *= scaleToWorld;
-			point.w = 1.0;
-			TextComponentData* d = new TextComponentData();
-			d->textData.tdt = TextData::TextDisplayType::Static;
-			d->textData.text = elms[0];
-			d->textData.colour = { 0.0, 0.0, 0.0, 1.0f };
-			d->textData.fontSpacing = niceFontSpacing;
-			d->physics.scale({ 1.0, 1.0, 1.0 });
-			d->textData.referencePos = TextData::PositionType::Right;
-			TextComponent* td = new TextComponent(this, d);
-		}
-
-		myfile.close();
-	}
-	else
-	{
-		throw NMSException(std::stringstream() << "File [" << fileName << "] not loaded.");
-	}
+		return catalogue->label(index);
+	};
+	lcd->maxDistance = data()->nmsData.labelDistance;
+	lcd->maxLabels = data()->nmsData.maxLabels;
+	lcd->name = "system names";
+	LabelComponent* labels = new LabelComponent(this, lcd);
 }
 
 std::vector<glm::vec3> NoMansSky::createRandomVectors(const AABB& nmsSpace,
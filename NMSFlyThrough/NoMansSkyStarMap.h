@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -11,8 +12,13 @@
 
 #include <Actor/OWActor.h>
 #include <Component/TextComponent.h>
+#include <Component/LabelComponent.h>
 #include <Component/MeshComponentInstance.h>
+#include <Component/GridComponent.h>
 #include <Component/MeshComponentLight.h>
+#include <Component/StarComponent.h>
+
+#include "NMSCatalogue.h"
 
 class Shader;
 class TextRenderer;
@@ -32,8 +38,13 @@ struct NoMansSkyDataImp
 		OWUtils::colour(OWUtils::SolidColours::CYAN)
 	};
 	TextData textData;
-	MeshComponentInstanceData meshComponentInstanceData;
+	StarComponentData starComponentData;
+	// The systems in starFile
+	StarComponentData catalogueComponentData;
+	// Their names
+	LabelComponentData labelComponentData;
 	MeshComponentLightData meshComponentLightData;
+	GridComponentData gridComponentData;
 	ShaderData starShader;
 	std::string starFile;
 	std::string name = "NMS Map";
@@ -45,6 +56,33 @@ struct NoMansSkyDataImp
 	glm::vec2 starRadius = { 4.0, 4.0 };
 	float scaleNMStoWorld = 0.0488519780f;// world.size().x / NMSSize.size().x;
 	int numberOfStars = 500000;
+	// Stars nearer than this are drawn as star meshes, the rest as points.
+	float nearStarDistance = 5.0f;
+	// Make the stars on the GPU (the same every run for a seed). Stars
+	// made on the CPU can be culled and drawn as meshes when near.
+	bool proceduralStars = true;
+	// Make the stars a block of regions at a time on a worker thread as the
+	// camera comes near and drop them when it has gone. Takes precedence
+	// over proceduralStars. Only the stars near the camera exist, so there
+	// is no distant background, no culling and no star meshes.
+	bool pagedStars = false;
+	glm::ivec3 starBlockRegions = { 0x40, 0x10, 0x40 };
+	// Draw the grid in the shaders instead of from a list of lines.
+	bool proceduralGrid = true;
+	int starSeed = 0;
+	// starFile is baked next to itself with this extension and loaded from
+	// there until it changes.
+	std::string bakedStarExtension = ".nmsc";
+	// Size of the cells the baked systems are sorted into, in regions.
+	float catalogueCellRegions = 16.0f;
+	// Page the systems in a cell of the baked file at a time around the
+	// camera instead of uploading them all at init. Catalogues that could
+	// not be baked with cells are uploaded whole.
+	bool pagedCatalogue = true;
+	float catalogueMagnitude = 0.0f;
+	// System names further away than this are not drawn.
+	float labelDistance = 20.0f;
+	size_t maxLabels = 200;
 };
 
 struct NoMansSkyData: public OLDActorData
@@ -71,10 +109,11 @@ protected:
 class NoMansSky: public OLDActor
 {
 	glm::vec2 mStarRadius;
-	std::vector<glm::vec3> mRandomMinorStars;
 	std::vector<glm::vec4> mStarPositions;
 	std::vector<glm::vec4> mStarColours;
 	std::vector<glm::vec3> mGrid;
+	// Shared with the thread paging in the systems.
+	std::shared_ptr<const NMSCatalogue> mCatalogue;
 
 	void loadStars(const std::string& fileName, 
 				   const AABB& nmsSpace,
@@ -3,140 +3,142 @@
 #include <Core/ErrorHandling.h>
 #include <Core/LogStream.h>
 #include <Core/CommonUtils.h>
-#include <Geometry/BoundingBox.h>
 
 void PolygonBuilder::clear()
 {
 	constexpr float fmax = std::numeric_limits<float>::max();
 	constexpr float fmin = -std::numeric_limits<float>::max();
 	mMinMax = { {fmin, fmin, fmin}, {fmax, fmax, fmax} };
-	mAllPolygons = std::vector<std::vector<std::vector<glm::vec3>>>();
-	mAllSliceLabels = std::vector<SliceId>();
+	mPoints.clear();
+	mSliceStart.assign(1, 0);
+	mLayerStart.assign(1, 0);
+	mAllSliceLabels.clear();
+	mLastDepth = std::numeric_limits<float>::max();
 }
 
 void PolygonBuilder::get(RopeBuf* buffer)
 {
 	/*
-	* allWires is a vector of wires
-	* a wire is a collection of slices at various depths with z = 0.0 being first
-	* a slice is a label, a Polygon type and a vector of points.
+	* The buffer is a tree of polygon lists. Each value in a list is a depth,
+	* a Polygon type, a label and the 2D points of one wire slice. Slices
+	* with the same depth are a layer.
+	* The tree is walked once for the sizes so the arrays are allocated once,
+	* then again to copy the points straight into them.
 	*/
-	std::vector<std::vector<WireSlice>> allWires;
+	size_t slices = 0;
+	size_t points = 0;
+	count(buffer, slices, points);
+	// At most one layer a slice.
+	reserve(slices, slices, points);
+	doPopulate(buffer);
+	finish();
+}
+
+void PolygonBuilder::reserve(size_t layers, size_t slices, size_t points)
+{
+	mPoints.reserve(mPoints.size() + points);
+	mSliceStart.reserve(mSliceStart.size() + slices);
+	mLayerStart.reserve(mLayerStart.size() + layers);
+	mAllSliceLabels.reserve(mAllSliceLabels.size() + slices);
+}
+
+void PolygonBuilder::beginLayer()
+{
+	mLayerStart.push_back(mLayerStart.back());
+}
+
+std::span<glm::vec3> PolygonBuilder::addSlice(size_t count, int id)
+{
+	if (mLayerStart.size() == 1)
+		throw NMSLogicException("PolygonBuilder::addSlice before beginLayer.\n");
+	size_t first = mPoints.size();
+	mPoints.resize(first + count);
+	mSliceStart.push_back(static_cast<unsigned int>(mPoints.size()));
+	mLayerStart.back()++;
+	mAllSliceLabels.push_back({ glm::vec3(0), id });
+	return std::span<glm::vec3>(mPoints.data() + first, count);
+}
 
-	// Recursively populate allWires
-	doPopulate(buffer, allWires);
-	// Now separate the data out into two structure.
-	// One is a 2D vectors of Polygons (the second dimension contains the depth Polygons for the wire)
-	// The another is a 1D structure containing the id and id location of the first slice for each wire.
-	// 
+void PolygonBuilder::finish()
+{
+	// Every slice is labelled at its centre.
 	bool boundsFound = false;
-	for (std::vector<WireSlice>& wire: allWires)
+	for (size_t s = 0; s + 1 < mSliceStart.size(); s++)
 	{
-		std::vector<std::vector<glm::vec3>> layer;
-		for (int i = 0; i < wire.size(); i++)
+		if (mSliceStart[s] == mSliceStart[s + 1])
+			continue;
+		glm::vec3 minPoint = mPoints[mSliceStart[s]];
+		glm::vec3 maxPoint = minPoint;
+		for (unsigned int p = mSliceStart[s] + 1; p < mSliceStart[s + 1]; p++)
 		{
-			if (true)//i == 0) // Only label the first layer
-
-			{
-				AABB sliceBounds = AABB(wire[i].f);
-				SliceId si;
-				si.id = wire[i].id;
-				si.pos = sliceBounds.center();
-				mAllSliceLabels.push_back(si);
-
-				if (!boundsFound)
-				{
-					boundsFound = true;
-					mMinMax.first = sliceBounds.minPoint();
-					mMinMax.second = sliceBounds.maxPoint();
-				}
-			}
-			layer.push_back(wire[i].f);
+			minPoint = glm::min(minPoint, mPoints[p]);
+			maxPoint = glm::max(maxPoint, mPoints[p]);
+		}
+		mAllSliceLabels[s].pos = (minPoint + maxPoint) * 0.5f;
+		if (!boundsFound)
+		{
+			boundsFound = true;
+			mMinMax = { minPoint, maxPoint };
+		}
+		else
+		{
+			mMinMax.first = glm::min(mMinMax.first, minPoint);
+			mMinMax.second = glm::max(mMinMax.second, maxPoint);
 		}
-		mAllPolygons.push_back(layer);
 	}
 }
 
-// floatBuf contains 2D points
-void getPoints(std::vector<glm::vec3>& ff, RopeBuf* floatBuf, float zdepth)
+// The buffer structure is determined by rope.cs
+void PolygonBuilder::count(RopeBuf* buffer, size_t& slices, size_t& points) const
 {
-	int numFloats = (int)(*floatBuf++);
-
-	// Get the pointer to numFloats of float pairs
-	float* f = (float*)(floatBuf);
-	for (int i = 0; i < numFloats; i += 2)
+	RopeBuf* p = buffer;
+	int numPolys = *((int*)(p++));
+	p++; // jfw
+	for (int i = 0; i < numPolys; i++)
+		count((RopeBuf*)(*p++), slices, points);
+	int numValues = (int)(*p++);
+	for (int i = 0; i < numValues; i++)
 	{
-		float x = *f++;
-		float y = *f++;
-		float z = zdepth * 10;
-		ff.push_back({ x, y, z });
+		p++; // zdepth
+		RopeBuf* pf = (RopeBuf*)(*p++);
+		points += static_cast<size_t>(*pf) / 2;
+		p += 2; // Polygon type and id
+		slices++;
 	}
 }
 
-bool found701 = false;
-
-// The buffer structure is determined by rope.cs
-void PolygonBuilder::doPopulate(RopeBuf* buffer, std::vector<std::vector<WireSlice>>& allWires)
+void PolygonBuilder::doPopulate(RopeBuf* buffer)
 {
 	RopeBuf* p = buffer;
 	int numPolys = *((int*)(p++));
-	int jfw = *((int*)(p++)); // needed to extract debug var in C# RCPolygonBuilder.getMemory()
+	p++; // jfw, needed to extract debug var in C# RCPolygonBuilder.getMemory()
 	for (int i = 0; i < numPolys; i++)
 	{
 		RopeBuf* elm = (RopeBuf*)(*p++);
-		doPopulate(elm, allWires); // Recurse into the data structure
+		doPopulate(elm); // Recurse into the data structure
 	}
 
-	if (found701)
-		return;
 	int numValues = (int)(*p++);
 	for (int i = 0; i < numValues; i++)
 	{
 		float zdepth = *((float*)p++);
 		RopeBuf* pf = (RopeBuf*)(*p++);
-		std::vector<glm::vec3> points;
-		getPoints(points, pf, zdepth);
-		PolyType pt = (PolyType)(*p++);
+		p++; // Polygon type
 		int id = (int)(*p++);
-
-		//		if (!((id == 2055) || (id == 2002) || (id == 1000) || (id == 0)))
-		//			continue;
-		//if (!(id == 2056)) // complex rope
-		//	continue;
-		//if (!(id == 1001)) // simple rope
-		//	continue;
-		//found701 = true;
-		WireSlice vt(points, pt, id);
-		static float zOldDepth = std::numeric_limits<float>::max();
-		if (zdepth != zOldDepth)
+		if (zdepth != mLastDepth)
 		{
-			zOldDepth = zdepth;
-			std::vector<WireSlice> temp;
-			temp.push_back(vt);
-			allWires.push_back(temp);
+			mLastDepth = zdepth;
+			beginLayer();
 		}
-		else
+		// pf is the number of floats then the 2D points.
+		int numFloats = (int)(*pf++);
+		const float* f = (const float*)(pf);
+		for (glm::vec3& pt : addSlice(numFloats / 2, id))
 		{
-			allWires.back().push_back(vt);
+			pt.x = *f++;
+			pt.y = *f++;
+			pt.z = zdepth * 10;
 		}
-		/*
-		if (OWUtils::isEqual(zdepth, 0))
-		{
-			// The zero depth element is always the first polygon for a new wire
-			std::vector<WireSlice> temp;
-			temp.push_back(vt);
-			allWires.push_back(temp);
-		}
-		else
-		{
-			if (!allWires.size())
-				throw NMSException(std::stringstream()
-					<< "PolygonBuilder::doPopulate. "
-					<< "Did not expect empty allWires with non zero depth. zdepth was["
-					<< zdepth << "].\n");
-			allWires.back().push_back(vt);
-		}
-*/
 	}
 }
 
@@ -153,4 +155,3 @@ void PolygonBuilder::foreach(foreachPolyBuilder OW_UNUSED(fe))
 	}
 */
 }
-
@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include <limits>
+#include <span>
 #include <glm/glm.hpp>
 
 typedef std::uintptr_t RopeBuf;
@@ -9,6 +10,17 @@ typedef std::uintptr_t RopeBuf;
 class PolygonBuilder;
 typedef int (*foreachPolyBuilder) (PolygonBuilder&, std::vector<std::vector<glm::vec3>>&);
 
+/*
+	The wire cross sections of a rope, one layer of slices for each depth
+	with the wires in the same order in every layer.
+	Everything is in flat arrays: all the points in one buffer, the start
+	of each slice in that and the first slice of each layer. slice()
+	returns a span into the points so nothing is copied to read them.
+	get() fills them from the rope DLL buffer in one pass after sizing
+	them from the buffer's headers, and calcNativeRope() with
+	beginLayer() and addSlice(), so filling takes a fixed number of
+	allocations however many points there are.
+*/
 class PolygonBuilder
 {
 public:
@@ -21,34 +33,59 @@ public:
 	{
 		RCProduct, RCLayer, RCWire, RCNonWire, RCUnknown
 	};
-	struct WireSlice
-	{
-		WireSlice(const std::vector<glm::vec3>& _f, PolyType _pt, int _id)
-			: f(_f), p(_pt), id(_id)
-		{
-		}
-		std::vector<glm::vec3> f;
-		PolyType p;
-		int id;
-	};
 private:
-	/*
-	* PolygonBuilder contains a vector of PolygonBuilder. This actuarately reflects
-	* the Rope structure passed back
-	*/
 	std::pair<glm::vec3, glm::vec3> mMinMax;
-	std::vector<std::vector<std::vector<glm::vec3>>> mAllPolygons;
+	std::vector<glm::vec3> mPoints;
+	// Into mPoints, one more than the number of slices.
+	std::vector<unsigned int> mSliceStart;
+	// Into mSliceStart, one more than the number of layers.
+	std::vector<unsigned int> mLayerStart;
 	std::vector<SliceId> mAllSliceLabels;
+	// Of the last slice from the DLL buffer. A new depth starts a new layer.
+	float mLastDepth = std::numeric_limits<float>::max();
 	void clear();
-	void doPopulate(RopeBuf* buffer, std::vector<std::vector<WireSlice>>& allWires);
+	void count(RopeBuf* buffer, size_t& slices, size_t& points) const;
+	void doPopulate(RopeBuf* buffer);
 public:
+	PolygonBuilder()
+	{
+		clear();
+	}
 	virtual ~PolygonBuilder()
 	{
 		clear();
 	}
+	// From the rope DLL
 	void get(RopeBuf* buffer);
+
+	// To fill it in directly. Call reserve(), then beginLayer() for each
+	// depth and addSlice() for each wire in it, then finish().
+	void reserve(size_t layers, size_t slices, size_t points);
+	void beginLayer();
+	// The count points of a new slice of the current layer, to be filled in.
+	std::span<glm::vec3> addSlice(size_t count, int id);
+	// Makes the labels and bounds.
+	void finish();
+
 	void foreach(foreachPolyBuilder fe);
-	const std::vector<SliceId>& labels() { return mAllSliceLabels; }
-	std::vector<std::vector<std::vector<glm::vec3>>>& slices() { return mAllPolygons; }
-	std::pair<glm::vec3, glm::vec3> bounds() { return mMinMax; }
+	const std::vector<SliceId>& labels() const { return mAllSliceLabels; }
+	size_t layerCount() const { return mLayerStart.size() - 1; }
+	size_t wireCount(size_t layer) const
+	{
+		return mLayerStart[layer + 1] - mLayerStart[layer];
+	}
+	std::span<const glm::vec3> slice(size_t layer, size_t wire) const
+	{
+		size_t s = mLayerStart[layer] + wire;
+		return std::span<const glm::vec3>(mPoints.data() + mSliceStart[s],
+			mSliceStart[s + 1] - mSliceStart[s]);
+	}
+	// Where slice(layer, wire) starts in points()
+	size_t sliceOffset(size_t layer, size_t wire) const
+	{
+		return mSliceStart[mLayerStart[layer] + wire];
+	}
+	// Every point of every slice
+	std::span<const glm::vec3> points() const { return mPoints; }
+	std::pair<glm::vec3, glm::vec3> bounds() const { return mMinMax; }
 };
@@ -3,20 +3,20 @@
 
 #include <Helpers/ShaderFactory.h>
 #include <Helpers/MeshDataLight.h>
+#include <Helpers/MeshOptimiser.h>
 #include <Renderers/VAOBuffer.h>
 
 #include <Component/MeshComponentVAO.h>
+#include <Component/HelixWireComponent.h>
+#include <Core/LogStream.h>
+#if _WIN32 || _WIN64
 #include "./../NMSFlyThrough/rope_interface_test.h"
 #include "./../NMSFlyThrough/rope_quick.h"
+#endif
 #include "RopeNormaliser.h"
+#include "rope_native.h"
 
 
-bool initTestFunctions();
-bool testConstructionSet();
-bool testEnums();
-bool testLibraryName();
-bool runImportTests();
-
 
 static bool mRopeDLLOk = false;
 static std::string gRopeEnds = "RopeEnds";
@@ -34,11 +34,17 @@ void Rope::doInit()
 		return; //fail to init DLL
 	const OWRopeDataImp* rd = &constData()->ropeData;
 	const TextComponentData* tcd = &constData()->labelTextData;
-	prepareRope(rd->ropeDBId, rd->ropeZoom.x, rd->ropeZoom.y, rd->numDepthLayers);
+	if (rd->useRopeDLL)
+		prepareRope(rd->ropeDBId, rd->ropeZoom.x, rd->ropeZoom.y, rd->numDepthLayers);
+	else
+		prepareNativeRope(*rd);
 	prepareText(tcd->textData.fontHeight, tcd->textData.fontSpacing, tcd->physics.scale());
-	createRopeLines(mPolyBuilder->slices());
-	createRopeSurfaces(mPolyBuilder->slices());
-	createRopeEnds(mPolyBuilder->slices());
+	createRopeLines(*mPolyBuilder);
+	if (!rd->useRopeDLL && rd->instancedWires)
+		createRopeInstancedSurfaces(*rd);
+	else
+		createRopeSurfaces(*mPolyBuilder);
+	createRopeEnds(*mPolyBuilder);
 	const OWRopeVisibilityData* vd = &constData()->ropeVisibility;
 	prepareVisibility(vd->ends, vd->lines, vd->surfaces, vd->strandLabels, vd->bannerLabel);
 	OLDActor::doInit();
@@ -118,6 +124,11 @@ void Rope::prepareVisibility(bool _ends, bool _lines, bool _surfaces, bool _stra
 
 bool Rope::prepare()
 {
+	if (!constData()->ropeData.useRopeDLL)
+	{
+		name("Ropes");
+		return true;
+	}
 	if (!mRopeDLLOk)
 		mRopeDLLOk = initRopes();
 	return mRopeDLLOk;
@@ -126,21 +137,56 @@ bool Rope::prepare()
 bool Rope::initRopes()
 {
 	name("Ropes");
+#if _WIN32 || _WIN64
 	bool ok = initInterfaceUtils() && initTestFunctions() && initQuickExterns();
 	if (ok)
 	{
 		ok = runImportTests();
 	}
 	return ok;
+#else
+	LogStream(LogStreamLevel::Warning) << "The rope DLL is only on Windows. "
+		<< "Set useRopeDLL to false to build ropes natively.\n";
+	return false;
+#endif
 }
 
-void Rope::prepareRope(int ropeNum, float width, float height, int numDepthLayers)
+void Rope::prepareRope([[maybe_unused]] int ropeNum, [[maybe_unused]] float width,
+	[[maybe_unused]] float height, [[maybe_unused]] int numDepthLayers)
 {
+#if _WIN32 || _WIN64
 	RopeBuf* pointSourceBuffer = calcQuickRope(ropeNum, width, height, numDepthLayers);
 	mPolyBuilder = new PolygonBuilder();
 	mPolyBuilder->get(pointSourceBuffer);
 	std::pair<glm::vec3, glm::vec3> b = mPolyBuilder->bounds();
 	mBounds = AABB(b.first, b.second);
+#else
+	throw NMSLogicException("Rope::prepareRope needs the Windows rope DLL.\n");
+#endif
+}
+
+static NativeRopeData nativeRopeData(const OWRopeDataImp& rd)
+{
+	NativeRopeData nrd;
+	nrd.construction = rd.construction;
+	nrd.strands = rd.strands;
+	// The rope DLL fits the cross section into ropeZoom.
+	nrd.diameter = std::min(rd.ropeZoom.x, rd.ropeZoom.y);
+	nrd.numDepthLayers = rd.numDepthLayers;
+	return nrd;
+}
+
+void Rope::prepareNativeRope(const OWRopeDataImp& rd)
+{
+	mPolyBuilder = new PolygonBuilder();
+	NativeRopeData nrd = nativeRopeData(rd);
+	// The instanced surfaces need no slices. The ends, labels and bounds
+	// only need the two ends, the lines all the depth.
+	if (rd.instancedWires && !constData()->ropeVisibility.lines)
+		nrd.numDepthLayers = 2;
+	calcNativeRope(nrd, *mPolyBuilder);
+	std::pair<glm::vec3, glm::vec3> b = mPolyBuilder->bounds();
+	mBounds = AABB(b.first, b.second);
 }
 
 void Rope::prepareText(int fontHeight, const glm::vec2& textSpacing, const glm::vec2& textScale)
@@ -181,25 +227,20 @@ void Rope::makeLabels(const glm::vec2& textSpacing, const glm::vec2& textScale)
 }
 
 
-OLDSceneComponent* Rope::createRopeEnds(std::vector<std::vector<std::vector<glm::vec3>>>& threeDWires)
+OLDSceneComponent* Rope::createRopeEnds(const PolygonBuilder& wires)
 {
 	MeshComponentVAOData* mvd = new MeshComponentVAOData();
 	mvd->shaderData.PVMName = "pvm";
 	mvd->meshData = VAOBuffer(new Shader(&mvd->shaderData), VAOBuffer::DRAW_MULTI);
 
-	// Prepare the wire cross sections
-	std::vector<glm::vec3> coords;
-	for (auto& slice : threeDWires)
+	// Prepare the wire cross sections of the first layer
+	for (size_t eachWire = 0; eachWire < wires.wireCount(0); eachWire++)
 	{
-		for (auto& polygon : slice)
-		{
-			MeshDataLight lineData;
-			glm::vec4 colour = data()->ropeData.colour;
-			lineData.colour(colour, "colour");
-			lineData.vertices(polygon, GL_LINE_LOOP);
-			mvd->meshData.add(&lineData);
-		}
-		break;
+		MeshDataLight lineData;
+		glm::vec4 colour = data()->ropeData.colour;
+		lineData.colour(colour, "colour");
+		lineData.vertices(wires.slice(0, eachWire), GL_LINE_LOOP);
+		mvd->meshData.add(&lineData);
 	}
 	mvd->name = gRopeEnds;
 	mvd->boundingBox.render(false);
@@ -208,7 +249,7 @@ OLDSceneComponent* Rope::createRopeEnds(std::vector<std::vector<std::vector<glm:
 	return m;
 }
 
-OLDSceneComponent* Rope::createRopeLines(std::vector<std::vector<std::vector<glm::vec3>>>& threeDWires)
+OLDSceneComponent* Rope::createRopeLines(const PolygonBuilder& wires)
 {
 	MeshComponentVAOData* mvd = new MeshComponentVAOData();
 	mvd->shaderData.PVMName = "pvm";
@@ -219,9 +260,9 @@ OLDSceneComponent* Rope::createRopeLines(std::vector<std::vector<std::vector<glm
 	bool drawCenters = false;
 	bool drawLines = true;
 
-	size_t numLayers = threeDWires.size();
-	size_t numWiresInEachLayer = threeDWires[0].size();
-	size_t numPointsPerSlice = threeDWires[0][0].size() + 10;
+	size_t numLayers = wires.layerCount();
+	size_t numWiresInEachLayer = wires.wireCount(0);
+	size_t numPointsPerSlice = wires.slice(0, 0).size() + 10;
 	std::vector< std::vector<glm::vec3>> ropeLines;
 	std::vector< std::vector<glm::vec3>> surfaces;
 	for (size_t eachWire = 0; eachWire < numWiresInEachLayer; eachWire++)
@@ -231,8 +272,15 @@ OLDSceneComponent* Rope::createRopeLines(std::vector<std::vector<std::vector<glm
 			std::vector<glm::vec3> line;
 			for (int layer = 0; layer < numLayers; layer++)
 			{
-				std::vector<glm::vec3>& slice = threeDWires[layer][eachWire];
-				line.push_back(AABB(slice).center());
+				std::span<const glm::vec3> slice = wires.slice(layer, eachWire);
+				glm::vec3 minPoint = slice[0];
+				glm::vec3 maxPoint = slice[0];
+				for (const glm::vec3& pt : slice)
+				{
+					minPoint = glm::min(minPoint, pt);
+					maxPoint = glm::max(maxPoint, pt);
+				}
+				line.push_back((minPoint + maxPoint) * 0.5f);
 			}
 			ropeLines.push_back(line);
 		}
@@ -243,9 +291,10 @@ OLDSceneComponent* Rope::createRopeLines(std::vector<std::vector<std::vector<glm
 				std::vector<glm::vec3> line;
 				for (int layer = 0; layer < numLayers; layer++)
 				{
-					if (pointOnPoly < threeDWires[layer][eachWire].size())
+					std::span<const glm::vec3> slice = wires.slice(layer, eachWire);
+					if (pointOnPoly < slice.size())
 					{
-						glm::vec3 pt = threeDWires[layer][eachWire][pointOnPoly];
+						glm::vec3 pt = slice[pointOnPoly];
 						line.push_back(pt);
 					}
 				}
@@ -271,7 +320,7 @@ OLDSceneComponent* Rope::createRopeLines(std::vector<std::vector<std::vector<glm
 	return m;
 }
 
-glm::vec3 centerOfPolygon(const std::vector<glm::vec3>& polygon)
+glm::vec3 centerOfPolygon(std::span<const glm::vec3> polygon)
 {
 	glm::vec3 firstPolyCoord = polygon[0];
 	glm::vec3 oppositePolyCoord = polygon[polygon.size() / 2];
@@ -279,13 +328,13 @@ glm::vec3 centerOfPolygon(const std::vector<glm::vec3>& polygon)
 	return midpoint;
 }
 
-static unsigned int safeWrap(const std::vector<unsigned int>& vv, size_t ndx)
+static unsigned int safeWrap(std::span<const unsigned int> vv, size_t ndx)
 {
 	int i = static_cast<int>(ndx) - static_cast<int>(vv.size());
 	return i < 0 ? vv[ndx] : vv[i];
 }
 
-OLDSceneComponent* Rope::createRopeSurfaces(std::vector<std::vector<std::vector<glm::vec3>>>& threeDWires)
+OLDSceneComponent* Rope::createRopeSurfaces(const PolygonBuilder& wires)
 {
 	MeshComponentVAOData* mvd = new MeshComponentVAOData();
 	mvd->shaderData.shaderV = "Wires.v.glsl";
@@ -309,39 +358,38 @@ OLDSceneComponent* Rope::createRopeSurfaces(std::vector<std::vector<std::vector<
 		};
 	mvd->shaderData.mutatorCallbacks.push_back(pointRender);
 	Shader* wireShader = new Shader(&mvd->shaderData);
-	mvd->meshData = VAOBuffer(wireShader, VAOBuffer::DRAW_ARRAYS);
+	mvd->meshData = VAOBuffer(wireShader, VAOBuffer::DRAW_MULTI_INDEXED);
+	mvd->meshData.vertexFormat(VAOBuffer::COMPACT);
 
 	// Prepare the wire cross sections
-	size_t numLayers = threeDWires.size();
+	size_t numLayers = wires.layerCount();
 
 	// The number of wires for each layer is the same
-	size_t numWires = threeDWires[0].size();
+	size_t numWires = wires.wireCount(0);
 	// This holds the points that go to the gpu
 	std::vector<glm::vec3> triAnglePoints;
+	triAnglePoints.reserve((wires.points().size() + 2 * numWires) * 2);
 
 	/*
-	* For each wire mirror the structure of threeDWires, but populate
-	* with the indices of the corresponding point pushed back into triAnglePoints.
+	* For each point of wires the index of the corresponding point pushed
+	* back into triAnglePoints, laid out as wires.points() so a slice's
+	* indices start at wires.sliceOffset().
 	*/
-	std::vector<std::vector<std::vector<unsigned int>>> tempWireIndices(threeDWires.size());
-	for (int i = 0; i < threeDWires.size(); i++)
+	std::span<const glm::vec3> allPoints = wires.points();
+	std::vector<unsigned int> pointIndices(allPoints.size());
+	for (size_t i = 0; i < allPoints.size(); i++)
+		pointIndices[i] = RopeNormaliser::append(triAnglePoints, allPoints[i]);
+	auto sliceIndices = [&wires, &pointIndices](size_t layer, size_t wire)
 	{
-		tempWireIndices[i] = std::vector<std::vector<unsigned int>>(threeDWires[i].size());
-		for (int j = 0; j < threeDWires[i].size(); j++)
-		{
-			tempWireIndices[i][j] = std::vector<unsigned int>(threeDWires[i][j].size());
-			for (unsigned int pointOnPoly = 0; pointOnPoly < threeDWires[i][j].size(); pointOnPoly++)
-			{
-				unsigned int ndx = RopeNormaliser::append(triAnglePoints, threeDWires[i][j][pointOnPoly]);
-				tempWireIndices[i][j][pointOnPoly] = ndx;
-			}
-		}
-	}
+		return std::span<const unsigned int>(
+			pointIndices.data() + wires.sliceOffset(layer, wire),
+			wires.slice(layer, wire).size());
+	};
 
 	// Remember the centroid of each wire end so we can draw triangles on the ends.
 	std::vector<std::vector<unsigned int>> centroidIndex(numWires, std::vector<unsigned int>(2, 0));
 	// Populate the indice vectors
-	for (int eachWire = 0; eachWire < threeDWires[0].size(); eachWire++)
+	for (int eachWire = 0; eachWire < numWires; eachWire++)
 	{
 		/*
 		* Find the rough centroids of the first and last polygon slices
@@ -349,20 +397,23 @@ OLDSceneComponent* Rope::createRopeSurfaces(std::vector<std::vector<std::vector<
 		* triangulate the surfaces of the end points.
 		*/
 		centroidIndex[eachWire][0] = RopeNormaliser::append(triAnglePoints,
-			centerOfPolygon(threeDWires[0][eachWire]));
+			centerOfPolygon(wires.slice(0, eachWire)));
 
 		// Center of the bottom slice
 		centroidIndex[eachWire][1] = RopeNormaliser::append(triAnglePoints,
-			centerOfPolygon(threeDWires[numLayers - 1][eachWire]));
+			centerOfPolygon(wires.slice(numLayers - 1, eachWire)));
 	}
 
-	RopeNormaliser rn(&triAnglePoints);
+	RopeNormaliser rn;
 	// Now build the triangles
-	for (int eachWire = 0; eachWire < tempWireIndices[0].size(); eachWire++)
+	for (int eachWire = 0; eachWire < numWires; eachWire++)
 	{
 		for (int layer = 0; layer < numLayers; layer++)
 		{
-			size_t polySize = tempWireIndices[layer][eachWire].size();
+			std::span<const unsigned int> poly = sliceIndices(layer, eachWire);
+			std::span<const unsigned int> nextPoly = layer < (numLayers - 1)
+				? sliceIndices(layer + 1, eachWire) : poly;
+			size_t polySize = poly.size();
 			for (size_t pointOnPoly = 0; pointOnPoly < polySize; pointOnPoly++)
 			{
 				if (layer < (numLayers - 1))
@@ -372,33 +423,33 @@ OLDSceneComponent* Rope::createRopeSurfaces(std::vector<std::vector<std::vector<
 						// Form a triangle on the flat surface of the endpoint
 						rn.appendTriangle(
 							centroidIndex[eachWire][0],
-							safeWrap(tempWireIndices[layer][eachWire], pointOnPoly),
-							safeWrap(tempWireIndices[layer][eachWire], pointOnPoly + 1));
+							safeWrap(poly, pointOnPoly),
+							safeWrap(poly, pointOnPoly + 1));
 					}
 					// Now for the triangles down the side of the wire
 					rn.appendTriangle(
-						safeWrap(tempWireIndices[layer][eachWire], pointOnPoly + 1),
-						safeWrap(tempWireIndices[layer][eachWire], pointOnPoly),
-						safeWrap(tempWireIndices[layer + 1][eachWire], pointOnPoly));
+						safeWrap(poly, pointOnPoly + 1),
+						safeWrap(poly, pointOnPoly),
+						safeWrap(nextPoly, pointOnPoly));
 
 					rn.appendTriangle(
-						safeWrap(tempWireIndices[layer][eachWire], pointOnPoly + 1),
-						safeWrap(tempWireIndices[layer + 1][eachWire], pointOnPoly),
-						safeWrap(tempWireIndices[layer + 1][eachWire], pointOnPoly + 1));
+						safeWrap(poly, pointOnPoly + 1),
+						safeWrap(nextPoly, pointOnPoly),
+						safeWrap(nextPoly, pointOnPoly + 1));
 
 					// The next layers polygon may have more points than this layer.
 					// If we are the last point in this layer and the next layer has 
 					// more points then fill the gaps.
 					if ((pointOnPoly + 1 == polySize) &&
-						(pointOnPoly + 1 < tempWireIndices[layer + 1][eachWire].size()))
+						(pointOnPoly + 1 < nextPoly.size()))
 					{
 						size_t a = pointOnPoly + 1;
-						while (a < tempWireIndices[layer + 1][eachWire].size())
+						while (a < nextPoly.size())
 						{
 							rn.appendTriangle(
-								safeWrap(tempWireIndices[layer + 1][eachWire], a + 1),
-								safeWrap(tempWireIndices[layer][eachWire], pointOnPoly + 1),
-								safeWrap(tempWireIndices[layer + 1][eachWire], a));
+								safeWrap(nextPoly, a + 1),
+								safeWrap(poly, pointOnPoly + 1),
+								safeWrap(nextPoly, a));
 							a++;
 						}
 					}
@@ -407,9 +458,8 @@ OLDSceneComponent* Rope::createRopeSurfaces(std::vector<std::vector<std::vector<
 				{
 					// Now form triangles on the flat surface of the end of the wire.
 					rn.appendTriangle(
-						safeWrap(
-							tempWireIndices[layer][eachWire], pointOnPoly + 1),
-						tempWireIndices[layer][eachWire][pointOnPoly],
+						safeWrap(poly, pointOnPoly + 1),
+						poly[pointOnPoly],
 						centroidIndex[eachWire][1]);
 
 				}
@@ -422,6 +472,7 @@ OLDSceneComponent* Rope::createRopeSurfaces(std::vector<std::vector<std::vector<
 	MeshDataLight lineData;
 	lineData.vertices(triAnglePoints, GL_TRIANGLES);
 	lineData.indices(rn.mIndexBuffer, GL_TRIANGLES);
+	MeshOptimiser::optimise(lineData, true);
 	lineData.polygonMode(GL_FILL);
 	//lineData.polygonMode(GL_LINE);
 	mvd->meshData.add(&lineData);
@@ -431,3 +482,51 @@ OLDSceneComponent* Rope::createRopeSurfaces(std::vector<std::vector<std::vector<
 	m->init();
 	return m;
 }
+
+OLDSceneComponent* Rope::createRopeInstancedSurfaces(const OWRopeDataImp& rd)
+{
+	HelixWireComponentData* hwd = new HelixWireComponentData();
+	hwd->shaderData.shaderV = "helixWire.v.glsl";
+	hwd->shaderData.shaderF = "Wires.f.glsl";
+	hwd->shaderData.projectionName = "projection";
+	hwd->shaderData.viewName = "view";
+	hwd->shaderData.modelName = "model";
+	auto pointRender = [](
+		const glm::mat4& OW_UNUSED(proj),
+		const glm::mat4& OW_UNUSED(view),
+		const glm::mat4& OW_UNUSED(model),
+		const glm::vec3& OW_UNUSED(cameraPos),
+		const Shader* shader)
+		{
+			shader->use();
+			shader->setVector4f("lightColor", OWUtils::colour(OWUtils::SolidColours::WHITE));
+			shader->setVector4f("objectColor", glm::vec4(0.90f, 0.91f, 0.98f, 1.0f)); // silver
+			shader->setVector3f("viewLightPos", glm::vec3(160.0f, 60.0f, 50.0f));
+		};
+	hwd->shaderData.mutatorCallbacks.push_back(pointRender);
+
+	// The same wires as the mesh would have, but 32 bytes each.
+	NativeRopeData nrd = nativeRopeData(rd);
+	hwd->length = calcNativeWires(nrd, hwd->wires);
+	hwd->rings = nrd.numDepthLayers;
+	hwd->pointsPerWire = nrd.pointsPerWire;
+	hwd->name = gRopeSurfaces;
+	hwd->boundingBox = mBounds;
+	hwd->boundingBox.render(false);
+	mHelixWires = new HelixWireComponent(this, hwd);
+	mHelixWires->init();
+	return mHelixWires;
+}
+
+void Rope::depthLayers(unsigned int layers)
+{
+	if (mHelixWires == nullptr)
+		throw NMSLogicException("Rope::depthLayers() needs instancedWires.\n");
+	mHelixWires->rings(layers);
+}
+
+unsigned int Rope::depthLayers() const
+{
+	return mHelixWires != nullptr ? mHelixWires->rings()
+		: constData()->ropeData.numDepthLayers;
+}
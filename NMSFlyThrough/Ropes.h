@@ -6,9 +6,21 @@
 #include <Helpers/Shader.h>
 #include <Component/TextComponent.h>
 #include "PolygonBuilder.h"
+#include "rope_native.h"
 
 struct OWRopeDataImp
 {
+	// Built by calcNativeRope() unless useRopeDLL, in which case ropeDBId
+	// is drawn by the Windows rope DLL.
+	bool useRopeDLL = false;
+	RCConstruction construction = RCConstruction::RCSeale;
+	unsigned int strands = 6;
+	// Native ropes only. The surfaces are drawn as instanced helices by the
+	// HelixWireRenderer instead of as a mesh. numDepthLayers is then the
+	// rings of the surfaces, which Rope::depthLayers() can change later.
+	// The slices are only made in depth for the lines; without them just
+	// the two ends are made, for the ends and labels.
+	bool instancedWires = true;
 	unsigned int ropeDBId;
 	glm::vec2 ropeZoom;
 	unsigned int numDepthLayers = 30;
@@ -41,11 +53,14 @@ public:
 };
 
 class OLDSceneComponent;
+class HelixWireComponent;
 class Rope: public OLDActor
 {
 private:
 	bool initRopes();
 	PolygonBuilder* mPolyBuilder = nullptr;
+	// With instancedWires
+	HelixWireComponent* mHelixWires = nullptr;
 	
 	std::pair<glm::vec3, glm::vec3> mMinMax = GeometricShapes::minMaxBox;
 	AABB mBounds;
@@ -58,6 +73,10 @@ protected:
 public:
 	Rope(Scene* _scene, OWRopeScript* _script);
 	const AABB& bounds() const { return mBounds; }
+	// Only for ropes with instancedWires. The others are meshes which
+	// would have to be built again.
+	void depthLayers(unsigned int layers);
+	unsigned int depthLayers() const;
 	const OWRopeData* constData() const
 	{
 		return dynamic_cast<const OWRopeData*>(script()->data());
@@ -65,6 +84,7 @@ public:
 private:
 	bool prepare();
 	void prepareRope(int ropeNum, float width, float height, int numDepthLayers);
+	void prepareNativeRope(const OWRopeDataImp& rd);
 	void prepareText(int fontHeight, const glm::vec2& textSpacing, const glm::vec2& textScale);
 	void prepareVisibility(bool _ends, bool _lines, bool _surfaces, bool _strandLabels, bool _bannerLabel);
 	void makeBanner(const std::string& s, int height,
@@ -72,9 +92,10 @@ private:
 		const std::string& f = "arial.ttf",
 		const glm::vec4& col = { 0.0, 0.0, 0.0, 1.0f });
 	void makeLabels(const glm::vec2& textSpacing = { 0,0 }, const glm::vec2& textScale = { 0,0 });
-	OLDSceneComponent* createRopeEnds(std::vector<std::vector<std::vector<glm::vec3>>>& threeDWires);
-	OLDSceneComponent* createRopeLines(std::vector<std::vector<std::vector<glm::vec3>>>& threeDWires);
-	OLDSceneComponent* createRopeSurfaces(std::vector<std::vector<std::vector<glm::vec3>>>& threeDWires);
+	OLDSceneComponent* createRopeEnds(const PolygonBuilder& wires);
+	OLDSceneComponent* createRopeLines(const PolygonBuilder& wires);
+	OLDSceneComponent* createRopeSurfaces(const PolygonBuilder& wires);
+	OLDSceneComponent* createRopeInstancedSurfaces(const OWRopeDataImp& rd);
 	bool mLines = true;
 	bool mSurfaces = true;
 	bool mEnds = true;
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <experimental/filesystem>
 
+#include <Core/Benchmark.h>
 #include <Core/GLApplication.h>
 #include <Core/GlobalSettings.h>
 #include <Core/SaveAndRestore.h>
@@ -69,8 +70,11 @@ extern OWENGINE_API GlobalSettings* globals;
 */
 int main(int argc, char* argv[])
 {
+	// --benchmark runs headless and exits. See BenchmarkSettings.
+	BenchmarkSettings benchmark;
 	try
 	{
+		Benchmark::fromCommandLine(argc, argv, benchmark);
 		std::filesystem::path exePath;
 		if (argc)
 		{
@@ -96,6 +100,8 @@ int main(int argc, char* argv[])
 
 		globals->loadSettings(exePath);
 		GLApplication app(&ui);
+		if (benchmark.enabled)
+			app.benchmark(&benchmark);
 		NMSMovie nms(&camera, &logger);
 		globals->configAndSet(&sr, &nms, &recorder,
 							&logger, &camera, &app);
@@ -105,6 +111,11 @@ int main(int argc, char* argv[])
 	catch (const std::exception& e)
 	{
 		std::cout << e.what() << "\n";
+		if (benchmark.enabled)
+		{
+			LogStream::closeLogFile();
+			return 1;
+		}
 		int c;
 		std::cin >> c;
 	}
@@ -4,12 +4,7 @@
 #include <Windows.h>
 
 #include "PolygonBuilder.h"
-
-enum class RCConstruction
-{
-	RCUnknown, RCCore, RCFirst, RCSeale, RCFiller,
-	RCWarrington, RCXLaid, RCTriWire
-};
+#include "rope_native.h"
 
 enum class RCRopeState
 {
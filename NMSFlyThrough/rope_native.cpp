@@ -0,0 +1,234 @@
+#include "rope_native.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/constants.hpp>
+
+#include <Core/ErrorHandling.h>
+
+namespace
+{
+	// A ring of wires in a strand, in units of the core wire radius.
+	struct WireLayer
+	{
+		unsigned int count;
+		float radius;
+		float pitch;
+		float phase;
+		// -1 for laid the other way to the rest of the strand.
+		float direction;
+	};
+
+	// Radius of count wires that touch each other around a core.
+	float touching(float core, unsigned int count)
+	{
+		float s = std::sin(glm::pi<float>() / count);
+		return core * s / (1.0f - s);
+	}
+
+	std::vector<WireLayer> strandLayers(RCConstruction construction)
+	{
+		const float pi = glm::pi<float>();
+		switch (construction)
+		{
+		case RCConstruction::RCCore:
+			return { { 1, 1.0f, 0.0f, 0.0f, 1.0f }, { 6, 1.0f, 2.0f, 0.0f, 1.0f } };
+		case RCConstruction::RCSeale:
+		{
+			float r1 = touching(1.0f, 9);
+			float r2 = touching(1.0f + 2.0f * r1, 9);
+			return { { 1, 1.0f, 0.0f, 0.0f, 1.0f },
+				{ 9, r1, 1.0f + r1, 0.0f, 1.0f },
+				// In the valleys of the inner layer
+				{ 9, r2, 1.0f + 2.0f * r1 + r2, pi / 9.0f, 1.0f } };
+		}
+		case RCConstruction::RCFiller:
+		{
+			float r2 = touching(3.0f, 12);
+			return { { 1, 1.0f, 0.0f, 0.0f, 1.0f },
+				{ 6, 1.0f, 2.0f, 0.0f, 1.0f },
+				// The small filler wires in the valleys
+				{ 6, 0.4f, 2.9f, pi / 6.0f, 1.0f },
+				{ 12, r2, 3.0f + r2, pi / 12.0f, 1.0f } };
+		}
+		case RCConstruction::RCWarrington:
+			// The outer layer is large wires in the valleys of the inner
+			// layer and small wires on its crowns.
+			return { { 1, 1.0f, 0.0f, 0.0f, 1.0f },
+				{ 6, 1.0f, 2.0f, 0.0f, 1.0f },
+				{ 6, 1.0f, 2.0f * std::sqrt(3.0f), pi / 6.0f, 1.0f },
+				{ 6, 0.7f, 3.7f, 0.0f, 1.0f } };
+		case RCConstruction::RCXLaid:
+		{
+			float r2 = touching(3.0f, 12);
+			return { { 1, 1.0f, 0.0f, 0.0f, 1.0f },
+				{ 6, 1.0f, 2.0f, 0.0f, 1.0f },
+				{ 12, r2, 3.0f + r2, pi / 12.0f, -1.0f } };
+		}
+		case RCConstruction::RCTriWire:
+		{
+			float core = 2.0f / std::sqrt(3.0f);
+			float r1 = touching(core + 1.0f, 9);
+			return { { 3, 1.0f, core, 0.0f, 1.0f },
+				{ 9, r1, core + 1.0f + r1, pi / 9.0f, 1.0f } };
+		}
+		default:
+			throw NMSLogicException(std::stringstream()
+				<< "calcNativeRope cannot build construction ["
+				<< static_cast<int>(construction) << "].\n");
+		}
+	}
+
+	float strandRadius(const std::vector<WireLayer>& layers)
+	{
+		float r = 0.0f;
+		for (const WireLayer& l : layers)
+			r = std::max(r, l.pitch + l.radius);
+		return r;
+	}
+
+	struct Strand
+	{
+		float scale;
+		float pitch;
+		float phase;
+		// Of the wires in the strand
+		float wireLay;
+	};
+
+	struct RopeLayout
+	{
+		std::vector<WireLayer> layers;
+		// The core strand first
+		std::vector<Strand> strands;
+		float ropeLay;
+		float length;
+	};
+
+	RopeLayout layout(const NativeRopeData& rd)
+	{
+		if (rd.diameter <= 0.0f || rd.numDepthLayers < 2 || rd.pointsPerWire < 3)
+		{
+			throw NMSLogicException(std::stringstream()
+				<< "calcNativeRope needs a diameter, at least 2 depth layers and 3 points a wire. "
+				<< "Given diameter [" << rd.diameter << "], depth layers ["
+				<< rd.numDepthLayers << "] and points [" << rd.pointsPerWire << "].\n");
+		}
+		// touching() divides by 0 for 2 and gives nothing for 1.
+		if (rd.strands == 1 || rd.strands == 2)
+		{
+			throw NMSLogicException(std::stringstream()
+				<< "calcNativeRope needs 0 or at least 3 strands. Given ["
+				<< rd.strands << "].\n");
+		}
+		RopeLayout retval;
+		retval.layers = strandLayers(rd.construction);
+		const float unitRadius = strandRadius(retval.layers);
+		const float ropeRadius = rd.diameter * 0.5f;
+
+		// The outer strands touch each other around the core strand.
+		float outer = rd.strands ? touching(1.0f, rd.strands) : 0.0f;
+		float coreScale = ropeRadius / (unitRadius * (1.0f + 2.0f * outer));
+		retval.strands.push_back({ coreScale, 0.0f, 0.0f,
+			rd.layFactor * 2.0f * unitRadius * coreScale });
+		float outerScale = coreScale * outer;
+		for (unsigned int i = 0; i < rd.strands; i++)
+		{
+			retval.strands.push_back({ outerScale, unitRadius * (coreScale + outerScale),
+				glm::two_pi<float>() * i / rd.strands,
+				rd.layFactor * 2.0f * unitRadius * outerScale });
+		}
+		retval.ropeLay = rd.layFactor * rd.diameter;
+		retval.length = rd.length;
+		if (retval.length <= 0.0f)
+			retval.length = rd.strands ? retval.ropeLay : retval.strands[0].wireLay;
+		return retval;
+	}
+
+	// Ordinary lay wires go the other way to the strands.
+	float wireDirection(const NativeRopeData& rd, const Strand& s)
+	{
+		return (rd.langLay || s.pitch == 0.0f) ? 1.0f : -1.0f;
+	}
+
+	// The cross sections at depth z of the wires of a strand centred on the
+	// helix (pitch, phase) about the rope, added to the current layer of pb.
+	void addStrand(const NativeRopeData& rd, const std::vector<WireLayer>& layers,
+		const Strand& s, int strandId, float ropeLay, float z, PolygonBuilder& pb)
+	{
+		const float twoPi = glm::two_pi<float>();
+		glm::vec2 centre(0.0f);
+		if (s.pitch > 0.0f)
+		{
+			float a = s.phase + twoPi * z / ropeLay;
+			centre = s.pitch * glm::vec2(std::cos(a), std::sin(a));
+		}
+		int wireId = 0;
+		for (const WireLayer& l : layers)
+		{
+			float pitch = l.pitch * s.scale;
+			float radius = l.radius * s.scale;
+			float stretch = 1.0f / std::cos(std::atan(twoPi * pitch / s.wireLay));
+			for (unsigned int w = 0; w < l.count; w++)
+			{
+				float a = l.phase + twoPi * w / l.count
+					+ l.direction * wireDirection(rd, s) * twoPi * z / s.wireLay;
+				glm::vec2 u(std::cos(a), std::sin(a));
+				glm::vec2 v(-u.y, u.x);
+				glm::vec2 wireCentre = centre + pitch * u;
+				std::span<glm::vec3> points = pb.addSlice(rd.pointsPerWire,
+					1000 * (strandId + 1) + wireId++);
+				// Clockwise, as createRopeSurfaces() expects. t runs
+				// backwards since u, v turns anticlockwise.
+				for (unsigned int p = 0; p < rd.pointsPerWire; p++)
+				{
+					float t = -twoPi * p / rd.pointsPerWire;
+					glm::vec2 xy = wireCentre + u * (radius * std::cos(t))
+						+ v * (radius * stretch * std::sin(t));
+					points[p] = glm::vec3(xy, z);
+				}
+			}
+		}
+	}
+}
+
+void calcNativeRope(const NativeRopeData& rd, PolygonBuilder& pb)
+{
+	const RopeLayout rl = layout(rd);
+	size_t wires = 0;
+	for (const WireLayer& l : rl.layers)
+		wires += l.count;
+	wires *= rl.strands.size();
+	pb.reserve(rd.numDepthLayers, rd.numDepthLayers * wires,
+		rd.numDepthLayers * wires * rd.pointsPerWire);
+	for (unsigned int d = 0; d < rd.numDepthLayers; d++)
+	{
+		float z = rl.length * d / (rd.numDepthLayers - 1);
+		pb.beginLayer();
+		for (size_t s = 0; s < rl.strands.size(); s++)
+			addStrand(rd, rl.layers, rl.strands[s], static_cast<int>(s), rl.ropeLay, z, pb);
+	}
+	pb.finish();
+}
+
+float calcNativeWires(const NativeRopeData& rd, std::vector<HelixWireRenderer::Wire>& wires)
+{
+	const RopeLayout rl = layout(rd);
+	const float twoPi = glm::two_pi<float>();
+	wires.clear();
+	for (const Strand& s : rl.strands)
+	{
+		float strandTwist = s.pitch > 0.0f ? twoPi / rl.ropeLay : 0.0f;
+		for (const WireLayer& l : rl.layers)
+		{
+			for (unsigned int w = 0; w < l.count; w++)
+			{
+				wires.push_back({ s.pitch, s.phase, l.pitch * s.scale,
+					l.phase + twoPi * w / l.count, l.radius * s.scale, strandTwist,
+					l.direction * wireDirection(rd, s) * twoPi / s.wireLay });
+			}
+		}
+	}
+	return rl.length;
+}
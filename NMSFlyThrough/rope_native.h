@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+#include <Renderers/HelixWireRenderer.h>
+
+#include "PolygonBuilder.h"
+
+enum class RCConstruction
+{
+	RCUnknown, RCCore, RCFirst, RCSeale, RCFiller,
+	RCWarrington, RCXLaid, RCTriWire
+};
+
+struct NativeRopeData
+{
+	// RCCore 1-6, RCSeale 1-9-9, RCFiller 1-6-6F-12, RCWarrington
+	// 1-6-(6+6), RCXLaid 1-6-12 with the outer layer laid the other way
+	// and RCTriWire 3-9.
+	RCConstruction construction = RCConstruction::RCSeale;
+	// Strands laid around a core strand of the same construction. 0 for
+	// a single strand, otherwise at least 3 to go round the core.
+	unsigned int strands = 6;
+	float diameter = 1.0f;
+	// Length drawn. 0 for one lay of the outer layer.
+	float length = 0.0f;
+	unsigned int numDepthLayers = 30;
+	unsigned int pointsPerWire = 24;
+	// Lay lengths as a multiple of the diameter of what is laid.
+	float layFactor = 7.0f;
+	// Wires laid the same way as the strands instead of the other way.
+	bool langLay = false;
+};
+
+/*
+	Builds the wire cross sections of a rope in C++ for the RCConstruction
+	types, instead of asking the rope DLL for them with calcQuickRope().
+	Each wire follows a helix about its strand, and each strand about the
+	rope. At every depth a wire is cut across the rope axis, which for a
+	helix is an ellipse stretched along the lay by 1 / cos(lay angle).
+	The points are written straight into pb as one layer per depth with
+	the wires in the same order in every layer, as PolygonBuilder::get()
+	gives them. Each slice is wound clockwise looking along the rope,
+	which createRopeSurfaces() needs for the normals to point out.
+	Wire ids are 1000 * (strand + 1) + wire, the core strand being 0.
+*/
+void calcNativeRope(const NativeRopeData& rd, PolygonBuilder& pb);
+// The same wires as helices for the HelixWireRenderer, in the same order.
+// Returns the length of the rope.
+float calcNativeWires(const NativeRopeData& rd, std::vector<HelixWireRenderer::Wire>& wires);
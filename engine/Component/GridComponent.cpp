@@ -0,0 +1,13 @@
+#include "GridComponent.h"
+
+#include <Renderers/GridRenderer.h>
+
+void GridComponent::doInit()
+{
+	GridComponentData* d = data();
+	GridRenderer* r = new GridRenderer(new Shader(&d->shaderData));
+	r->setup(d->box, d->spacing, d->colour, d->lineWidth, d->fadeStart, d->fadeEnd);
+	d->boundingBox = d->box;
+	addRenderer(r);
+	OLDSceneComponent::doInit();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cfloat>
+
+#include "OWSceneComponent.h"
+#include <Helpers/Shader.h>
+
+class OLDActor;
+
+struct OWENGINE_API GridComponentData: public OLDSceneComponentData
+{
+	// grid.v.glsl/grid.f.glsl
+	ShaderData shaderData;
+	// The grid fills this box.
+	AABB box;
+	glm::vec3 spacing = { 1, 1, 1 };
+	glm::vec4 colour = { 1, 1, 1, 1 };
+	// In pixels
+	float lineWidth = 1.0f;
+	// Distances from the camera. The grid is gone by fadeEnd.
+	float fadeStart = FLT_MAX / 2;
+	float fadeEnd = FLT_MAX;
+};
+
+// A grid of lines drawn procedurally by the GridRenderer.
+class OWENGINE_API GridComponent: public OLDSceneComponent
+{
+protected:
+	GridComponentData* data() override
+	{
+		return static_cast<GridComponentData*>(OLDSceneComponent::data());
+	}
+public:
+	GridComponent(OLDActor* _owner, GridComponentData* _data)
+		: OLDSceneComponent(_owner, _data)
+	{}
+	const GridComponentData* constData() const override
+	{
+		return static_cast<const GridComponentData*>(OLDSceneComponent::constData());
+	}
+	void doInit() override;
+};
@@ -0,0 +1,17 @@
+#include "HelixWireComponent.h"
+
+void HelixWireComponent::doInit()
+{
+	HelixWireComponentData* d = data();
+	mRenderer = new HelixWireRenderer(new Shader(&d->shaderData));
+	mRenderer->setup(d->wires, d->length, d->rings, d->pointsPerWire);
+	addRenderer(mRenderer);
+	OLDSceneComponent::doInit();
+}
+
+void HelixWireComponent::rings(unsigned int rings)
+{
+	data()->rings = rings;
+	if (mRenderer)
+		mRenderer->rings(rings);
+}
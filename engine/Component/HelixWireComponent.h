@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+#include "OWSceneComponent.h"
+#include <Helpers/Shader.h>
+#include <Renderers/HelixWireRenderer.h>
+
+class OLDActor;
+
+struct OWENGINE_API HelixWireComponentData: public OLDSceneComponentData
+{
+	// helixWire.v.glsl/Wires.f.glsl
+	ShaderData shaderData;
+	std::vector<HelixWireRenderer::Wire> wires;
+	// Along z from 0
+	float length = 1.0f;
+	unsigned int rings = 30;
+	unsigned int pointsPerWire = 24;
+};
+
+// The wires of a rope drawn as instanced helices by the HelixWireRenderer.
+class OWENGINE_API HelixWireComponent: public OLDSceneComponent
+{
+protected:
+	HelixWireComponentData* data() override
+	{
+		return static_cast<HelixWireComponentData*>(OLDSceneComponent::data());
+	}
+public:
+	HelixWireComponent(OLDActor* _owner, HelixWireComponentData* _data)
+		: OLDSceneComponent(_owner, _data)
+	{}
+	const HelixWireComponentData* constData() const override
+	{
+		return static_cast<const HelixWireComponentData*>(OLDSceneComponent::constData());
+	}
+	void doInit() override;
+	// Rings along the rope. Nothing is made again.
+	void rings(unsigned int rings);
+	unsigned int rings() const { return constData()->rings; }
+private:
+	HelixWireRenderer* mRenderer = nullptr;
+};
@@ -0,0 +1,213 @@
+#include "LabelComponent.h"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../Core/ErrorHandling.h"
+#include "../Core/GlobalSettings.h"
+#include "../Helpers/CellKey.h"
+
+// Size of the cells of the screen space grid.
+static const float GridCellPixels = 64.0f;
+
+void LabelComponent::doInit()
+{
+	const LabelComponentData* d = constData();
+	if (!d->labelProvider && d->anchors.size() != d->labels.size())
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "LabelComponent [" << d->name << "] has [" << d->anchors.size()
+			<< "] anchors but [" << d->labels.size() << "] labels.\n");
+	}
+	if (!d->priorities.empty() && d->priorities.size() != d->anchors.size())
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "LabelComponent [" << d->name << "] has [" << d->anchors.size()
+			<< "] anchors but [" << d->priorities.size() << "] priorities.\n");
+	}
+	if (d->maxDistance <= 0.0f)
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "LabelComponent [" << d->name << "] must have a maxDistance.\n");
+	}
+	mCells.clear();
+	for (unsigned int i = 0; i < d->anchors.size(); i++)
+	{
+		// The TextBatcher cannot make empty text.
+		if (!label(i).empty())
+			mCells[CellKey::key(cell(d->anchors[i]))].push_back(i);
+	}
+	OLDSceneComponent::doInit();
+}
+
+glm::ivec3 LabelComponent::cell(const glm::vec3& p) const
+{
+	return CellKey::cell(p, glm::vec3(constData()->maxDistance));
+}
+
+std::string_view LabelComponent::label(unsigned int index) const
+{
+	const LabelComponentData* d = constData();
+	if (d->labelProvider)
+		return d->labelProvider(index);
+	return d->labels[index];
+}
+
+void LabelComponent::findCandidates(const glm::mat4& pvm, const glm::vec3& camera,
+	const glm::vec2& viewport, float proj11)
+{
+	const LabelComponentData* d = constData();
+	mCandidates.clear();
+	const glm::ivec3 centre = cell(camera);
+	for (int z = -1; z <= 1; z++)
+	{
+		for (int y = -1; y <= 1; y++)
+		{
+			for (int x = -1; x <= 1; x++)
+			{
+				auto iter = mCells.find(CellKey::key(centre + glm::ivec3(x, y, z)));
+				if (iter == mCells.end())
+					continue;
+				for (unsigned int i : iter->second)
+				{
+					const glm::vec3& anchor = d->anchors[i];
+					float dist = glm::length(anchor - camera);
+					if (dist > d->maxDistance)
+						continue;
+					// As starPoints.v.glsl sizes a star.
+					if (d->radius * proj11 * viewport.y / std::max(dist, 0.0001f) < d->minPixels)
+						continue;
+					glm::vec4 clip = pvm * glm::vec4(anchor, 1.0f);
+					if (clip.w <= 0.0f)
+						continue;
+					glm::vec2 ndc = glm::vec2(clip) / clip.w;
+					if (std::abs(ndc.x) > 1.0f || std::abs(ndc.y) > 1.0f)
+						continue;
+					int priority = d->priorities.empty() ? 0 : d->priorities[i];
+					mCandidates.push_back({ priority, dist, i,
+						(ndc * 0.5f + 0.5f) * viewport });
+				}
+			}
+		}
+	}
+}
+
+bool LabelComponent::place(const Rect& r)
+{
+	glm::ivec2 from = glm::clamp(glm::ivec2(glm::floor(r.minPoint / GridCellPixels)),
+		glm::ivec2(0), mGridSize - 1);
+	glm::ivec2 to = glm::clamp(glm::ivec2(glm::floor(r.maxPoint / GridCellPixels)),
+		glm::ivec2(0), mGridSize - 1);
+	for (int y = from.y; y <= to.y; y++)
+	{
+		for (int x = from.x; x <= to.x; x++)
+		{
+			for (const Rect& other : mGrid[y * mGridSize.x + x])
+			{
+				if (r.minPoint.x < other.maxPoint.x && other.minPoint.x < r.maxPoint.x
+					&& r.minPoint.y < other.maxPoint.y && other.minPoint.y < r.maxPoint.y)
+					return false;
+			}
+		}
+	}
+	for (int y = from.y; y <= to.y; y++)
+	{
+		for (int x = from.x; x <= to.x; x++)
+		{
+			size_t c = y * mGridSize.x + x;
+			if (mGrid[c].empty())
+				mUsedGridCells.push_back(c);
+			mGrid[c].push_back(r);
+		}
+	}
+	return true;
+}
+
+void LabelComponent::clearPlaced()
+{
+	for (size_t c : mUsedGridCells)
+		mGrid[c].clear();
+	mUsedGridCells.clear();
+}
+
+void LabelComponent::render(const glm::mat4& proj,
+	const glm::mat4& view,
+	const glm::mat4& model,
+	const glm::vec3& cameraPos,
+	RenderTypes::ShaderMutator OW_UNUSED(renderCb),
+	RenderTypes::ShaderResizer OW_UNUSED(resizeCb))
+{
+	mShown = 0;
+	if (data()->physics.visibility <= 0.001f)
+		return;
+	const LabelComponentData* d = constData();
+	mFrame++;
+	glm::mat4 _model = modelTransform(model);
+	glm::vec3 camera = glm::vec3(glm::inverse(_model) * glm::vec4(cameraPos, 1.0f));
+	glm::vec2 viewport = glm::vec2(globals->physicalWindowSize());
+	findCandidates(proj * view * _model, camera, viewport, proj[1][1]);
+	std::sort(mCandidates.begin(), mCandidates.end(), [](const Candidate& a, const Candidate& b)
+	{
+		if (a.priority != b.priority)
+			return a.priority > b.priority;
+		return a.distance < b.distance;
+	});
+
+	glm::ivec2 gridSize = glm::ivec2(glm::ceil(viewport / GridCellPixels));
+	gridSize = glm::max(gridSize, glm::ivec2(1));
+	if (gridSize != mGridSize)
+	{
+		mGridSize = gridSize;
+		mGrid.assign(static_cast<size_t>(gridSize.x) * gridSize.y, {});
+		mUsedGridCells.clear();
+	}
+	clearPlaced();
+
+	const glm::vec2 pixelsPerUnit = TextBatcher::pixelsPerUnit(viewport);
+	unsigned int newLabels = 0;
+	for (const Candidate& c : mCandidates)
+	{
+		auto iter = mMade.find(c.index);
+		if (iter != mMade.end())
+			iter->second.lastCandidate = mFrame;
+		if (mShown >= d->maxLabels)
+			continue;
+		if (iter == mMade.end())
+		{
+			if (newLabels >= d->maxNewLabelsPerFrame)
+				continue;
+			TextData td = d->textData;
+			td.text = std::string(label(c.index));
+			Made made;
+			made.id = TextBatcher::add(td, made.bounds);
+			made.lastCandidate = mFrame;
+			iter = mMade.emplace(c.index, made).first;
+			newLabels++;
+		}
+		const AABB& bounds = iter->second.bounds;
+		Rect r = { c.screen + glm::vec2(bounds.minPoint()) * pixelsPerUnit - d->padding,
+				   c.screen + glm::vec2(bounds.maxPoint()) * pixelsPerUnit + d->padding };
+		if (!place(r))
+			continue;
+		// The TextBatcher anchors the label at model * bounds.center().
+		glm::vec3 anchor = glm::vec3(_model * glm::vec4(d->anchors[c.index], 1.0f));
+		TextBatcher::submit(iter->second.id,
+			glm::translate(glm::mat4(1.0f), anchor - bounds.center()));
+		mShown++;
+	}
+
+	// Text is only kept for labels that could be drawn.
+	for (auto iter = mMade.begin(); iter != mMade.end();)
+	{
+		if (iter->second.lastCandidate != mFrame)
+		{
+			TextBatcher::remove(iter->second.id);
+			iter = mMade.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
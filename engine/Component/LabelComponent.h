@@ -0,0 +1,119 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+#include "OWSceneComponent.h"
+#include "TextComponent.h"
+#include <Renderers/TextBatcher.h>
+
+class OLDActor;
+
+struct OWENGINE_API LabelComponentData: public OLDSceneComponentData
+{
+	typedef std::function<std::string_view(unsigned int index)> LabelProvider;
+	// Font, colour, spacing and reference position of every label. The
+	// text comes from labelProvider if set, otherwise from labels.
+	TextData textData;
+	std::vector<glm::vec3> anchors;
+	std::vector<std::string> labels;
+	// The text of the label at an anchor, asked for when the label is made
+	// so it need not be copied for every anchor. What it points to must
+	// outlive the component.
+	LabelProvider labelProvider;
+	// Where labels overlap the higher priority one is drawn, then the
+	// nearer. Empty for all the same.
+	std::vector<int> priorities;
+	// No labels further from the camera than this.
+	float maxDistance = 100.0f;
+	// No label unless a sphere of radius at the anchor covers at least
+	// minPixels on the screen.
+	float radius = 1.0f;
+	float minPixels = 0.0f;
+	size_t maxLabels = 256;
+	// Pixels kept clear around each label.
+	float padding = 2.0f;
+	// Labels not yet made for the TextBatcher are made at most this many a
+	// frame so flying into a crowd does not stall.
+	unsigned int maxNewLabelsPerFrame = 32;
+};
+
+/*
+	Labels for a lot of points (e.g. the names of stars) of which only the
+	readable ones are drawn. The anchors are bucketed in a grid of
+	maxDistance cells so each frame only the 27 cells around the camera are
+	looked at. Those in range, in front of the camera and big enough on
+	screen are placed in priority then distance order on a screen space
+	grid, and any that would overlap one already placed are dropped.
+	Only the survivors are submitted to the TextBatcher. The text for a
+	label is only made while it is a candidate, so the cost follows what is
+	near the camera rather than the number of labels.
+*/
+class OWENGINE_API LabelComponent: public OLDSceneComponent
+{
+protected:
+	LabelComponentData* data() override
+	{
+		return static_cast<LabelComponentData*>(OLDSceneComponent::data());
+	}
+public:
+	LabelComponent(OLDActor* _owner, LabelComponentData* _data)
+		: OLDSceneComponent(_owner, _data)
+	{}
+	const LabelComponentData* constData() const override
+	{
+		return static_cast<const LabelComponentData*>(OLDSceneComponent::constData());
+	}
+	void doInit() override;
+	void render(const glm::mat4& proj,
+		const glm::mat4& view,
+		const glm::mat4& model,
+		const glm::vec3& cameraPos,
+		RenderTypes::ShaderMutator renderCb = nullptr,
+		RenderTypes::ShaderResizer resizeCb = nullptr) override;
+	// Labels drawn in the last frame
+	size_t shownLabels() const { return mShown; }
+private:
+	struct Candidate
+	{
+		int priority;
+		float distance;
+		unsigned int index;
+		glm::vec2 screen;
+	};
+	struct Made
+	{
+		TextBatcher::LabelId id;
+		AABB bounds;
+		unsigned int lastCandidate;
+	};
+	struct Rect
+	{
+		glm::vec2 minPoint;
+		glm::vec2 maxPoint;
+	};
+	glm::ivec3 cell(const glm::vec3& p) const;
+	std::string_view label(unsigned int index) const;
+	// camera is in the space of the anchors.
+	void findCandidates(const glm::mat4& pvm, const glm::vec3& camera,
+				const glm::vec2& viewport, float proj11);
+	// false if r overlaps a label already placed, otherwise places it.
+	bool place(const Rect& r);
+	void clearPlaced();
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	// Anchor indices in each cell
+	std::unordered_map<unsigned long long, std::vector<unsigned int>> mCells;
+	std::vector<Candidate> mCandidates;
+	// Labels made for the TextBatcher, by anchor index
+	std::unordered_map<unsigned int, Made> mMade;
+	// Screen space grid of the rects placed this frame
+	glm::ivec2 mGridSize = glm::ivec2(0);
+	std::vector<std::vector<Rect>> mGrid;
+	std::vector<size_t> mUsedGridCells;
+	unsigned int mFrame = 0;
+	size_t mShown = 0;
+#pragma warning( pop )
+};
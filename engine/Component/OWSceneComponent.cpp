@@ -2,10 +2,10 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "../Core/GPUProfiler.h"
 #include "../Geometry/OWRay.h"
 #include "../Actor/OWActor.h"
-#include "../Helpers/Shader.h"
-#include "../Component/MeshComponentVAO.h"
+#include "../Renderers/BoundingBoxRenderer.h"
 
 
 OLDSceneComponent::OLDSceneComponent(OLDActor* _owner, OLDSceneComponentData* _data)
@@ -19,37 +19,6 @@ OLDSceneComponent::OLDSceneComponent(OLDActor* _owner, OLDSceneComponentData* _d
 
 void OLDSceneComponent::doInit()
 {
-	if (mBoundingBoxRenderer == nullptr)
-	{
-		ShaderData* sd = new ShaderData();
-		sd->PVMName = "pvm";
-		MeshComponentVAOData* mvd = new MeshComponentVAOData();
-		mvd->shaderData.shaderV = "Wires.v.glsl";
-		mvd->shaderData.shaderF = "Wires.f.glsl";
-		mvd->shaderData.PVMName = "pvm";
-		mvd->shaderData.projectionName = "projection";
-		mvd->shaderData.viewName = "view";
-		mvd->shaderData.modelName = "model";
-
-		Shader* lineShader = new Shader(&mvd->shaderData);
-		lineShader->loadBoilerPlates();
-		mvd->meshData = VAOBuffer(lineShader, VAOBuffer::DRAW_MULTI);
-
-		VAOBuffer* vao = new VAOBuffer(lineShader, VAOBuffer::DRAW_ARRAYS);
-		std::vector<std::vector<glm::vec3>> surfaces = data()->boundingBox.surfaces();
-		for (const std::vector<glm::vec3>& p : surfaces)
-		{
-			MeshDataLight lineData;
-			lineData.colour(OWUtils::colour(OWUtils::SolidColours::BLACK), "colour");
-			lineData.vertices(p, GL_LINE_STRIP);
-			vao->add(&lineData);
-		}
-		vao->prepare();
-		mBoundingBoxRenderer = vao;
-	}
-	else
-		throw NMSLogicException(
-			"Error. mBoundingBoxRenderer should be null OWSceneComponent::doInit() for [" + name() + "]\n");
 	mOriginalBoundingBox = data()->boundingBox;
 	physicalDoInit();
 }
@@ -127,6 +96,18 @@ void OLDSceneComponent::collided(OLDCollisionData* other)
 	velocity(velocity() + reboundDir * velocity());
 }
 
+glm::mat4 OLDSceneComponent::modelTransform(const glm::mat4& model)
+{
+	OWPhysicsDataImp* imp = &data()->physics;
+	const glm::mat4 I(1.0f);
+	float len = glm::length(imp->mRotate);
+	glm::vec3 norm = glm::normalize(imp->mRotate);
+	glm::mat4 r = OWUtils::isZero(len) ? I : glm::rotate(model, len, norm);
+	glm::mat4 s = glm::scale(I, imp->mScale);
+	glm::mat4 t = glm::translate(I, imp->mTranslate);
+	return t * r * s;
+}
+
 void OLDSceneComponent::render(const glm::mat4& proj,
 	const glm::mat4& view,
 	const glm::mat4& model,
@@ -141,16 +122,10 @@ void OLDSceneComponent::render(const glm::mat4& proj,
 	}
 	if (data()->physics.visibility > 0.001f)
 	{
-		OWPhysicsDataImp* imp = &data()->physics;
-		const glm::mat4 I(1.0f);
-		float len = glm::length(imp->mRotate);
-		glm::vec3 norm = glm::normalize(imp->mRotate);
-		glm::mat4 r = OWUtils::isZero(len) ? I : glm::rotate(model, len, norm);
-		glm::mat4 s = glm::scale(I, imp->mScale);
-		glm::mat4 t = glm::translate(I, imp->mTranslate);
-		glm::mat4 _model = t * r * s;
+		GPUProfileScope gp(ss.c_str(), GPUProfiler::componentScopes());
+		glm::mat4 _model = modelTransform(model);
 		mRenderer->render(proj, view, _model, cameraPos, renderCb, resizeCb);
-		if (mBoundingBoxRenderer != nullptr)
+		if (mRenderBoundingBox)
 		{
 			glm::vec3 newScaling(0);
 			const AABB& orig = mOriginalBoundingBox;
@@ -162,7 +137,8 @@ void OLDSceneComponent::render(const glm::mat4& proj,
 			glm::mat4 s2 = glm::scale(model, newScaling);
 			glm::mat4 t2 = glm::translate(I2, translation());
 			glm::mat4 model2 = t2 * s2;
-			mBoundingBoxRenderer->render(proj, view, model2, cameraPos, renderCb, resizeCb);
+			BoundingBoxRenderer::submit(orig, model2,
+				OWUtils::colour(OWUtils::SolidColours::BLACK));
 		}
 	}
 }
@@ -16,7 +16,8 @@ struct OWENGINE_API OLDSceneComponentData: public OWPhysicsData
 class OWENGINE_API OLDSceneComponent: public OLDComponent, public OLDIPhysical, public OLDIRenderable
 {
 protected:
-	RendererBase* mBoundingBoxRenderer = nullptr;
+	// Boxes are drawn by the shared BoundingBoxRenderer
+	bool mRenderBoundingBox = true;
 	AABB mOriginalBoundingBox;
 	RendererBase* mRenderer = nullptr;
 	virtual OLDSceneComponentData* data() override
@@ -24,6 +25,8 @@ protected:
 		return static_cast<OLDSceneComponentData*>(OLDIPhysical::data());
 	}
 	void addRenderer(RendererBase* r) { mRenderer = r; }
+	// The model matrix render() passes to the renderer.
+	glm::mat4 modelTransform(const glm::mat4& model);
 public:
 	typedef std::function<void(OLDSceneComponent* sc)> OWSceneComponentCallbackType;
 	OLDSceneComponent(OLDActor* _owner, OLDSceneComponentData* _data = nullptr);
@@ -0,0 +1,235 @@
+#include "StarComponent.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../Core/ErrorHandling.h"
+#include "../Core/LogStream.h"
+#include "../Helpers/CellKey.h"
+
+
+void StarComponent::doInit()
+{
+	StarComponentData* d = data();
+	if (d->proceduralStars > 0)
+	{
+		mPoints = new PointSpriteRenderer(new Shader(&d->pointShaderData));
+		mPoints->setupProcedural(d->proceduralStars, d->proceduralSeed,
+			d->proceduralCentre, d->proceduralSpread, d->proceduralPalette);
+		addRenderer(mPoints);
+		OLDSceneComponent::doInit();
+		return;
+	}
+	if (d->regionLoader)
+	{
+		mPoints = new PointSpriteRenderer(new Shader(&d->pointShaderData));
+		if (d->packPoints)
+		{
+			mPoints->positionFormat(MeshDataInstance::PositionFormat::Quantised,
+				d->regionBounds);
+			mPoints->colourFormat(MeshDataInstance::ColourFormat::RGBA8);
+		}
+		// Each region takes a slot of maxRegionStars stars and colours.
+		size_t slotBytes = d->maxRegionStars * mPoints->pointSize();
+		unsigned int slots = static_cast<unsigned int>(std::max(size_t(1), d->regionBudget / slotBytes));
+		unsigned int side = 2 * d->regionLoadRadius + 1;
+		if (slots < side * side * side)
+		{
+			LogStream(LogStreamLevel::Warning) << "StarComponent [" << d->name
+				<< "] has room for [" << slots << "] regions but loads ["
+				<< side * side * side << "] around the camera. Raise regionBudget.\n";
+		}
+		mPoints->setupPaged(slots, d->maxRegionStars);
+		mPager = std::make_unique<RegionPager>(d->regionLoader, d->regionSize,
+			d->regionLoadRadius, d->regionKeepRadius, slots);
+		addRenderer(mPoints);
+		OLDSceneComponent::doInit();
+		return;
+	}
+	if (d->catalogueStars > 0)
+	{
+		mPoints = new PointSpriteRenderer(new Shader(&d->pointShaderData));
+		mPoints->setupCatalogue(d->cataloguePositions, d->catalogueColours,
+			d->catalogueStars);
+		addRenderer(mPoints);
+		OLDSceneComponent::doInit();
+		return;
+	}
+	if (d->stars.size() != d->colours.size())
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "StarComponent [" << d->name << "] has [" << d->stars.size()
+			<< "] stars but [" << d->colours.size() << "] colours.\n");
+	}
+	mPoints = new PointSpriteRenderer(new Shader(&d->pointShaderData));
+	if (!d->cullShaderData.shaderV.empty())
+		mPoints->culling(new Shader(&d->cullShaderData));
+	if (d->packPoints && !d->stars.empty())
+	{
+		mPoints->positionFormat(MeshDataInstance::PositionFormat::Quantised,
+			AABB(d->stars));
+		mPoints->colourFormat(MeshDataInstance::ColourFormat::RGBA8);
+	}
+	mPoints->setup(d->stars, d->colours);
+	addRenderer(mPoints);
+	if (d->nearDistance > 0.0f && d->maxNearStars > 0 && !d->stars.empty())
+	{
+		// Set up with one instance so the buffers exist. selectNear()
+		// sets the real count every frame.
+		// The near stars are sent packed; 6 byte positions over the whole
+		// map and a 1 byte palette index when there are few star colours.
+		MeshDataInstance mdi;
+		mdi.vertices(d->mesh, GL_TRIANGLES, 0);
+		mdi.positions({ glm::vec3(d->stars[0]) }, 1, 1);
+		mdi.positionFormat(MeshDataInstance::PositionFormat::Quantised, AABB(d->stars));
+		buildPalette();
+		if (mPalette.empty())
+		{
+			mdi.colourFormat(MeshDataInstance::ColourFormat::RGBA8);
+			mdi.colours({ d->colours[0] }, 1, 2);
+		}
+		else
+		{
+			mdi.colourFormat(MeshDataInstance::ColourFormat::PaletteIndex, mPalette);
+			mdi.colourIndices({ mColourIndices[0] }, 1, 2);
+		}
+		mMeshes = new InstanceRenderer(new Shader(&d->meshShaderData));
+		mMeshes->setup(&mdi);
+		mMeshes->instanceCount(0);
+		buildCells();
+	}
+	OLDSceneComponent::doInit();
+}
+
+glm::ivec3 StarComponent::cell(const glm::vec3& p) const
+{
+	return CellKey::cell(p, glm::vec3(constData()->nearDistance));
+}
+
+void StarComponent::buildCells()
+{
+	const std::vector<glm::vec4>& stars = constData()->stars;
+	mCells.clear();
+	for (unsigned int i = 0; i < stars.size(); i++)
+		mCells[CellKey::key(cell(glm::vec3(stars[i])))].push_back(i);
+}
+
+void StarComponent::buildPalette()
+{
+	const std::vector<glm::vec4>& colours = constData()->colours;
+	mPalette.clear();
+	mColourIndices.clear();
+	mColourIndices.reserve(colours.size());
+	for (const glm::vec4& c : colours)
+	{
+		auto iter = std::find(mPalette.begin(), mPalette.end(), c);
+		if (iter == mPalette.end())
+		{
+			if (mPalette.size() == MeshDataInstance::MaxPalette)
+			{
+				// Too many to index.
+				mPalette.clear();
+				mColourIndices.clear();
+				return;
+			}
+			iter = mPalette.insert(mPalette.end(), c);
+		}
+		mColourIndices.push_back(static_cast<unsigned char>(iter - mPalette.begin()));
+	}
+}
+
+void StarComponent::selectNear(const glm::vec3& camera, float modelScale)
+{
+	const StarComponentData* d = constData();
+	mCandidates.clear();
+	const glm::ivec3 centre = cell(camera);
+	for (int z = -1; z <= 1; z++)
+	{
+		for (int y = -1; y <= 1; y++)
+		{
+			for (int x = -1; x <= 1; x++)
+			{
+				auto iter = mCells.find(CellKey::key(centre + glm::ivec3(x, y, z)));
+				if (iter == mCells.end())
+					continue;
+				for (unsigned int i : iter->second)
+				{
+					float dist = glm::length(glm::vec3(d->stars[i]) - camera);
+					if (dist < d->nearDistance)
+						mCandidates.push_back({ dist, i });
+				}
+			}
+		}
+	}
+	float cutoff = d->nearDistance;
+	if (mCandidates.size() > d->maxNearStars)
+	{
+		std::nth_element(mCandidates.begin(), mCandidates.begin() + d->maxNearStars,
+			mCandidates.end());
+		// The points hide up to the nearest star that did not make it.
+		cutoff = mCandidates[d->maxNearStars].first;
+		mCandidates.resize(d->maxNearStars);
+	}
+	// The shaders measure in view space.
+	mPoints->nearDistance(cutoff * modelScale);
+
+	mSelected.clear();
+	for (const auto& c : mCandidates)
+		mSelected.push_back(c.second);
+	std::sort(mSelected.begin(), mSelected.end());
+	if (mSelected == mNear)
+		return;
+	mNear.swap(mSelected);
+	mNearPositions.clear();
+	mNearColours.clear();
+	mNearColourIndices.clear();
+	for (unsigned int i : mNear)
+	{
+		mNearPositions.push_back(glm::vec3(d->stars[i]));
+		if (mPalette.empty())
+			mNearColours.push_back(d->colours[i]);
+		else
+			mNearColourIndices.push_back(mColourIndices[i]);
+	}
+	mMeshes->instanceCount(mNear.size());
+	mMeshes->positions(0, mNearPositions.data(), mNearPositions.size());
+	if (mPalette.empty())
+		mMeshes->colours(0, mNearColours.data(), mNearColours.size());
+	else
+		mMeshes->colourIndices(0, mNearColourIndices.data(), mNearColourIndices.size());
+}
+
+void StarComponent::render(const glm::mat4& proj,
+	const glm::mat4& view,
+	const glm::mat4& model,
+	const glm::vec3& cameraPos,
+	RenderTypes::ShaderMutator renderCb,
+	RenderTypes::ShaderResizer resizeCb)
+{
+	if (data()->physics.visibility <= 0.001f)
+		return;
+	glm::mat4 _model = modelTransform(model);
+	glm::vec3 camera = glm::vec3(glm::inverse(_model) * glm::vec4(cameraPos, 1.0f));
+	if (mPager)
+	{
+		mPager->update(camera, data()->regionUploadsPerFrame,
+			[this](unsigned int slot, const RegionPager::Region& region)
+			{
+				mPoints->fillSlot(slot, region.stars, region.colours);
+			},
+			[this](unsigned int slot)
+			{
+				mPoints->emptySlot(slot);
+			});
+	}
+	if (mMeshes != nullptr)
+	{
+		// The cube root of the volume scale, exact for a uniform scale.
+		float modelScale = std::cbrt(std::abs(glm::determinant(glm::mat3(_model))));
+		selectNear(camera, modelScale);
+	}
+	mPoints->cull(proj, view, _model, cameraPos);
+	OLDSceneComponent::render(proj, view, model, cameraPos, renderCb, resizeCb);
+	if (!mNear.empty())
+		mMeshes->render(proj, view, _model, cameraPos, renderCb, resizeCb);
+}
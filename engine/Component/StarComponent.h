@@ -0,0 +1,126 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include "OWSceneComponent.h"
+#include <Core/RegionPager.h>
+#include <Helpers/Shader.h>
+#include <Renderers/InstanceRenderer.h>
+#include <Renderers/PointSpriteRenderer.h>
+
+class OLDActor;
+
+struct OWENGINE_API StarComponentData: public OLDSceneComponentData
+{
+	// Shader for the point sprites (starPoints.v.glsl/starPoints.f.glsl)
+	ShaderData pointShaderData;
+	// Shader for the meshes of the near stars (as MeshComponentInstance)
+	ShaderData meshShaderData;
+	// Optional GPU cull of the points (starCull.v.glsl/starCull.g.glsl
+	// capturing culledStar and culledColour). Empty shaderV for no culling.
+	ShaderData cullShaderData;
+	std::vector<glm::vec3> mesh;
+	// xyz position, w magnitude
+	std::vector<glm::vec4> stars;
+	std::vector<glm::vec4> colours;
+	// The points of stars and of the regions are sent as 12 bytes a star,
+	// quantised positions and magnitudes and RGBA8 colours, instead of 32.
+	bool packPoints = true;
+	// Stars closer to the camera than this, in the units of stars, are
+	// drawn with the mesh. 0 for points only.
+	float nearDistance = 0.0f;
+	// The nearest ones are taken if more are in range.
+	size_t maxNearStars = 1024;
+	// If not 0 the stars are made on the GPU instead of taken from stars and
+	// colours (PointSpriteRenderer::setupProcedural). They are normally
+	// distributed about proceduralCentre with standard deviations
+	// proceduralSpread. Procedural stars are never culled or drawn as meshes.
+	GLsizei proceduralStars = 0;
+	int proceduralSeed = 0;
+	glm::vec3 proceduralCentre = { 0, 0, 0 };
+	glm::vec3 proceduralSpread = { 1, 1, 1 };
+	std::vector<glm::vec4> proceduralPalette;
+	// If not 0 the stars are taken from these instead
+	// (PointSpriteRenderer::setupCatalogue). They only need to last until
+	// init. Catalogue stars are never culled or drawn as meshes.
+	GLsizei catalogueStars = 0;
+	const float* cataloguePositions = nullptr;
+	const unsigned int* catalogueColours = nullptr;
+	// If set the stars are made by this a region at a time and paged in
+	// and out around the camera (RegionPager). Paged stars are never culled
+	// or drawn as meshes.
+	RegionPager::Loader regionLoader;
+	glm::vec3 regionSize = { 1, 1, 1 };
+	// With packPoints every region star must be inside this.
+	AABB regionBounds;
+	int regionLoadRadius = 2;
+	int regionKeepRadius = 3;
+	// Any more in a region are dropped.
+	GLsizei maxRegionStars = 256;
+	// Bytes of stars resident at once, which sets the number of regions.
+	size_t regionBudget = 16 << 20;
+	unsigned int regionUploadsPerFrame = 4;
+};
+
+/*
+	A star field drawn as point sprites (PointSpriteRenderer) except for the
+	few stars near the camera which are drawn as instances of a mesh. The
+	stars are bucketed in a grid of nearDistance cells so finding the near
+	ones each frame only looks at the 27 cells around the camera. The mesh
+	instances are only uploaded when the set of near stars changes.
+	With a cull shader the points are culled on the GPU every frame first.
+	With a region loader the points are paged in around the camera instead.
+*/
+class OWENGINE_API StarComponent: public OLDSceneComponent
+{
+protected:
+	StarComponentData* data() override
+	{
+		return static_cast<StarComponentData*>(OLDSceneComponent::data());
+	}
+public:
+	StarComponent(OLDActor* _owner, StarComponentData* _data)
+		: OLDSceneComponent(_owner, _data)
+	{}
+	const StarComponentData* constData() const override
+	{
+		return static_cast<const StarComponentData*>(OLDSceneComponent::constData());
+	}
+	void doInit() override;
+	void render(const glm::mat4& proj,
+		const glm::mat4& view,
+		const glm::mat4& model,
+		const glm::vec3& cameraPos,
+		RenderTypes::ShaderMutator renderCb = nullptr,
+		RenderTypes::ShaderResizer resizeCb = nullptr) override;
+	size_t nearStars() const { return mNear.size(); }
+	size_t residentRegions() const { return mPager ? mPager->residentRegions() : 0; }
+private:
+	void buildCells();
+	// Empty if there are more than MeshDataInstance::MaxPalette colours.
+	void buildPalette();
+	// camera is in the space of the stars; modelScale takes distances to
+	// view space.
+	void selectNear(const glm::vec3& camera, float modelScale);
+	glm::ivec3 cell(const glm::vec3& p) const;
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	PointSpriteRenderer* mPoints = nullptr;
+	InstanceRenderer* mMeshes = nullptr;
+	std::unique_ptr<RegionPager> mPager;
+	// Star indices in each cell
+	std::unordered_map<unsigned long long, std::vector<unsigned int>> mCells;
+	// Distance and index of the stars in range this frame
+	std::vector<std::pair<float, unsigned int>> mCandidates;
+	// Sorted indices of the stars drawn as meshes
+	std::vector<unsigned int> mNear;
+	std::vector<unsigned int> mSelected;
+	std::vector<glm::vec3> mNearPositions;
+	std::vector<glm::vec4> mNearColours;
+	// The distinct star colours and each star's index into them
+	std::vector<glm::vec4> mPalette;
+	std::vector<unsigned char> mColourIndices;
+	std::vector<unsigned char> mNearColourIndices;
+#pragma warning( pop )
+};
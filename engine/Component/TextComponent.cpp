@@ -3,9 +3,7 @@
 #include <math.h>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "../Renderers/TextRendererDynamic.h"
-#include "../Renderers/TextRendererStatic.h"
-#include "../Renderers/VAOBuffer.h"
+#include "../Renderers/BoundingBoxRenderer.h"
 #include "../Core/GlobalSettings.h"
 #include "../Helpers/Shader.h"
 
@@ -14,6 +12,14 @@ TextComponent::TextComponent(OLDActor* _owner, TextComponentData* _data)
 {
 }
 
+TextComponent::~TextComponent()
+{
+	if (mLabel != TextBatcher::NoLabel)
+		TextBatcher::remove(mLabel);
+	if (mBillboard != TextBillboardBatcher::NoLabel)
+		TextBillboardBatcher::remove(mBillboard);
+}
+
 void TextComponent::doInit()
 {
 	TextData* jfw = textData();
@@ -32,14 +38,16 @@ void TextComponent::doInit()
 	{
 		textData()->referencePos = TextData::PositionType(textData()->referencePos & 0x3);
 	}
-	TextRenderer* ren;
 	if (textData()->tdt == TextData::TextDisplayType::Dynamic)
-		ren = new TextRendererDynamic();
+	{
+		// Dynamic labels are instances expanded by the vertex shader.
+		mBillboard = TextBillboardBatcher::add(*textData(), scale(), data()->boundingBox);
+	}
 	else
-		ren = new TextRendererStatic();
-	ren->setup(this, glm::vec3(0));
-	data()->boundingBox = ren->bounds();
-	addRenderer(ren);
+	{
+		// Static labels share a buffer and draw call with the others in the same font.
+		mLabel = TextBatcher::add(*textData(), data()->boundingBox);
+	}
 	OLDSceneComponent::doInit();
 }
 
@@ -88,8 +96,11 @@ void TextComponent::render(const glm::mat4& proj,
 		glm::mat4 s1 = glm::scale(I, imp->mScale);
 		glm::mat4 t1 = glm::translate(I, imp->mTranslate);
 		glm::mat4 _model = t1 * r1 * s1;
-		mRenderer->render(proj, view, _model, cameraPos, renderCb, resizeCb);
-		if (mBoundingBoxRenderer != nullptr)
+		if (mLabel != TextBatcher::NoLabel)
+			TextBatcher::submit(mLabel, _model);
+		else if (mBillboard != TextBillboardBatcher::NoLabel)
+			TextBillboardBatcher::submit(mBillboard, _model);
+		if (mRenderBoundingBox)
 		{
 			if (ss == "Text:Enjoy it while you can.")
 			{
@@ -162,7 +173,8 @@ void TextComponent::render(const glm::mat4& proj,
 				glm::mat4 ortho = glm::ortho(0.0f, 800.0f, 0.0f, 600.0f, 0.1f, 100.0f);
 				*/
 				//mBoundingBoxRenderer->render(proj, view, model2, cameraPos, renderCb, resizeCb);
-				mBoundingBoxRenderer->render(proj, view, _model, cameraPos, renderCb, resizeCb);
+				BoundingBoxRenderer::submit(mOriginalBoundingBox, _model,
+					OWUtils::colour(OWUtils::SolidColours::BLACK));
 			}
 			else
 			{
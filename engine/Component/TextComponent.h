@@ -5,6 +5,8 @@
 
 #include <Component/OWSceneComponent.h>
 #include <Core/CommonUtils.h>
+#include <Renderers/TextBatcher.h>
+#include <Renderers/TextBillboardBatcher.h>
 
 struct OWENGINE_API TextData
 {
@@ -57,6 +59,7 @@ public:
 	}
 
 	TextComponent(OLDActor* _owner, TextComponentData* _data);
+	~TextComponent();
 
 	void render(const glm::mat4& proj,
 		const glm::mat4& view,
@@ -67,5 +70,9 @@ public:
 	void doInit() override;
 protected:
 private:
+	// Static text is drawn by the TextBatcher
+	TextBatcher::LabelId mLabel = TextBatcher::NoLabel;
+	// Dynamic text is drawn by the TextBillboardBatcher
+	TextBillboardBatcher::LabelId mBillboard = TextBillboardBatcher::NoLabel;
 	friend class TextRenderer;
 };
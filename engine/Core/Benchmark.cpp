@@ -0,0 +1,219 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+
+#include "ErrorHandling.h"
+#include "GPUProfiler.h"
+#include "LogStream.h"
+
+bool Benchmark::fromCommandLine(int argc, char* argv[], BenchmarkSettings& bs)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--benchmark")
+		{
+			bs.enabled = true;
+		}
+		else if (arg == "--frames" && hasValue)
+		{
+			bs.frames = static_cast<unsigned int>(std::stoul(argv[++i]));
+		}
+		else if (arg == "--size" && hasValue)
+		{
+			std::string wh = argv[++i];
+			size_t x = wh.find('x');
+			if (x == std::string::npos)
+				throw NMSException(std::stringstream() << "Bad --size [" << wh << "]. Use WxH\n");
+			bs.size = { std::stoul(wh.substr(0, x)), std::stoul(wh.substr(x + 1)) };
+		}
+		else if (arg == "--scene" && hasValue)
+		{
+			bs.scene = argv[++i];
+		}
+		else if (arg == "--png" && hasValue)
+		{
+			bs.png = argv[++i];
+		}
+		else if (arg == "--trace" && hasValue)
+		{
+			bs.trace = argv[++i];
+		}
+		else if (arg == "--gpu-csv" && hasValue)
+		{
+			bs.gpuCSV = argv[++i];
+		}
+	}
+	return bs.enabled;
+}
+
+BenchmarkSettings::CameraKey Benchmark::cameraAt(const BenchmarkSettings& bs,
+	const BenchmarkSettings::CameraKey& start, unsigned int frame)
+{
+	float t = bs.frames > 1 ? frame / static_cast<float>(bs.frames - 1) : 0.0f;
+	if (bs.cameraPath.empty())
+	{
+		const glm::mat4 I(1.0f);
+		glm::mat4 r = glm::rotate(I, t * glm::two_pi<float>(), glm::vec3(0, 1, 0));
+		return { start.lookAt + glm::vec3(r * glm::vec4(start.position - start.lookAt, 0)),
+			start.lookAt };
+	}
+	if (bs.cameraPath.size() == 1)
+		return bs.cameraPath[0];
+	float f = t * (bs.cameraPath.size() - 1);
+	size_t k = std::min(static_cast<size_t>(f), bs.cameraPath.size() - 2);
+	float a = f - k;
+	const BenchmarkSettings::CameraKey& k0 = bs.cameraPath[k];
+	const BenchmarkSettings::CameraKey& k1 = bs.cameraPath[k + 1];
+	return { glm::mix(k0.position, k1.position, a), glm::mix(k0.lookAt, k1.lookAt, a) };
+}
+
+static std::string statistics(std::vector<double> ms)
+{
+	if (ms.empty())
+		return "no samples";
+	std::sort(ms.begin(), ms.end());
+	auto at = [&ms](double p)
+	{
+		return ms[static_cast<size_t>(p / 100.0 * (ms.size() - 1) + 0.5)];
+	};
+	double mean = std::accumulate(ms.begin(), ms.end(), 0.0) / ms.size();
+	std::stringstream ss;
+	ss << "min " << ms.front() << " mean " << mean << " p50 " << at(50)
+		<< " p95 " << at(95) << " p99 " << at(99) << " max " << ms.back()
+		<< " ms over " << ms.size() << " frames";
+	return ss.str();
+}
+
+void Benchmark::report(const BenchmarkSettings& bs, const std::vector<double>& cpuMs)
+{
+	std::vector<double> gpuMs;
+	for (const std::vector<GPUProfiler::Result>& frame : GPUProfiler::history())
+	{
+		for (const GPUProfiler::Result& r : frame)
+		{
+			if (r.name == "Frame")
+				gpuMs.push_back(r.ms);
+		}
+	}
+	std::stringstream ss;
+	ss << "Benchmark [" << (bs.scene.empty() ? "current scene" : bs.scene) << "] "
+		<< bs.size.x << "x" << bs.size.y << "\n"
+		<< "  cpu: " << statistics(cpuMs) << "\n"
+		<< "  gpu: " << statistics(gpuMs) << "\n"
+		<< "  renderer: " << reinterpret_cast<const char*>(glGetString(GL_RENDERER)) << "\n";
+	LogStream(LogStreamLevel::ImportantInfo) << ss.str();
+	std::cout << ss.str();
+	if (!bs.gpuCSV.empty())
+		GPUProfiler::writeCSV(bs.gpuCSV);
+}
+
+// Minimal PNG writer: one IDAT of stored (uncompressed) deflate blocks.
+// Big but needs no zlib. https://www.w3.org/TR/png/
+static uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0)
+{
+	static std::array<uint32_t, 256> table = []()
+	{
+		std::array<uint32_t, 256> t;
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++)
+				c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			t[n] = c;
+		}
+		return t;
+	}();
+	crc = ~crc;
+	for (size_t i = 0; i < len; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void putBigEndian(std::vector<uint8_t>& v, uint32_t x)
+{
+	v.push_back(static_cast<uint8_t>(x >> 24));
+	v.push_back(static_cast<uint8_t>(x >> 16));
+	v.push_back(static_cast<uint8_t>(x >> 8));
+	v.push_back(static_cast<uint8_t>(x));
+}
+
+static void writeChunk(std::ofstream& out, const char* type, const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> chunk;
+	putBigEndian(chunk, static_cast<uint32_t>(data.size()));
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	// The CRC covers the type and data but not the length.
+	putBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+	out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+void Benchmark::savePNG(const std::filesystem::path& path, const glm::uvec2& size)
+{
+	std::vector<uint8_t> pixels(size.x * size.y * 4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+	// Scanlines top down, each with filter type 0.
+	const size_t rowBytes = size.x * 4;
+	std::vector<uint8_t> raw;
+	raw.reserve((rowBytes + 1) * size.y);
+	for (unsigned int y = 0; y < size.y; y++)
+	{
+		raw.push_back(0);
+		const uint8_t* row = &pixels[(size.y - 1 - y) * rowBytes];
+		raw.insert(raw.end(), row, row + rowBytes);
+	}
+
+	std::vector<uint8_t> idat = { 0x78, 0x01 };
+	const size_t MaxStored = 65535;
+	for (size_t pos = 0; pos < raw.size() || raw.empty(); pos += MaxStored)
+	{
+		size_t len = std::min(MaxStored, raw.size() - pos);
+		idat.push_back(pos + len == raw.size() ? 1 : 0);
+		idat.push_back(static_cast<uint8_t>(len));
+		idat.push_back(static_cast<uint8_t>(len >> 8));
+		idat.push_back(static_cast<uint8_t>(~len));
+		idat.push_back(static_cast<uint8_t>(~len >> 8));
+		idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+		if (raw.empty())
+			break;
+	}
+	uint32_t a = 1;
+	uint32_t b = 0;
+	for (uint8_t c : raw)
+	{
+		a = (a + c) % 65521;
+		b = (b + a) % 65521;
+	}
+	putBigEndian(idat, (b << 16) | a);
+
+	std::vector<uint8_t> ihdr;
+	putBigEndian(ihdr, size.x);
+	putBigEndian(ihdr, size.y);
+	// 8 bit RGBA, deflate, no filtering variants, not interlaced
+	ihdr.insert(ihdr.end(), { 8, 6, 0, 0, 0 });
+
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+		throw NMSException(std::stringstream() << "Benchmark cannot write [" << path << "]\n");
+	const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+	writeChunk(out, "IHDR", ihdr);
+	writeChunk(out, "IDAT", idat);
+	writeChunk(out, "IEND", {});
+	LogStream(LogStreamLevel::ImportantInfo) << "Benchmark final frame written to " << path << "\n";
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <filesystem>
+
+#include <glm/glm.hpp>
+
+#include "../OWEngine/OWEngine.h"
+
+/*
+	Settings for a headless benchmark run. GLApplication renders into an
+	offscreen framebuffer of an invisible window (on Linux with no display
+	GLFW's null platform with an EGL context is used, so Mesa llvmpipe
+	works) and Movie::runBenchmark() renders a fixed number of frames with a
+	fixed time step and a scripted camera, with no user input.
+	From the command line:
+		--benchmark [--frames n] [--size WxH] [--scene name]
+		[--png file] [--trace file] [--gpu-csv file]
+*/
+struct OWENGINE_API BenchmarkSettings
+{
+	struct CameraKey
+	{
+		glm::vec3 position;
+		glm::vec3 lookAt;
+	};
+	bool enabled = false;
+	unsigned int frames = 600;
+	glm::uvec2 size = { 1280, 720 };
+	// Empty means the scene that would have been current.
+	std::string scene;
+	// Keys are spread evenly over the frames. If there are none the camera
+	// orbits once around its starting lookAt point.
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	std::vector<CameraKey> cameraPath;
+#pragma warning( pop )
+	// Optional outputs.
+	std::filesystem::path png;
+	std::filesystem::path trace;
+	std::filesystem::path gpuCSV;
+};
+
+class OWENGINE_API Benchmark
+{
+public:
+	// Returns true (and fills bs) if --benchmark is on the command line.
+	static bool fromCommandLine(int argc, char* argv[], BenchmarkSettings& bs);
+	// Camera position and target at frame of frames.
+	static BenchmarkSettings::CameraKey cameraAt(const BenchmarkSettings& bs,
+				const BenchmarkSettings::CameraKey& start, unsigned int frame);
+	// Logs min/mean/p50/p95/p99/max of the CPU frame times and the GPU
+	// "Frame" scope times.
+	static void report(const BenchmarkSettings& bs, const std::vector<double>& cpuMs);
+	// Writes the bound read framebuffer as an RGBA PNG.
+	static void savePNG(const std::filesystem::path& path, const glm::uvec2& size);
+};
@@ -0,0 +1,150 @@
+#include "CPUProfiler.h"
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+#include "ErrorHandling.h"
+
+std::vector<CPUProfiler::Scope> CPUProfiler::mScopes;
+std::vector<size_t> CPUProfiler::mOpen;
+std::vector<CPUProfiler::Result> CPUProfiler::mResults;
+std::deque<double> CPUProfiler::mFrameTimes;
+OWUtils::Time::time_point CPUProfiler::mFrameStart = OWUtils::Time::now();
+OWUtils::Time::time_point CPUProfiler::mTraceStart;
+std::ofstream CPUProfiler::mTrace;
+bool CPUProfiler::mFirstEvent = true;
+size_t CPUProfiler::mSpirals = 0;
+
+static double toMs(OWUtils::Time::duration d)
+{
+	return std::chrono::duration<double, std::milli>(d).count();
+}
+
+static double toUs(OWUtils::Time::duration d)
+{
+	return std::chrono::duration<double, std::micro>(d).count();
+}
+
+// s as a quoted JSON string. Scope names come from callers and class names.
+static void writeJSONString(std::ostream& out, const char* s)
+{
+	out << '"';
+	for (; *s; s++)
+	{
+		unsigned char c = static_cast<unsigned char>(*s);
+		if (c == '"' || c == '\\')
+			out << '\\' << *s;
+		else if (c < 0x20)
+			out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+				<< static_cast<int>(c) << std::dec << std::setfill(' ');
+		else
+			out << *s;
+	}
+	out << '"';
+}
+
+void CPUProfiler::begin(const char* name)
+{
+	mOpen.push_back(mScopes.size());
+	mScopes.push_back({ name, static_cast<int>(mOpen.size()) - 1,
+		OWUtils::Time::now(), OWUtils::Time::time_point() });
+}
+
+void CPUProfiler::end()
+{
+	if (mOpen.empty())
+		throw NMSLogicException("CPUProfiler::end() without a begin().\n");
+	mScopes[mOpen.back()].end = OWUtils::Time::now();
+	mOpen.pop_back();
+}
+
+void CPUProfiler::endFrame()
+{
+	OWUtils::Time::time_point now = OWUtils::Time::now();
+	if (!mOpen.empty())
+	{
+		mOpen.clear();
+		mScopes.clear();
+		throw NMSLogicException("CPUProfiler::endFrame() with scopes still open.\n");
+	}
+	std::vector<Result> frameResults;
+	for (const Scope& s : mScopes)
+	{
+		auto iter = std::find_if(frameResults.begin(), frameResults.end(),
+			[&s](const Result& r) { return r.name == s.name; });
+		if (iter == frameResults.end())
+		{
+			Result r;
+			r.name = s.name;
+			r.depth = s.depth;
+			frameResults.push_back(r);
+			iter = frameResults.end() - 1;
+		}
+		iter->calls++;
+		iter->ms += toMs(s.end - s.begin);
+	}
+	mResults.swap(frameResults);
+
+	if (mTrace.is_open())
+	{
+		// Complete ("X") events. Chrome draws nesting from the times.
+		auto event = [](const char* name, OWUtils::Time::time_point begin,
+			OWUtils::Time::time_point end)
+		{
+			mTrace << (mFirstEvent ? "" : ",\n") << "{\"name\":";
+			writeJSONString(mTrace, name);
+			mTrace << ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+				<< toUs(begin - mTraceStart) << ",\"dur\":" << toUs(end - begin) << "}";
+			mFirstEvent = false;
+		};
+		event("Frame", mFrameStart, now);
+		for (const Scope& s : mScopes)
+			event(s.name, s.begin, s.end);
+	}
+	mScopes.clear();
+
+	if (mFrameTimes.size() == HistorySize)
+		mFrameTimes.pop_front();
+	mFrameTimes.push_back(toMs(now - mFrameStart));
+	mFrameStart = now;
+}
+
+double CPUProfiler::percentile(double p)
+{
+	if (mFrameTimes.empty())
+		return 0;
+	std::vector<double> sorted(mFrameTimes.begin(), mFrameTimes.end());
+	size_t n = static_cast<size_t>(std::clamp(p, 0.0, 100.0) / 100.0 * (sorted.size() - 1) + 0.5);
+	std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+	return sorted[n];
+}
+
+std::string CPUProfiler::summary()
+{
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(2) << "cpu p50/p95/p99: "
+		<< percentile(50) << "/" << percentile(95) << "/" << percentile(99) << "ms";
+	if (mSpirals)
+		ss << " spirals: " << mSpirals;
+	return ss.str();
+}
+
+void CPUProfiler::startTrace(const std::filesystem::path& path)
+{
+	stopTrace();
+	mTrace.open(path);
+	if (!mTrace)
+		throw NMSException(std::stringstream() << "CPUProfiler cannot write [" << path << "]\n");
+	mTrace << std::fixed << std::setprecision(1) << "{\"traceEvents\":[\n";
+	mTraceStart = OWUtils::Time::now();
+	mFirstEvent = true;
+}
+
+void CPUProfiler::stopTrace()
+{
+	if (!mTrace.is_open())
+		return;
+	mTrace << "\n]}\n";
+	mTrace.close();
+}
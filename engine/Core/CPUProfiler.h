@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <fstream>
+#include <filesystem>
+
+#include "../OWEngine/OWEngine.h"
+
+#include "CommonUtils.h"
+
+/*
+	Scoped CPU timers and frame time statistics for the main thread.
+		CPUTimerScope t("Render");
+	Scopes with the same name in a frame are summed as with GPUProfiler.
+	endFrame() (called by the Movie) closes the frame, keeps its length for
+	the percentiles and, if a trace is running, writes the frame's scopes as
+	Chrome trace events (load the file in chrome://tracing or Perfetto).
+	Not thread safe; only time the main thread.
+*/
+class OWENGINE_API CPUProfiler
+{
+public:
+	// Frames kept for the percentiles.
+	static constexpr size_t HistorySize = 1000;
+	struct Result
+	{
+		std::string name;
+		int depth = 0;
+		unsigned int calls = 0;
+		double ms = 0;
+	};
+
+	static void begin(const char* name);
+	static void end();
+	static void endFrame();
+	// Count a frame where the fixed time step could not keep up.
+	static void spiral() { mSpirals++; }
+	static size_t spirals() { return mSpirals; }
+
+	// The last completed frame in scope order.
+	static const std::vector<Result>& results() { return mResults; }
+	// p in [0, 100] over the last HistorySize frames.
+	static double percentile(double p);
+	static const std::deque<double>& frameTimes() { return mFrameTimes; }
+	// Frame time percentiles for the window title.
+	static std::string summary();
+
+	static void startTrace(const std::filesystem::path& path);
+	static void stopTrace();
+	static bool tracing() { return mTrace.is_open(); }
+private:
+	struct Scope
+	{
+		const char* name;
+		int depth;
+		OWUtils::Time::time_point begin;
+		OWUtils::Time::time_point end;
+	};
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	static std::vector<Scope> mScopes;
+	static std::vector<size_t> mOpen;
+	static std::vector<Result> mResults;
+	static std::deque<double> mFrameTimes;
+	static OWUtils::Time::time_point mFrameStart;
+	static OWUtils::Time::time_point mTraceStart;
+	static std::ofstream mTrace;
+	static bool mFirstEvent;
+	static size_t mSpirals;
+#pragma warning( pop )
+};
+
+class OWENGINE_API CPUTimerScope
+{
+public:
+	// name must outlive the frame (a literal is best).
+	CPUTimerScope(const char* name)
+	{
+		CPUProfiler::begin(name);
+	}
+	~CPUTimerScope()
+	{
+		CPUProfiler::end();
+	}
+};
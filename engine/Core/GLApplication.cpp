@@ -5,7 +5,9 @@
 OWENGINE_API GlobalSettings* globals = nullptr;
 
 #include <algorithm>
+#include <cstdlib>
 
+#include "Benchmark.h"
 #include "ErrorHandling.h"
 #include "Logger.h"
 #include "LogStream.h"
@@ -14,6 +16,7 @@ OWENGINE_API GlobalSettings* globals = nullptr;
 #include "GlobalSettings.h"
 #include "Movie.h"
 #include "../Cameras/Camera.h"
+#include "../Renderers/GLStateCache.h"
 
 #pragma comment( lib, "glfw3.lib" )
 #pragma comment (lib, "OpenGL32.lib")
@@ -43,6 +46,15 @@ void GLApplication::init(Movie* movie, UserInput* ui, MacroRecorder* recorder,
 						SaveAndRestore* saveRestore, Camera* camera)
 {
 	globals->mPhysicalWindowSize = saveRestore->physicalWindowSize();
+	if (mBenchmark)
+	{
+		globals->mPhysicalWindowSize = mBenchmark->size;
+#if defined(__linux__) && defined(GLFW_PLATFORM_NULL)
+		// No display server at all (e.g. a CI box with Mesa llvmpipe)
+		if (!getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY"))
+			glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+	}
 	if (glfwInit())
 	{
 		// https://antongerdelan.net/opengl/glcontext2.html
@@ -57,6 +69,14 @@ void GLApplication::init(Movie* movie, UserInput* ui, MacroRecorder* recorder,
 #endif
 
 		glfwWindowHint(GLFW_SAMPLES, 4); // anti- aliasing. 16 for really high
+		if (mBenchmark)
+		{
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#if defined(__linux__) && defined(GLFW_PLATFORM_NULL)
+			if (glfwGetPlatform() == GLFW_PLATFORM_NULL)
+				glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+		}
 
 #ifdef SECOND_MONITOR_WINDOW
 		int count;
@@ -74,9 +94,12 @@ void GLApplication::init(Movie* movie, UserInput* ui, MacroRecorder* recorder,
 		{
 			throw NMSException("Could not create OpenGL window.");
 		}
-		glfwSetWindowMonitor(mWindow, NULL, 2000, 200, 
-			globals->mPhysicalWindowSize.x,
-			globals->mPhysicalWindowSize.y, GLFW_DONT_CARE);
+		if (!mBenchmark)
+		{
+			glfwSetWindowMonitor(mWindow, NULL, 2000, 200,
+				globals->mPhysicalWindowSize.x,
+				globals->mPhysicalWindowSize.y, GLFW_DONT_CARE);
+		}
 #endif
 		glfwMakeContextCurrent(mWindow);
 		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -86,8 +109,11 @@ void GLApplication::init(Movie* movie, UserInput* ui, MacroRecorder* recorder,
 		//glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 		// tell GL to only draw onto a pixel if the shape is closer to the viewer
-		glEnable(GL_DEPTH_TEST); // enable depth-testing
-		glDepthFunc(GL_LEQUAL); // depth-testing interprets a smaller value as "closer"
+		if (mBenchmark)
+			createOffscreenTarget();
+		GLStateCache::invalidate();
+		GLStateCache::depthTest(true); // enable depth-testing
+		GLStateCache::depthFunc(GL_LEQUAL); // depth-testing interprets a smaller value as "closer"
 
 		// mFrameBufferSize and mWindowSize may differ. See:
 		// (https://stackoverflow.com/questions/45796287/screen-coordinates-to-world-coordinates)
@@ -106,6 +132,9 @@ void GLApplication::init(Movie* movie, UserInput* ui, MacroRecorder* recorder,
 
 		catch (const std::exception& ex)
 		{
+			// Nobody is there to press a key.
+			if (mBenchmark)
+				throw;
 			std::cout << ex.what() << " press any key\n";
 			int ch;
 			std::cin >> ch;
@@ -123,11 +152,44 @@ void GLApplication::run(Movie* movie)
 {
 	backgroundColour(mBackgroundColour, mBackgroundColourMask);
 	movie->preRun();
-	movie->run(mUserInput, mWindow);
+	if (mBenchmark)
+	{
+		movie->runBenchmark(mWindow, *mBenchmark);
+		if (!mBenchmark->png.empty())
+			Benchmark::savePNG(mBenchmark->png, mBenchmark->size);
+		glDeleteRenderbuffers(2, mOffscreenRbo);
+		glDeleteFramebuffers(1, &mOffscreenFbo);
+	}
+	else
+	{
+		movie->run(mUserInput, mWindow);
+	}
 	glfwDestroyWindow(mWindow);
 	glfwTerminate();
 }
 
+void GLApplication::createOffscreenTarget()
+{
+	// Single sampled so the final frame can be read back directly.
+	GLsizei w = mBenchmark->size.x;
+	GLsizei h = mBenchmark->size.y;
+	glGenRenderbuffers(2, mOffscreenRbo);
+	glBindRenderbuffer(GL_RENDERBUFFER, mOffscreenRbo[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+	glBindRenderbuffer(GL_RENDERBUFFER, mOffscreenRbo[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenFramebuffers(1, &mOffscreenFbo);
+	// Stays bound (for drawing and reading) for the whole run.
+	glBindFramebuffer(GL_FRAMEBUFFER, mOffscreenFbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+		GL_RENDERBUFFER, mOffscreenRbo[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+		GL_RENDERBUFFER, mOffscreenRbo[1]);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		throw NMSException("GLApplication offscreen framebuffer is incomplete.");
+}
+
 void APIENTRY glDebugOutput(GLenum source, GLenum type, unsigned int id, GLenum severity,
 	GLsizei length, const char *message, const void *userParam)
 {}
@@ -27,6 +27,7 @@ class SaveAndRestore;
 class UserInput;
 class GlobalSettings;
 class Camera;
+struct BenchmarkSettings;
 
 class OWENGINE_API GLApplication
 {
@@ -37,6 +38,8 @@ public:
 	void init(Movie* movie, UserInput* ui, MacroRecorder* recorder, 
 			SaveAndRestore* saveRestore, Camera* camera);
 	void run(Movie* movieSaveAndRestore);
+	// Call before init() to run headless (see BenchmarkSettings).
+	void benchmark(const BenchmarkSettings* bs) { mBenchmark = bs; }
 	void setWindowSize(const glm::uvec2& size);
 	void errorReporting(int error, const char* description);
 	void onDebugMessageCallback(GLenum source, GLenum type, GLuint id,
@@ -62,6 +65,12 @@ private:
 	// commands to logical commands. UserInput could be subclassed to handle different
 	// types of physical systems.
 	UserInput* mUserInput;
+	const BenchmarkSettings* mBenchmark = nullptr;
+	// The offscreen framebuffer used when headless and its colour and
+	// depth/stencil renderbuffers.
+	unsigned int mOffscreenFbo = 0;
+	unsigned int mOffscreenRbo[2] = { 0, 0 };
+	void createOffscreenTarget();
 	glm::vec3 screenToWorld(GLFWwindow* window, double xpos, double ypos) const;
 
 	void enableCallbacks(); 
@@ -0,0 +1,205 @@
+#include "GPUProfiler.h"
+
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+#include <json/single_include/nlohmann/json.hpp>
+
+#include "ErrorHandling.h"
+
+bool GPUProfiler::mEnabled = false;
+bool GPUProfiler::mComponentScopes = false;
+GPUProfiler::Frame GPUProfiler::mFrames[GPUProfiler::FrameLag];
+unsigned int GPUProfiler::mCurrent = 0;
+std::vector<size_t> GPUProfiler::mOpen;
+std::vector<GPUProfiler::Result> GPUProfiler::mResults;
+std::deque<std::vector<GPUProfiler::Result>> GPUProfiler::mHistory;
+size_t GPUProfiler::mHistorySize = GPUProfiler::DefaultHistorySize;
+size_t GPUProfiler::mFrameNumber = 0;
+unsigned int GPUProfiler::mDropped = 0;
+
+// Weight of the newest frame in Result::averageMs
+static const double Smoothing = 0.1;
+
+// A quoted CSV field with any quotes in it doubled (RFC 4180).
+template<typename T>
+static std::string csvField(const T& value)
+{
+	std::stringstream ss;
+	ss << value;
+	std::string s = ss.str();
+	std::string retval = "\"";
+	for (char c : s)
+	{
+		if (c == '"')
+			retval += '"';
+		retval += c;
+	}
+	return retval + "\"";
+}
+
+void GPUProfiler::historySize(size_t frames)
+{
+	if (frames == 0)
+		throw NMSLogicException("GPUProfiler::historySize() must keep a frame.\n");
+	mHistorySize = frames;
+	while (mHistory.size() > mHistorySize)
+		mHistory.pop_front();
+}
+
+GLuint GPUProfiler::nextQuery(Frame& f)
+{
+	// Query objects are kept and reused each time round the ring.
+	if (f.used == f.queries.size())
+	{
+		size_t grow = std::max(size_t(64), f.queries.size());
+		f.queries.resize(f.queries.size() + grow);
+		glGenQueries(static_cast<GLsizei>(grow), &f.queries[f.used]);
+	}
+	return f.queries[f.used++];
+}
+
+void GPUProfiler::begin(const char* name)
+{
+	Frame& f = mFrames[mCurrent];
+	Scope s;
+	s.name = name;
+	s.depth = static_cast<int>(mOpen.size());
+	s.begin = nextQuery(f);
+	s.end = 0;
+	glQueryCounter(s.begin, GL_TIMESTAMP);
+	mOpen.push_back(f.scopes.size());
+	f.scopes.push_back(s);
+}
+
+void GPUProfiler::end()
+{
+	if (mOpen.empty())
+		throw NMSLogicException("GPUProfiler::end() without a begin().\n");
+	Frame& f = mFrames[mCurrent];
+	Scope& s = f.scopes[mOpen.back()];
+	mOpen.pop_back();
+	s.end = nextQuery(f);
+	glQueryCounter(s.end, GL_TIMESTAMP);
+}
+
+void GPUProfiler::collect(Frame& f)
+{
+	if (f.scopes.empty())
+		return;
+	// The last query issued is the last to complete.
+	GLint available = 0;
+	glGetQueryObjectiv(f.queries[f.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+	{
+		mDropped++;
+		return;
+	}
+	std::vector<Result> frameResults;
+	for (const Scope& s : f.scopes)
+	{
+		GLuint64 t0 = 0;
+		GLuint64 t1 = 0;
+		glGetQueryObjectui64v(s.begin, GL_QUERY_RESULT, &t0);
+		glGetQueryObjectui64v(s.end, GL_QUERY_RESULT, &t1);
+		double ms = (t1 - t0) / 1.0e6;
+		auto iter = std::find_if(frameResults.begin(), frameResults.end(),
+			[&s](const Result& r) { return r.name == s.name; });
+		if (iter == frameResults.end())
+		{
+			Result r;
+			r.name = s.name;
+			r.depth = s.depth;
+			frameResults.push_back(r);
+			iter = frameResults.end() - 1;
+		}
+		iter->calls++;
+		iter->ms += ms;
+	}
+	for (Result& r : frameResults)
+	{
+		auto prev = std::find_if(mResults.begin(), mResults.end(),
+			[&r](const Result& p) { return p.name == r.name; });
+		r.averageMs = prev == mResults.end()
+			? r.ms : prev->averageMs + (r.ms - prev->averageMs) * Smoothing;
+	}
+	mResults.swap(frameResults);
+	if (mHistory.size() >= mHistorySize)
+		mHistory.pop_front();
+	mHistory.push_back(mResults);
+}
+
+void GPUProfiler::endFrame()
+{
+	mFrameNumber++;
+	if (!mOpen.empty())
+	{
+		mOpen.clear();
+		throw NMSLogicException("GPUProfiler::endFrame() with scopes still open.\n");
+	}
+	mCurrent = (mCurrent + 1) % FrameLag;
+	// This slot was filled FrameLag frames ago.
+	Frame& f = mFrames[mCurrent];
+	collect(f);
+	f.scopes.clear();
+	f.used = 0;
+}
+
+std::string GPUProfiler::summary(size_t n)
+{
+	if (mResults.empty())
+		return "";
+	double total = 0;
+	for (const Result& r : mResults)
+	{
+		if (r.depth == 0)
+			total += r.averageMs;
+	}
+	std::vector<const Result*> sorted;
+	for (const Result& r : mResults)
+		sorted.push_back(&r);
+	std::sort(sorted.begin(), sorted.end(),
+		[](const Result* a, const Result* b) { return a->averageMs > b->averageMs; });
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(2) << "gpu: " << total << "ms";
+	for (size_t i = 0; i < std::min(n, sorted.size()); i++)
+		ss << " " << sorted[i]->name << " " << sorted[i]->averageMs;
+	return ss.str();
+}
+
+void GPUProfiler::writeCSV(const std::filesystem::path& path)
+{
+	std::ofstream out(path);
+	if (!out)
+		throw NMSException(std::stringstream() << "GPUProfiler cannot write [" << path << "]\n");
+	out << "frame,scope,depth,calls,ms\n";
+	for (size_t i = 0; i < mHistory.size(); i++)
+	{
+		for (const Result& r : mHistory[i])
+		{
+			out << csvField(i) << "," << csvField(r.name) << "," << csvField(r.depth)
+				<< "," << csvField(r.calls) << "," << csvField(r.ms) << "\n";
+		}
+	}
+}
+
+void GPUProfiler::writeJSON(const std::filesystem::path& path)
+{
+	std::ofstream out(path);
+	if (!out)
+		throw NMSException(std::stringstream() << "GPUProfiler cannot write [" << path << "]\n");
+	nlohmann::json frames = nlohmann::json::array();
+	for (const std::vector<Result>& frame : mHistory)
+	{
+		nlohmann::json scopes = nlohmann::json::array();
+		for (const Result& r : frame)
+		{
+			scopes.push_back({ { "scope", r.name }, { "depth", r.depth },
+				{ "calls", r.calls }, { "ms", r.ms } });
+		}
+		frames.push_back(scopes);
+	}
+	out << frames.dump(2) << "\n";
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <filesystem>
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+
+#include "../OWEngine/OWEngine.h"
+
+/*
+	Measures GPU time of named scopes with timer queries. Each scope writes a
+	GL_TIMESTAMP at its start and end (rather than using GL_TIME_ELAPSED which
+	cannot nest). The queries of a frame are read back FrameLag frames later
+	when the GPU has long finished with them, so the CPU never waits. A frame
+	whose queries are still not ready is dropped rather than waited for.
+	Scopes with the same name in a frame are summed. Use GPUProfileScope:
+		GPUProfileScope gp("Scene");
+	The Movie wraps the scene and batch flushes and RendererBase wraps every
+	render() with the renderer's class name.
+	Off by default, as every render() then costs two queries. The
+	ToggleGPUProfiler key turns it on and off and the benchmark turns it on.
+*/
+class OWENGINE_API GPUProfiler
+{
+public:
+	static constexpr unsigned int FrameLag = 3;
+	// Frames kept for writeCSV()/writeJSON() unless historySize() is set.
+	static constexpr size_t DefaultHistorySize = 600;
+	struct Result
+	{
+		std::string name;
+		// Nesting depth of the first scope with this name.
+		int depth = 0;
+		unsigned int calls = 0;
+		double ms = 0;
+		// Exponentially smoothed over the frames.
+		double averageMs = 0;
+	};
+
+	static void enabled(bool on) { mEnabled = on; }
+	static bool enabled() { return mEnabled; }
+	// Also time each scene component. Off by default as there are many.
+	static void componentScopes(bool on) { mComponentScopes = on; }
+	static bool componentScopes() { return mComponentScopes; }
+	// Frames kept in history(), e.g. all the frames of a benchmark.
+	static void historySize(size_t frames);
+	static size_t historySize() { return mHistorySize; }
+
+	static void begin(const char* name);
+	static void end();
+	// Called once a frame after the buffer swap.
+	static void endFrame();
+
+	// The most recently read back frame in scope order.
+	static const std::vector<Result>& results() { return mResults; }
+	static unsigned int droppedFrames() { return mDropped; }
+	// The last historySize() frames read back, oldest first.
+	static const std::deque<std::vector<Result>>& history() { return mHistory; }
+	// The total and the top n scopes for the window title.
+	static std::string summary(size_t n = 3);
+	// One row per frame and scope.
+	static void writeCSV(const std::filesystem::path& path);
+	static void writeJSON(const std::filesystem::path& path);
+private:
+	struct Scope
+	{
+		std::string name;
+		int depth;
+		GLuint begin;
+		GLuint end;
+	};
+	struct Frame
+	{
+		std::vector<Scope> scopes;
+		std::vector<GLuint> queries;
+		size_t used = 0;
+	};
+	static GLuint nextQuery(Frame& f);
+	static void collect(Frame& f);
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	static bool mEnabled;
+	static bool mComponentScopes;
+	static Frame mFrames[FrameLag];
+	static unsigned int mCurrent;
+	static std::vector<size_t> mOpen;
+	static std::vector<Result> mResults;
+	static std::deque<std::vector<Result>> mHistory;
+	static size_t mHistorySize;
+	static size_t mFrameNumber;
+	static unsigned int mDropped;
+#pragma warning( pop )
+};
+
+class OWENGINE_API GPUProfileScope
+{
+public:
+	GPUProfileScope(const char* name, bool active = true)
+		: mActive(active && GPUProfiler::enabled())
+	{
+		if (mActive)
+			GPUProfiler::begin(name);
+	}
+	~GPUProfileScope()
+	{
+		if (mActive)
+			GPUProfiler::end();
+	}
+private:
+	bool mActive;
+};
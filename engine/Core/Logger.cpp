@@ -9,8 +9,13 @@
 #endif
 
 #include "CommonUtils.h"
+#include "CPUProfiler.h"
+#include "GPUProfiler.h"
 #include "LogStream.h"
 
+#include "../Renderers/GLStateCache.h"
+#include "../Renderers/InstanceRenderer.h"
+
 OWUtils::Time::time_point Logger::previous_seconds;
 const static OWUtils::Time::duration gInterval = std::chrono::milliseconds(1000);
 int Logger::frame_count = 0;
@@ -29,7 +34,12 @@ void Logger::update_fps_counter(GLFWwindow* window) const
 		OWUtils::Float xx = std::chrono::duration<float>(elapsed).count();
 		unsigned int fps = static_cast<unsigned int>(frame_count / xx);
 		std::stringstream ss;
-		ss << "opengl @ fps: " << fps << "\n";
+		ss << "opengl @ fps: " << fps
+			<< " state calls elided/issued: " << GLStateCache::lastFrameElided()
+			<< "/" << GLStateCache::lastFrameIssued()
+			<< " instance bytes: " << InstanceRenderer::lastFrameBytesUploaded()
+			<< " " << CPUProfiler::summary()
+			<< " " << GPUProfiler::summary() << "\n";
 		glfwSetWindowTitle(window, ss.str().c_str());
 		frame_count = 0;
 	}
@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+
+#if _WIN32 || _WIN64
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ErrorHandling.h"
+
+#if _WIN32 || _WIN64
+MappedFile::MappedFile(const std::string& fileName)
+{
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+		nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw NMSException(std::stringstream() << "File [" << fileName << "] not loaded.");
+	mFile = file;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		throw NMSException(std::stringstream() << "File [" << fileName << "] has no size.");
+	}
+	mSize = static_cast<size_t>(size.QuadPart);
+	// An empty file cannot be mapped but is a valid (empty) view.
+	if (mSize == 0)
+		return;
+	mMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMapping != nullptr)
+		mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mData == nullptr)
+	{
+		if (mMapping != nullptr)
+			CloseHandle(mMapping);
+		CloseHandle(file);
+		throw NMSException(std::stringstream() << "File [" << fileName << "] could not be mapped.");
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+	if (mMapping != nullptr)
+		CloseHandle(mMapping);
+	if (mFile != nullptr)
+		CloseHandle(mFile);
+}
+#else
+MappedFile::MappedFile(const std::string& fileName)
+{
+	mFile = open(fileName.c_str(), O_RDONLY);
+	if (mFile == -1)
+		throw NMSException(std::stringstream() << "File [" << fileName << "] not loaded.");
+	struct stat st;
+	if (fstat(mFile, &st) != 0)
+	{
+		close(mFile);
+		throw NMSException(std::stringstream() << "File [" << fileName << "] has no size.");
+	}
+	mSize = static_cast<size_t>(st.st_size);
+	// An empty file cannot be mapped but is a valid (empty) view.
+	if (mSize == 0)
+		return;
+	void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (data == MAP_FAILED)
+	{
+		close(mFile);
+		throw NMSException(std::stringstream() << "File [" << fileName << "] could not be mapped.");
+	}
+	madvise(data, mSize, MADV_SEQUENTIAL);
+	mData = static_cast<const char*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+	if (mData != nullptr)
+		munmap(const_cast<char*>(mData), mSize);
+	if (mFile != -1)
+		close(mFile);
+}
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "../OWEngine/OWEngine.h"
+
+/*
+	A read only view of a whole file mapped into memory, so it can be parsed
+	in place with no copies. The mapping lasts as long as the object.
+	Throws NMSException if the file cannot be opened or mapped.
+*/
+class OWENGINE_API MappedFile
+{
+public:
+	MappedFile(const std::string& fileName);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	std::string_view view() const { return std::string_view(mData, mSize); }
+	size_t size() const { return mSize; }
+private:
+	const char* mData = nullptr;
+	size_t mSize = 0;
+#if _WIN32 || _WIN64
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#else
+	int mFile = -1;
+#endif
+};
@@ -1,15 +1,24 @@
 #include "Movie.h"
 
+#include <algorithm>
 #include <iostream>
 #include <thread>
 
 #include <GLFW/glfw3.h>
 
+#include "Benchmark.h"
+#include "CPUProfiler.h"
 #include "ErrorHandling.h"
+#include "GPUProfiler.h"
 #include "Logger.h"
 #include "LogStream.h"
 
 #include "../Cameras/Camera.h"
+#include "../Renderers/BoundingBoxRenderer.h"
+#include "../Renderers/GLStateCache.h"
+#include "../Renderers/InstanceRenderer.h"
+#include "../Renderers/TextBatcher.h"
+#include "../Renderers/TextBillboardBatcher.h"
 #ifndef __gl_h_
 #include <glad/glad.h>
 #endif
@@ -96,6 +105,11 @@ void Movie::run(UserInput* OW_UNUSED(ui), GLFWwindow* glfwWindow)
 	// Or is this already handled by the loop?
 	const OWUtils::Time::duration dt = std::chrono::milliseconds(hz/2);
 	const OWUtils::Time::duration clamp = dt * 8;
+	// More fixed updates than this in one frame means we are falling behind.
+	const int spiralSteps = 4;
+	// Frames in a row that fell behind. Only the start and end of a run
+	// are logged so a spiral does not flood the log.
+	unsigned int behindFrames = 0;
 
 	OWUtils::Time::duration t = std::chrono::seconds(0);
 	OWUtils::Time::time_point currentTime = OWUtils::Time::now();
@@ -111,15 +125,21 @@ void Movie::run(UserInput* OW_UNUSED(ui), GLFWwindow* glfwWindow)
 		OWUtils::Time::time_point newTime = OWUtils::Time::now();
 		OWUtils::Time::duration frameTime = newTime - currentTime;
 		currentTime = newTime;
-		if (frameTime > clamp)
+		bool clamped = frameTime > clamp;
+		if (clamped)
 			frameTime = clamp;
 		accumulator += frameTime;
 		globals->application()->clearBuffers();
+		int steps = 0;
 		while (accumulator >= dt)
 		{
 			mCurrent->logic.copyCurrentToPrevious();
 			t += dt;
-			processUserInput(nextSceneName, dt); 
+			{
+				CPUTimerScope ct("Input");
+				processUserInput(nextSceneName, dt);
+			}
+			CPUTimerScope ct("Fixed Update");
 			if (nextSceneName.empty())
 			{
 				mCurrent->logic.fixedUpdate(nextSceneName, dt);
@@ -134,35 +154,132 @@ void Movie::run(UserInput* OW_UNUSED(ui), GLFWwindow* glfwWindow)
 				mCurrent->logic.fixedUpdate(nextSceneName, dt);
 			}
 			accumulator -= dt;
+			steps++;
+		}
+		if (clamped || steps > spiralSteps)
+		{
+			CPUProfiler::spiral();
+			if (behindFrames++ == 0)
+			{
+				LogStream(LogStreamLevel::Warning) << "Frame fell behind. Fixed updates ["
+					<< steps << "] clamped [" << clamped << "]\n";
+			}
+		}
+		else if (behindFrames > 0)
+		{
+			LogStream(LogStreamLevel::Warning) << "Frames caught up after ["
+				<< behindFrames << "] behind.\n";
+			behindFrames = 0;
 		}
 
-		// logic()->interpolateRenderTarget will never change currentScene
-		mCurrent->logic.interpolateRenderTarget(t, accumulator, dt);
-		//OWUtils::Time::time_point beforeRender = OWUtils::HighTime::now();
-		render(mCurrent->logic.renderTarget());
-		globals->clearAspectRatioChangedFlag();
-		//OWUtils::Time::time_point afterRender = OWUtils::HighTime::now();
-		//OWUtils::Time::duration durr = afterRender - beforeRender;
-		//LogStream(LogStreamLevel::Info) << "Render Time [" << durr.count() << "]";
+		{
+			CPUTimerScope ct("Interpolate");
+			// logic()->interpolateRenderTarget will never change currentScene
+			mCurrent->logic.interpolateRenderTarget(t, accumulator, dt);
+		}
+		{
+			CPUTimerScope ct("Render");
+			render(mCurrent->logic.renderTarget());
+			globals->clearAspectRatioChangedFlag();
+		}
 
 		mCurrent->logic.clear();
-		// https://discourse.glfw.org/t/newbie-questions-trying-to-understand-glfwswapinterval/1287
-		// Best practice is to default glfwSwapInterval to '1'
-			// 0: do not wait for vsync(may be overridden by driver / driver settings)
-			// 1 : wait for 1st vsync(may be overridden by driver / driver settings)
-		glfwSwapInterval(mSwapInterval);
-		glfwSwapBuffers(glfwWindow);
-		do
 		{
-			glfwPollEvents();
-			if (globals->minimised())
-				std::this_thread::sleep_for(clamp);
-		} while (globals->minimised());
+			CPUTimerScope ct("Swap");
+			// https://discourse.glfw.org/t/newbie-questions-trying-to-understand-glfwswapinterval/1287
+			// Best practice is to default glfwSwapInterval to '1'
+				// 0: do not wait for vsync(may be overridden by driver / driver settings)
+				// 1 : wait for 1st vsync(may be overridden by driver / driver settings)
+			glfwSwapInterval(mSwapInterval);
+			glfwSwapBuffers(glfwWindow);
+		}
+		GLStateCache::endFrame();
+		InstanceRenderer::endFrame();
+		GPUProfiler::endFrame();
+		{
+			CPUTimerScope ct("Poll");
+			do
+			{
+				glfwPollEvents();
+				if (globals->minimised())
+					std::this_thread::sleep_for(clamp);
+			} while (globals->minimised());
+		}
+		CPUProfiler::endFrame();
 		if (!mIsRunning)
 		{ 
 			glfwSetWindowShouldClose(glfwWindow, true);
 		}
 	}
+	CPUProfiler::stopTrace();
+}
+
+void Movie::runBenchmark(GLFWwindow* OW_UNUSED(glfwWindow), const BenchmarkSettings& bs)
+{
+	if (!bs.scene.empty())
+		makeCurrent(bs.scene);
+	if (!mCurrent)
+	{
+		throw NMSLogicException(
+			"Error. Calling Movie::runBenchmark() without a current Scene.\n");
+	}
+	if (!bs.trace.empty())
+		CPUProfiler::startTrace(bs.trace);
+	// The report and --gpu-csv need the GPU times.
+	GPUProfiler::enabled(true);
+	// Room for every frame so the report and the CSV cover the whole run.
+	GPUProfiler::historySize(std::max(bs.frames, 1u));
+
+	// The same step as run() but exactly one per frame so every run
+	// simulates the same thing whatever the frame rate.
+	const OWUtils::Time::duration dt = std::chrono::milliseconds(1000 / 60 / 2);
+	OWUtils::Time::duration t = mCurrent->scene->cumulativeTime();
+	BenchmarkSettings::CameraKey start = { mCamera->position(), mCamera->lookAt() };
+	std::vector<double> cpuMs;
+	cpuMs.reserve(bs.frames);
+	// Scene changes asked for by the logic are ignored.
+	std::string nextSceneName;
+	for (unsigned int frame = 0; frame < bs.frames; frame++)
+	{
+		BenchmarkSettings::CameraKey key = Benchmark::cameraAt(bs, start, frame);
+		mCamera->position(key.position);
+		mCamera->lookAt(key.lookAt);
+
+		globals->application()->clearBuffers();
+		{
+			CPUTimerScope ct("Fixed Update");
+			mCurrent->logic.copyCurrentToPrevious();
+			t += dt;
+			mCurrent->logic.fixedUpdate(nextSceneName, dt);
+			nextSceneName.clear();
+		}
+		{
+			CPUTimerScope ct("Interpolate");
+			mCurrent->logic.interpolateRenderTarget(t, OWUtils::Time::duration(0), dt);
+		}
+		{
+			CPUTimerScope ct("Render");
+			render(mCurrent->logic.renderTarget());
+		}
+		mCurrent->logic.clear();
+		{
+			// Nothing to swap. The flush keeps the GPU busy as a swap would.
+			CPUTimerScope ct("Flush");
+			glFlush();
+		}
+		GLStateCache::endFrame();
+		InstanceRenderer::endFrame();
+		GPUProfiler::endFrame();
+		glfwPollEvents();
+		CPUProfiler::endFrame();
+		cpuMs.push_back(CPUProfiler::frameTimes().back());
+	}
+	glFinish();
+	// Read back the frames still in the GPU profiler's ring.
+	for (unsigned int i = 0; i < GPUProfiler::FrameLag; i++)
+		GPUProfiler::endFrame();
+	CPUProfiler::stopTrace();
+	Benchmark::report(bs, cpuMs);
 }
 
 void Movie::makeCurrent(const std::string& newSceneName)
@@ -217,7 +334,22 @@ void Movie::render(const ScenePhysicsState* state)
 	glm::mat4 projection = mCamera->projection();
 	glm::mat4 view = mCamera->view();
 	glm::vec3 pos = mCamera->position();
-	mCurrent->scene->render(state, projection, view, pos);
+	GPUProfileScope frame("Frame");
+	{
+		GPUProfileScope gp("Scene");
+		mCurrent->scene->render(state, projection, view, pos);
+	}
+	{
+		// One draw call per font for the static text the scene submitted.
+		GPUProfileScope gp("Text");
+		TextBatcher::flush(projection, view, pos);
+		TextBillboardBatcher::flush(projection, view, pos);
+	}
+	{
+		// All the boxes submitted by the scene in one draw call.
+		GPUProfileScope gp("Bounding Boxes");
+		BoundingBoxRenderer::flush(projection, view, pos);
+	}
 }
 
 void Movie::add(Scene* toAdd, ScenePhysicsState* sps, bool makeThisSceneCurrent)
@@ -254,7 +386,17 @@ void Movie::processUserInput(std::string& nextScene, OWUtils::Time::duration dt)
 	{
 		UserInput::AnyInput& input = mUserInput.front();
 		//LogStream(LogStreamLevel::Info) << "User Input [" << input.keyInput.userCommand << "]\n";
-		if (!mCurrent->logic.current->processUserCommands(input, nextScene, mCamera))
+		if (input.inputType == UserInput::AnyInputType::KeyPress
+			&& input.keyInput.userCommand == UserInput::LogicalOperator::ToggleGPUProfiler)
+		{
+			if (input.keyInput.action == UserInput::InputAction::Press)
+			{
+				GPUProfiler::enabled(!GPUProfiler::enabled());
+				LogStream(LogStreamLevel::Info) << "GPU profiler ["
+					<< (GPUProfiler::enabled() ? "on" : "off") << "]\n";
+			}
+		}
+		else if (!mCurrent->logic.current->processUserCommands(input, nextScene, mCamera))
 		{
 			mCamera->processInput(input, timeStep);
 		}
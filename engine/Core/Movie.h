@@ -19,6 +19,7 @@ struct GLFWwindow;
 class UserInput;
 class GLApplication;
 class MacroRecorder;
+struct BenchmarkSettings;
 /*
 	Core class providing the main Game loop. Tightly bound to the Scene and
 	ScenePhysicsState classes
@@ -29,6 +30,8 @@ public:
 	virtual void init(GLApplication* app, UserInput* ui, MacroRecorder* recorder);
 	virtual void preRun();
 	void run(UserInput* ui, GLFWwindow* glfw);
+	// Fixed frames and time step, scripted camera and no user input.
+	void runBenchmark(GLFWwindow* glfw, const BenchmarkSettings& bs);
 	virtual std::string windowTitle() const { return mWindowTitle; }
 	const Camera* camera() const { return mCamera; }
 	Camera* camera() { return mCamera; }
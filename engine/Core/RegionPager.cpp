@@ -0,0 +1,176 @@
+#include "RegionPager.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "ErrorHandling.h"
+
+#include "../Helpers/CellKey.h"
+
+
+RegionPager::RegionPager(Loader loader, const glm::vec3& regionSize,
+	int loadRadius, int keepRadius, unsigned int slots)
+	: mLoader(loader), mRegionSize(regionSize), mLoadRadius(loadRadius),
+	mKeepRadius(std::max(loadRadius, keepRadius)), mSlots(slots)
+{
+	if (!mLoader)
+		throw NMSLogicException("RegionPager has no loader.\n");
+	if (slots == 0)
+		throw NMSLogicException("RegionPager has no slots.\n");
+	// Handed out from the back so slot 0 goes first.
+	for (unsigned int i = slots; i > 0; i--)
+		mFreeSlots.push_back(i - 1);
+	mThread = std::thread(&RegionPager::work, this);
+}
+
+RegionPager::~RegionPager()
+{
+	{
+		std::lock_guard<std::mutex> guard(mMutex);
+		mStop = true;
+	}
+	mWake.notify_all();
+	mThread.join();
+}
+
+glm::ivec3 RegionPager::region(const glm::vec3& p) const
+{
+	return CellKey::cell(p, mRegionSize);
+}
+
+size_t RegionPager::queuedRegions() const
+{
+	std::lock_guard<std::mutex> guard(mMutex);
+	return mQueue.size();
+}
+
+void RegionPager::update(const glm::vec3& camera, unsigned int maxUploads,
+	Upload upload, Evict evict)
+{
+	glm::ivec3 centre = region(camera);
+	if (!mStarted || centre != mCentre)
+	{
+		mStarted = true;
+		mCentre = centre;
+		mMoves++;
+		requestAround(centre);
+	}
+
+	unsigned int uploads = 0;
+	while (uploads < maxUploads)
+	{
+		Region done;
+		{
+			std::lock_guard<std::mutex> guard(mMutex);
+			if (mDone.empty())
+				break;
+			done = std::move(mDone.front());
+			mDone.pop_front();
+		}
+		auto iter = mEntries.find(CellKey::key(done.key));
+		// Dropped or loaded twice while it was being made.
+		if (iter == mEntries.end() || iter->second.state != State::Queued)
+			continue;
+		unsigned int slot;
+		if (!mFreeSlots.empty())
+		{
+			slot = mFreeSlots.back();
+			mFreeSlots.pop_back();
+		}
+		else if (!evictOne(slot, evict))
+		{
+			// Everything resident is still wanted. It is asked for again
+			// when the camera moves and frees some.
+			continue;
+		}
+		iter->second.state = State::Resident;
+		iter->second.slot = slot;
+		upload(slot, done);
+		uploads++;
+	}
+}
+
+void RegionPager::requestAround(const glm::ivec3& centre)
+{
+	for (int z = -mKeepRadius; z <= mKeepRadius; z++)
+	{
+		for (int y = -mKeepRadius; y <= mKeepRadius; y++)
+		{
+			for (int x = -mKeepRadius; x <= mKeepRadius; x++)
+			{
+				glm::ivec3 r = centre + glm::ivec3(x, y, z);
+				bool load = std::abs(x) <= mLoadRadius && std::abs(y) <= mLoadRadius
+					&& std::abs(z) <= mLoadRadius;
+				auto iter = mEntries.find(CellKey::key(r));
+				if (iter != mEntries.end())
+					iter->second.lastWanted = mMoves;
+				else if (load)
+					mEntries[CellKey::key(r)] = { r, State::Queued, 0, mMoves };
+			}
+		}
+	}
+
+	// Queued regions the camera has left are forgotten. The rest are made
+	// nearest first.
+	std::vector<glm::ivec3> queue;
+	for (auto iter = mEntries.begin(); iter != mEntries.end();)
+	{
+		if (iter->second.state == State::Queued)
+		{
+			if (iter->second.lastWanted != mMoves)
+			{
+				iter = mEntries.erase(iter);
+				continue;
+			}
+			queue.push_back(iter->second.region);
+		}
+		++iter;
+	}
+	std::sort(queue.begin(), queue.end(), [centre](const glm::ivec3& a, const glm::ivec3& b)
+	{
+		glm::ivec3 da = a - centre;
+		glm::ivec3 db = b - centre;
+		return glm::dot(da, da) < glm::dot(db, db);
+	});
+	{
+		std::lock_guard<std::mutex> guard(mMutex);
+		mQueue.assign(queue.begin(), queue.end());
+	}
+	mWake.notify_one();
+}
+
+bool RegionPager::evictOne(unsigned int& slot, Evict& evict)
+{
+	auto oldest = mEntries.end();
+	for (auto iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		if (iter->second.state == State::Resident && iter->second.lastWanted != mMoves
+			&& (oldest == mEntries.end() || iter->second.lastWanted < oldest->second.lastWanted))
+			oldest = iter;
+	}
+	if (oldest == mEntries.end())
+		return false;
+	slot = oldest->second.slot;
+	mEntries.erase(oldest);
+	evict(slot);
+	return true;
+}
+
+void RegionPager::work()
+{
+	while (true)
+	{
+		Region r;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this] { return mStop || !mQueue.empty(); });
+			if (mStop)
+				return;
+			r.key = mQueue.front();
+			mQueue.pop_front();
+		}
+		mLoader(r);
+		std::lock_guard<std::mutex> guard(mMutex);
+		mDone.push_back(std::move(r));
+	}
+}
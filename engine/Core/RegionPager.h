@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../OWEngine/OWEngine.h"
+
+/*
+	Keeps the regions of space around the camera resident in a fixed number
+	of slots (e.g. ranges of a vertex buffer), so the whole of a large star
+	map is never in memory at once.
+	Regions within loadRadius of the camera's region are queued, nearest
+	first, and made by the loader on the pager's own thread. update() then
+	hands at most maxUploads finished regions a frame to upload so the
+	frame time stays flat while flying. Regions stay resident until they
+	are beyond keepRadius (the gap stops them being dropped and reloaded
+	when the camera sits on a boundary) and even then are only evicted,
+	least recently wanted first, when a new region needs their slot.
+	Regions are in the space of the camera position given to update().
+*/
+class OWENGINE_API RegionPager
+{
+public:
+	struct Region
+	{
+		glm::ivec3 key;
+		// xyz position, w magnitude
+		std::vector<glm::vec4> stars;
+		std::vector<glm::vec4> colours;
+	};
+	// Fills in the stars of region.key. Called on the pager's thread so it
+	// must not touch OpenGL or throw.
+	typedef std::function<void(Region& region)> Loader;
+	typedef std::function<void(unsigned int slot, const Region& region)> Upload;
+	typedef std::function<void(unsigned int slot)> Evict;
+
+	RegionPager(Loader loader, const glm::vec3& regionSize,
+			int loadRadius, int keepRadius, unsigned int slots);
+	~RegionPager();
+	RegionPager(const RegionPager&) = delete;
+	RegionPager& operator=(const RegionPager&) = delete;
+	// Call once a frame from the thread that owns the slots. evict is
+	// called for a slot before upload reuses it.
+	void update(const glm::vec3& camera, unsigned int maxUploads,
+			Upload upload, Evict evict);
+	glm::ivec3 region(const glm::vec3& p) const;
+	size_t residentRegions() const { return mSlots - mFreeSlots.size(); }
+	size_t queuedRegions() const;
+private:
+	enum class State { Queued, Resident };
+	struct Entry
+	{
+		glm::ivec3 region;
+		State state = State::Queued;
+		unsigned int slot = 0;
+		// mMoves when last within keepRadius
+		unsigned int lastWanted = 0;
+	};
+	void requestAround(const glm::ivec3& centre);
+	// The slot of the least recently wanted region not wanted now, or false.
+	bool evictOne(unsigned int& slot, Evict& evict);
+	void work();
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	Loader mLoader;
+	glm::vec3 mRegionSize;
+	int mLoadRadius;
+	int mKeepRadius;
+	unsigned int mSlots;
+	// Only used by update()
+	std::unordered_map<unsigned long long, Entry> mEntries;
+	std::vector<unsigned int> mFreeSlots;
+	glm::ivec3 mCentre = glm::ivec3(0);
+	bool mStarted = false;
+	// Counts the camera moving to a new region.
+	unsigned int mMoves = 0;
+	// Shared with the thread
+	mutable std::mutex mMutex;
+	std::condition_variable mWake;
+	std::deque<glm::ivec3> mQueue;
+	std::deque<Region> mDone;
+	bool mStop = false;
+	std::thread mThread;
+#pragma warning( pop )
+};
@@ -79,6 +79,7 @@ void UserInput::createLogicalOperatorStringMap()
 	addMapping(LogicalOperator::Special4, "Special4");
 	addMapping(LogicalOperator::Special5, "Special5");
 	addMapping(LogicalOperator::Special6, "Special6");
+	addMapping(LogicalOperator::ToggleGPUProfiler, "ToggleGPUProfiler");
 }
 
 void UserInput::createInputModStringMap()
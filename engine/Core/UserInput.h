@@ -52,7 +52,9 @@ public:
 		Accept,
 		WindowResize,
 		WindowClose,
-		Special1, Special2, Special3, Special4, Special5, Special6
+		Special1, Special2, Special3, Special4, Special5, Special6,
+		// Handled by the Movie in every scene.
+		ToggleGPUProfiler
 	};
 	enum InputAction
 	{
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/*
+	Grid cells as keys for hash maps. Each coordinate is offset by 2^20 and
+	packed into 21 bits of the key, so cells from -2^20 to 2^20 - 1 along
+	each axis have their own key.
+*/
+struct CellKey
+{
+	// The cell holding p in a grid of cells of size.
+	static glm::ivec3 cell(const glm::vec3& p, const glm::vec3& size)
+	{
+		return glm::ivec3(glm::floor(p / size));
+	}
+	static unsigned long long key(const glm::ivec3& c)
+	{
+		const int bias = 1 << 20;
+		const unsigned long long mask = (1ull << 21) - 1;
+		return ((static_cast<unsigned long long>(c.x + bias) & mask) << 42)
+			| ((static_cast<unsigned long long>(c.y + bias) & mask) << 21)
+			| (static_cast<unsigned long long>(c.z + bias) & mask);
+	}
+};
@@ -13,6 +13,8 @@
 #include "../Core/ErrorHandling.h"
 #include "../Core/LogStream.h"
 
+#include "../Renderers/GLStateCache.h"
+
 const FreeTypeFontAtlas::FontDetails* FreeTypeFontAtlas::loadFont(
 		const std::filesystem::path& path, int fontHeight)
 {
@@ -232,7 +234,7 @@ Texture FreeTypeFontAtlas::FontDetails::createGlyphBitmap(
 		rowHeight = std::max(rowHeight, g->bitmap.rows);
 		xOffset += g->bitmap.width + 1;
 	}
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::bindTexture(texture.imageUnit() - GL_TEXTURE0, GL_TEXTURE_2D, 0);
 	return texture;
 }
 
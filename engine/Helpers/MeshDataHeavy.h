@@ -40,6 +40,9 @@ struct MeshDataHeavy
 	std::vector<Vertex> vertices;
 	std::vector<unsigned int> indices;
 	std::vector<Texture> textures;
+	// Upload as 16 bit positions within bounds(), 2_10_10_10 normals and
+	// half float texture coordinates (16 bytes a vertex instead of 32).
+	bool compact = false;
 	void create(aiMesh *mesh, const aiScene *scene);
 	void calcNormals();
 	AABB bounds() const;
@@ -4,9 +4,25 @@
 
 #include <glm/glm.hpp>
 
+#include "../Geometry/BoundingBox.h"
+
+/*
+	The mesh and per instance positions and colours for the InstanceRenderer.
+	By default the instances are sent as they are given, vec3 positions and
+	vec4 colours (28 bytes an instance). positionFormat() and colourFormat()
+	pack them instead:
+	Quantised positions are three normalised unsigned shorts across the
+	bounds (6 bytes). RGBA8 colours are four normalised bytes (4 bytes).
+	PaletteIndex colours are one byte indexing up to MaxPalette colours
+	(1 byte), given with colourIndices() or matched from colours().
+*/
 class MeshDataInstance
 {
 public:
+	enum class PositionFormat { Float, Quantised };
+	enum class ColourFormat { Float, RGBA8, PaletteIndex };
+	static constexpr size_t MaxPalette = 16;
+
 	void vertices(const std::vector<glm::vec3>& v,
 		unsigned int vertexMode, unsigned int vertexLocation = 0)
 	{
@@ -39,9 +55,32 @@ public:
 		unsigned int colourLocation)
 	{
 		mInstanceColours = colours;
+		mInstanceColourIndices.clear();
+		mRenderData.colourDivisor = colourDivisor;
+		mRenderData.colourLocation = colourLocation;
+	}
+	// For ColourFormat::PaletteIndex
+	void colourIndices(const std::vector<unsigned char>& indices,
+		unsigned int colourDivisor,
+		unsigned int colourLocation)
+	{
+		mInstanceColours.clear();
+		mInstanceColourIndices = indices;
 		mRenderData.colourDivisor = colourDivisor;
 		mRenderData.colourLocation = colourLocation;
 	}
+	// Quantised positions must be inside bounds.
+	void positionFormat(PositionFormat format, const AABB& bounds = AABB())
+	{
+		mPositionFormat = format;
+		mPositionBounds = bounds;
+	}
+	void colourFormat(ColourFormat format,
+		const std::vector<glm::vec4>& palette = std::vector<glm::vec4>())
+	{
+		mColourFormat = format;
+		mPalette = palette;
+	}
 private:
 	struct RenderData
 	{
@@ -60,6 +99,11 @@ private:
 	std::vector<glm::vec4> mVec4;
 	std::vector<glm::vec3> mInstancePositions;
 	std::vector<glm::vec4> mInstanceColours;
+	std::vector<unsigned char> mInstanceColourIndices;
+	PositionFormat mPositionFormat = PositionFormat::Float;
+	AABB mPositionBounds;
+	ColourFormat mColourFormat = ColourFormat::Float;
+	std::vector<glm::vec4> mPalette;
 	RenderData mRenderData;
 	friend class InstanceRenderer;
 };
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <span>
 #include <string>
 #include <limits.h>
 
@@ -18,6 +19,15 @@ public:
 		mRenderData.vertexMode = vertexMode;
 		mRenderData.vertexLocation = vertexLocation;
 	}
+	void vertices(std::span<const glm::vec3> v,
+		unsigned int vertexMode, unsigned int vertexLocation = 0)
+	{
+		mVec4.clear();
+		mVec3.assign(v.begin(), v.end());
+		mRenderData.verticesCount = v.size();
+		mRenderData.vertexMode = vertexMode;
+		mRenderData.vertexLocation = vertexLocation;
+	}
 	void vertices(const std::vector<glm::vec4>& v,
 		unsigned int vertexMode, unsigned int vertexLocation = 0)
 	{
@@ -63,4 +73,5 @@ private:
 	RenderData mRenderData;
 	friend class LightRenderer;
 	friend class VAOBuffer;
+	friend class MeshOptimiser;
 };
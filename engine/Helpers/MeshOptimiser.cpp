@@ -0,0 +1,480 @@
+#include "MeshOptimiser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+#include "../Core/CommonUtils.h"
+#include "../Core/LogStream.h"
+
+#include "MeshDataHeavy.h"
+#include "MeshDataLight.h"
+
+// Forsyth's "Linear-Speed Vertex Cache Optimisation" constants.
+static const size_t ForsythCacheSize = 32;
+static const float CacheDecayPower = 1.5f;
+static const float LastTriScore = 0.75f;
+static const float ValenceBoostScale = 2.0f;
+static const float ValenceBoostPower = 0.5f;
+// Normals closer than about half a degree are welded.
+static const float NormalWeldCos = 0.99996f;
+
+static float forsythScore(int cachePosition, unsigned int remaining)
+{
+	if (remaining == 0)
+		return -1.0f;
+	float score = 0;
+	if (cachePosition >= 0)
+	{
+		// The last triangle's vertices get a fixed score so that the next
+		// triangle does not favour one edge of it over another.
+		if (cachePosition < 3)
+		{
+			score = LastTriScore;
+		}
+		else
+		{
+			const float scaler = 1.0f / (ForsythCacheSize - 3);
+			score = std::pow(1.0f - (cachePosition - 3) * scaler, CacheDecayPower);
+		}
+	}
+	// Vertices with few triangles left are finished off first.
+	score += ValenceBoostScale * std::pow(static_cast<float>(remaining), -ValenceBoostPower);
+	return score;
+}
+
+// Triangles with a repeated index have no area. Welding can make them.
+static void removeDegenerates(std::vector<unsigned int>& indices)
+{
+	size_t out = 0;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		unsigned int a = indices[i];
+		unsigned int b = indices[i + 1];
+		unsigned int c = indices[i + 2];
+		if (a == b || a == c || b == c)
+			continue;
+		indices[out++] = a;
+		indices[out++] = b;
+		indices[out++] = c;
+	}
+	indices.resize(out);
+}
+
+template<typename T>
+static std::vector<T> fetchOrder(const std::vector<T>& v,
+	const std::vector<unsigned int>& remap, size_t count)
+{
+	std::vector<T> retval(count);
+	for (size_t i = 0; i < v.size(); i++)
+	{
+		if (remap[i] != UINT_MAX)
+			retval[remap[i]] = v[i];
+	}
+	return retval;
+}
+
+static void logStats(const char* kind, const MeshOptimiser::Stats& s)
+{
+	LogStream(LogStreamLevel::Info) << "MeshOptimiser " << kind
+		<< " vertices [" << s.verticesBefore << " -> " << s.verticesAfter
+		<< "] ACMR [" << s.acmrBefore << " -> " << s.acmrAfter << "]\n";
+}
+
+float MeshOptimiser::acmr(const std::vector<unsigned int>& indices,
+	size_t vertexCount, size_t cacheSize)
+{
+	if (indices.size() < 3)
+		return 0;
+	// FIFO: a vertex is in the cache if fewer than cacheSize misses have
+	// happened since it was loaded.
+	std::vector<size_t> loaded(vertexCount, SIZE_MAX);
+	size_t misses = 0;
+	for (unsigned int v : indices)
+	{
+		if (loaded[v] == SIZE_MAX || misses - loaded[v] >= cacheSize)
+		{
+			loaded[v] = misses;
+			misses++;
+		}
+	}
+	return static_cast<float>(misses) / (indices.size() / 3);
+}
+
+std::vector<unsigned int> MeshOptimiser::weld(const std::vector<glm::vec3>& positions,
+	float tolerance, const std::function<bool(unsigned int, unsigned int)>& same,
+	std::vector<unsigned int>& remap)
+{
+	// Uniform grid of cells the size of the tolerance so only the 27 cells
+	// around a vertex need searching.
+	const float cellSize = std::max(tolerance, OWUtils::epsilon());
+	const float tolerance2 = tolerance * tolerance;
+	auto cellHash = [](const glm::ivec3& c)
+	{
+		return (static_cast<size_t>(c.x) * 73856093u)
+			^ (static_cast<size_t>(c.y) * 19349663u)
+			^ (static_cast<size_t>(c.z) * 83492791u);
+	};
+	// Hash -> welded vertices. Hash collisions only cost a comparison.
+	std::unordered_map<size_t, std::vector<unsigned int>> grid;
+	std::vector<unsigned int> unique;
+	remap.assign(positions.size(), 0);
+	for (unsigned int i = 0; i < positions.size(); i++)
+	{
+		const glm::vec3& p = positions[i];
+		glm::ivec3 cell = glm::ivec3(glm::floor(p / cellSize));
+		unsigned int found = UINT_MAX;
+		for (int dx = -1; dx <= 1 && found == UINT_MAX; dx++)
+		{
+			for (int dy = -1; dy <= 1 && found == UINT_MAX; dy++)
+			{
+				for (int dz = -1; dz <= 1 && found == UINT_MAX; dz++)
+				{
+					auto iter = grid.find(cellHash(cell + glm::ivec3(dx, dy, dz)));
+					if (iter == grid.end())
+						continue;
+					for (unsigned int u : iter->second)
+					{
+						glm::vec3 d = positions[unique[u]] - p;
+						if (glm::dot(d, d) <= tolerance2 && same(unique[u], i))
+						{
+							found = u;
+							break;
+						}
+					}
+				}
+			}
+		}
+		if (found == UINT_MAX)
+		{
+			found = static_cast<unsigned int>(unique.size());
+			unique.push_back(i);
+			grid[cellHash(cell)].push_back(found);
+		}
+		remap[i] = found;
+	}
+	return unique;
+}
+
+void MeshOptimiser::vertexCacheOrder(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+	const size_t triCount = indices.size() / 3;
+	if (triCount < 2)
+		return;
+
+	// Triangles using each vertex, packed. The first remaining[v] entries
+	// of a vertex's range are the triangles not yet output.
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for (unsigned int v : indices)
+		remaining[v]++;
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		offsets[v + 1] = offsets[v] + remaining[v];
+	std::vector<unsigned int> adjacency(indices.size());
+	{
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+			adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		vertexScore[v] = forsythScore(-1, remaining[v]);
+	std::vector<float> triScore(triCount);
+	std::vector<bool> emitted(triCount, false);
+	size_t best = 0;
+	for (size_t t = 0; t < triCount; t++)
+	{
+		triScore[t] = vertexScore[indices[t * 3]]
+			+ vertexScore[indices[t * 3 + 1]]
+			+ vertexScore[indices[t * 3 + 2]];
+		if (triScore[t] > triScore[best])
+			best = t;
+	}
+
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> newCache;
+	size_t cursor = 0;
+	for (size_t n = 0; n < triCount; n++)
+	{
+		if (best == SIZE_MAX)
+		{
+			// Nothing in the cache has triangles left so start anywhere.
+			while (emitted[cursor])
+				cursor++;
+			best = cursor;
+		}
+		emitted[best] = true;
+		const unsigned int* tri = &indices[best * 3];
+		newCache.assign(tri, tri + 3);
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int v = tri[k];
+			output.push_back(v);
+			// Move the triangle past the end of the vertex's live range.
+			unsigned int* begin = &adjacency[offsets[v]];
+			unsigned int* end = begin + remaining[v];
+			*std::find(begin, end, static_cast<unsigned int>(best)) = *(end - 1);
+			remaining[v]--;
+		}
+		for (unsigned int v : cache)
+		{
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache.push_back(v);
+		}
+		for (size_t i = 0; i < newCache.size(); i++)
+		{
+			unsigned int v = newCache[i];
+			cachePosition[v] = i < ForsythCacheSize ? static_cast<int>(i) : -1;
+			vertexScore[v] = forsythScore(cachePosition[v], remaining[v]);
+		}
+		// Only triangles touching the cache have changed score.
+		best = SIZE_MAX;
+		float bestScore = -1.0f;
+		for (unsigned int v : newCache)
+		{
+			for (unsigned int j = 0; j < remaining[v]; j++)
+			{
+				unsigned int t = adjacency[offsets[v] + j];
+				triScore[t] = vertexScore[indices[t * 3]]
+					+ vertexScore[indices[t * 3 + 1]]
+					+ vertexScore[indices[t * 3 + 2]];
+				if (triScore[t] > bestScore)
+				{
+					bestScore = triScore[t];
+					best = t;
+				}
+			}
+		}
+		if (newCache.size() > ForsythCacheSize)
+			newCache.resize(ForsythCacheSize);
+		cache.swap(newCache);
+	}
+	indices.swap(output);
+}
+
+void MeshOptimiser::overdrawOrder(std::vector<unsigned int>& indices,
+	const std::vector<glm::vec3>& positions, float threshold)
+{
+	const size_t triCount = indices.size() / 3;
+	if (triCount < 2)
+		return;
+
+	// Cut where the cache would be cold anyway (all three vertices miss) or,
+	// when the cluster is already cache efficient enough, at a triangle that
+	// misses twice.
+	const float target = acmr(indices, positions.size()) * threshold;
+	std::vector<size_t> clusterStarts;
+	std::vector<size_t> loaded(positions.size(), SIZE_MAX);
+	size_t misses = 0;
+	size_t clusterMisses = 0;
+	size_t clusterTris = 0;
+	for (size_t t = 0; t < triCount; t++)
+	{
+		size_t triMisses = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int v = indices[t * 3 + k];
+			if (loaded[v] == SIZE_MAX || misses - loaded[v] >= DefaultCacheSize)
+			{
+				loaded[v] = misses;
+				misses++;
+				triMisses++;
+			}
+		}
+		bool cut = clusterTris == 0 || triMisses == 3
+			|| (triMisses >= 2 && static_cast<float>(clusterMisses) / clusterTris <= target);
+		if (cut)
+		{
+			clusterStarts.push_back(t);
+			clusterMisses = 0;
+			clusterTris = 0;
+		}
+		clusterMisses += triMisses;
+		clusterTris++;
+	}
+	clusterStarts.push_back(triCount);
+	const size_t clusterCount = clusterStarts.size() - 1;
+	if (clusterCount < 2)
+		return;
+
+	// Area weighted centroid and normal of each cluster and of the mesh.
+	std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0));
+	std::vector<glm::vec3> normals(clusterCount, glm::vec3(0));
+	std::vector<float> areas(clusterCount, 0.0f);
+	glm::vec3 meshCentroid(0);
+	float meshArea = 0;
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+		{
+			const glm::vec3& a = positions[indices[t * 3]];
+			const glm::vec3& b = positions[indices[t * 3 + 1]];
+			const glm::vec3& d = positions[indices[t * 3 + 2]];
+			glm::vec3 n = glm::cross(b - a, d - a);
+			float area = glm::length(n);
+			centroids[c] += (a + b + d) * (area / 3.0f);
+			normals[c] += n;
+			areas[c] += area;
+		}
+		meshCentroid += centroids[c];
+		meshArea += areas[c];
+		if (areas[c] > 0)
+			centroids[c] /= areas[c];
+	}
+	if (meshArea > 0)
+		meshCentroid /= meshArea;
+
+	// Clusters further out along their normal tend to hide the others.
+	std::vector<float> keys(clusterCount, 0.0f);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		float len = glm::length(normals[c]);
+		if (len > 0)
+			keys[c] = glm::dot(centroids[c] - meshCentroid, normals[c] / len);
+	}
+	std::vector<size_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+		[&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+	for (size_t c : order)
+	{
+		output.insert(output.end(), indices.begin() + clusterStarts[c] * 3,
+			indices.begin() + clusterStarts[c + 1] * 3);
+	}
+	indices.swap(output);
+}
+
+size_t MeshOptimiser::vertexFetchOrder(std::vector<unsigned int>& indices,
+	size_t vertexCount, std::vector<unsigned int>& remap)
+{
+	remap.assign(vertexCount, UINT_MAX);
+	unsigned int next = 0;
+	for (unsigned int& v : indices)
+	{
+		if (remap[v] == UINT_MAX)
+			remap[v] = next++;
+		v = remap[v];
+	}
+	return next;
+}
+
+MeshOptimiser::Stats MeshOptimiser::optimise(MeshDataHeavy& mesh, float tolerance)
+{
+	Stats s;
+	s.verticesBefore = mesh.vertices.size();
+	s.verticesAfter = s.verticesBefore;
+	if (mesh.indices.size() < 3)
+		return s;
+	s.acmrBefore = acmr(mesh.indices, mesh.vertices.size());
+
+	std::vector<glm::vec3> positions;
+	positions.reserve(mesh.vertices.size());
+	for (const MeshDataHeavy::Vertex& v : mesh.vertices)
+		positions.push_back(v.position);
+	auto same = [&mesh](unsigned int a, unsigned int b)
+	{
+		const MeshDataHeavy::Vertex& va = mesh.vertices[a];
+		const MeshDataHeavy::Vertex& vb = mesh.vertices[b];
+		return glm::dot(va.normal, vb.normal) >= NormalWeldCos
+			&& glm::all(glm::lessThanEqual(glm::abs(va.textureCoord - vb.textureCoord),
+				glm::vec2(OWUtils::epsilon())));
+	};
+	std::vector<unsigned int> remap;
+	std::vector<unsigned int> unique = weld(positions, tolerance, same, remap);
+	std::vector<MeshDataHeavy::Vertex> welded;
+	welded.reserve(unique.size());
+	positions.clear();
+	for (unsigned int u : unique)
+	{
+		welded.push_back(mesh.vertices[u]);
+		positions.push_back(mesh.vertices[u].position);
+	}
+	for (unsigned int& i : mesh.indices)
+		i = remap[i];
+	removeDegenerates(mesh.indices);
+
+	vertexCacheOrder(mesh.indices, welded.size());
+	overdrawOrder(mesh.indices, positions);
+	size_t count = vertexFetchOrder(mesh.indices, welded.size(), remap);
+	mesh.vertices = fetchOrder(welded, remap, count);
+
+	s.verticesAfter = mesh.vertices.size();
+	s.acmrAfter = acmr(mesh.indices, mesh.vertices.size());
+	logStats("heavy mesh", s);
+	return s;
+}
+
+MeshOptimiser::Stats MeshOptimiser::optimise(MeshDataLight& mesh, bool normalPairs, float tolerance)
+{
+	Stats s;
+	const size_t stride = normalPairs ? 2 : 1;
+	s.verticesBefore = mesh.mVec3.size() / stride;
+	s.verticesAfter = s.verticesBefore;
+	if (mesh.mIndices.size() < 3 || mesh.mRenderData.indicesMode != GL_TRIANGLES)
+		return s;
+
+	// Work in whole vertices, not vec3s.
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	for (size_t i = 0; i < mesh.mVec3.size(); i += stride)
+	{
+		positions.push_back(mesh.mVec3[i]);
+		if (normalPairs)
+			normals.push_back(mesh.mVec3[i + 1]);
+	}
+	std::vector<unsigned int> indices;
+	indices.reserve(mesh.mIndices.size());
+	for (unsigned int i : mesh.mIndices)
+		indices.push_back(static_cast<unsigned int>(i / stride));
+	s.acmrBefore = acmr(indices, positions.size());
+
+	auto same = [&normals](unsigned int a, unsigned int b)
+	{
+		return normals.empty() || glm::dot(normals[a], normals[b]) >= NormalWeldCos;
+	};
+	std::vector<unsigned int> remap;
+	std::vector<unsigned int> unique = weld(positions, tolerance, same, remap);
+	std::vector<glm::vec3> weldedPositions;
+	std::vector<glm::vec3> weldedNormals;
+	for (unsigned int u : unique)
+	{
+		weldedPositions.push_back(positions[u]);
+		if (normalPairs)
+			weldedNormals.push_back(normals[u]);
+	}
+	for (unsigned int& i : indices)
+		i = remap[i];
+	removeDegenerates(indices);
+
+	vertexCacheOrder(indices, weldedPositions.size());
+	overdrawOrder(indices, weldedPositions);
+	size_t count = vertexFetchOrder(indices, weldedPositions.size(), remap);
+	positions = fetchOrder(weldedPositions, remap, count);
+	if (normalPairs)
+		normals = fetchOrder(weldedNormals, remap, count);
+	s.verticesAfter = count;
+	s.acmrAfter = acmr(indices, count);
+
+	mesh.mVec3.clear();
+	for (size_t i = 0; i < count; i++)
+	{
+		mesh.mVec3.push_back(positions[i]);
+		if (normalPairs)
+			mesh.mVec3.push_back(normals[i]);
+	}
+	mesh.mIndices.clear();
+	for (unsigned int i : indices)
+		mesh.mIndices.push_back(static_cast<unsigned int>(i * stride));
+	mesh.mRenderData.verticesCount = mesh.mVec3.size();
+	mesh.mRenderData.indicesCount = mesh.mIndices.size();
+	logStats("light mesh", s);
+	return s;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <functional>
+
+#include <glm/glm.hpp>
+
+#include "../OWEngine/OWEngine.h"
+
+struct MeshDataHeavy;
+struct MeshDataLight;
+
+/*
+	Load time optimisation of indexed triangle meshes. optimise() runs
+	1. Welding of vertices closer than a tolerance (with matching normals and
+	   texture coordinates) so triangles share them.
+	2. Forsyth's linear speed vertex cache ordering.
+	3. Overdraw ordering: the cache ordered triangles are cut into clusters
+	   which are sorted so those facing out from the centre of the mesh are
+	   drawn first (Sander, Nehab and Barczak).
+	4. Vertex fetch ordering: vertices are renumbered in the order the
+	   triangles first use them and unused ones are dropped.
+	ACMR (average cache miss ratio, transformed vertices per triangle) is
+	measured with a FIFO cache before and after and logged.
+*/
+class OWENGINE_API MeshOptimiser
+{
+public:
+	struct Stats
+	{
+		size_t verticesBefore = 0;
+		size_t verticesAfter = 0;
+		float acmrBefore = 0;
+		float acmrAfter = 0;
+	};
+	static constexpr size_t DefaultCacheSize = 32;
+	static constexpr float DefaultTolerance = 0.00001f;
+	// Clusters may lose this much ACMR to give the overdraw sort more to work with.
+	static constexpr float DefaultOverdrawThreshold = 1.05f;
+
+	static Stats optimise(MeshDataHeavy& mesh, float tolerance = DefaultTolerance);
+	// normalPairs is true if mVec3 holds interleaved position/normal pairs
+	// with even indices (as made by RopeNormaliser). GL_TRIANGLES only.
+	static Stats optimise(MeshDataLight& mesh, bool normalPairs,
+				float tolerance = DefaultTolerance);
+
+	static float acmr(const std::vector<unsigned int>& indices,
+				size_t vertexCount, size_t cacheSize = DefaultCacheSize);
+	/*
+		Fills remap (old vertex -> welded vertex) and returns the original
+		index of each welded vertex. same() can veto the welding of two
+		vertices whose positions are within tolerance.
+	*/
+	static std::vector<unsigned int> weld(const std::vector<glm::vec3>& positions,
+				float tolerance, const std::function<bool(unsigned int, unsigned int)>& same,
+				std::vector<unsigned int>& remap);
+	static void vertexCacheOrder(std::vector<unsigned int>& indices, size_t vertexCount);
+	static void overdrawOrder(std::vector<unsigned int>& indices,
+				const std::vector<glm::vec3>& positions,
+				float threshold = DefaultOverdrawThreshold);
+	// Fills remap (old vertex -> new vertex, UINT_MAX if unused), rewrites
+	// the indices and returns the new vertex count.
+	static size_t vertexFetchOrder(std::vector<unsigned int>& indices,
+				size_t vertexCount, std::vector<unsigned int>& remap);
+};
@@ -13,14 +13,16 @@
 
 #include "ModelData.h"
 #include "MeshDataHeavy.h"
+#include "MeshOptimiser.h"
 #include "Texture.h"
 
 ModelFactory::ModelFactory()
 {}
 
-ModelData processNode(aiNode *node, const aiScene *scene);
+ModelData processNode(aiNode *node, const aiScene *scene, bool compact);
 
-ModelData ModelFactory::create(const std::string& modelFileName, bool cache)
+ModelData ModelFactory::create(const std::string& modelFileName, bool cache,
+	bool compact)
 {
 	std::filesystem::path modelPath =
 		ResourcePathFactory().appendPath(modelFileName,
@@ -37,11 +39,11 @@ ModelData ModelFactory::create(const std::string& modelFileName, bool cache)
 			<< modelPath << "] ASSIMP error [" << importer.GetErrorString() << "]";
 		return ModelData();
 	}
-	ModelData root = processNode(aiscene->mRootNode, aiscene);
+	ModelData root = processNode(aiscene->mRootNode, aiscene, compact);
 	return root;
 }
 
-ModelData processNode(aiNode *node, const aiScene *scene)
+ModelData processNode(aiNode *node, const aiScene *scene, bool compact)
 {
 	ModelData retval;
 
@@ -50,13 +52,15 @@ ModelData processNode(aiNode *node, const aiScene *scene)
 	{
 		MeshDataHeavy* m = new MeshDataHeavy();
 		m->create(scene->mMeshes[node->mMeshes[i]], scene);
+		MeshOptimiser::optimise(*m);
+		m->compact = compact;
 		retval.meshes.push_back(m);
 	}
 
 	// then do the same for each of its children
 	for (unsigned int i = 0; i < node->mNumChildren; i++)
 	{
-		ModelData child = processNode(node->mChildren[i], scene);
+		ModelData child = processNode(node->mChildren[i], scene, compact);
 		retval.children.push_back(child);
 	}
 	return retval;
@@ -13,6 +13,8 @@ class OWENGINE_API ModelFactory
 //		std::shared_ptr<MeshDataHeavy*>> ModelCache;
 public:
 	ModelFactory();
-	ModelData create(const std::string& modelFileName, bool cache);
+	// compact meshes are uploaded as MeshDataHeavy::compact says.
+	ModelData create(const std::string& modelFileName, bool cache,
+				bool compact = true);
 private:
 };
\ No newline at end of file
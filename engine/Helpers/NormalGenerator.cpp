@@ -0,0 +1,147 @@
+#include "NormalGenerator.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <future>
+#include <thread>
+
+#include "../Core/ErrorHandling.h"
+
+// Meshes smaller than this are done on the calling thread.
+static const size_t ParallelItems = 16384;
+
+// Calls work(begin, end) for chunks of [0, count), in parallel for large
+// counts. Exceptions thrown by work are rethrown.
+template<typename Work>
+static void parallelChunks(size_t count, Work work)
+{
+	unsigned int threads = 1;
+	if (count >= ParallelItems)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	if (threads == 1)
+	{
+		work(size_t(0), count);
+		return;
+	}
+	std::vector<std::future<void>> futures;
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		size_t begin = count * t / threads;
+		size_t end = count * (t + 1) / threads;
+		futures.push_back(std::async(std::launch::async, work, begin, end));
+	}
+	for (std::future<void>& f : futures)
+		f.get();
+}
+
+void NormalGenerator::generate(std::vector<glm::vec3>& points,
+	const std::vector<unsigned int>& indices,
+	unsigned int normalOffset, unsigned int stride,
+	Weighting weighting)
+{
+	if (stride == 0 || normalOffset >= stride || indices.size() % 3)
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "NormalGenerator needs whole triangles and a normal inside the stride. "
+			<< "Given [" << indices.size() << "] indices, offset [" << normalOffset
+			<< "] and stride [" << stride << "].\n");
+	}
+	// The indices are of positions, each the first of stride vec3.
+	if (points.size() % stride)
+	{
+		throw NMSException(std::stringstream()
+			<< "NormalGenerator given [" << points.size()
+			<< "] points, which is not a multiple of the stride [" << stride << "].\n");
+	}
+	for (unsigned int i : indices)
+	{
+		if (i % stride)
+		{
+			throw NMSException(std::stringstream()
+				<< "NormalGenerator index [" << i << "] is not a multiple of the stride ["
+				<< stride << "].\n");
+		}
+	}
+	const size_t triangles = indices.size() / 3;
+	const size_t vertices = points.size() / stride;
+
+	// Face normals, as long as twice the area of the triangle.
+	std::vector<glm::vec3> faces(triangles);
+	parallelChunks(triangles, [&](size_t begin, size_t end)
+	{
+		for (size_t t = begin; t < end; t++)
+		{
+			unsigned int a = indices[3 * t];
+			unsigned int b = indices[3 * t + 1];
+			unsigned int c = indices[3 * t + 2];
+			if (a == b || a == c || b == c)
+				throw NMSLogicException("A triangle needs three distinct lines");
+			if (a / stride >= vertices || b / stride >= vertices || c / stride >= vertices)
+			{
+				throw NMSLogicException(std::stringstream()
+					<< "NormalGenerator triangle [" << t << "] is past the ["
+					<< vertices << "] vertices.\n");
+			}
+			glm::vec3 n = glm::cross(points[b] - points[a], points[c] - points[a]);
+			// Also false for NaN.
+			if (!(glm::dot(n, n) > 0.0f))
+				throw NMSLogicException("A normal is a NAN");
+			faces[t] = n;
+		}
+	});
+
+	// The corners (3 * triangle + 0, 1 or 2) at each vertex are
+	// corners[start[v]] to corners[start[v + 1] - 1].
+	std::vector<unsigned int> start(vertices + 1, 0);
+	for (unsigned int i : indices)
+		start[i / stride + 1]++;
+	for (size_t v = 0; v < vertices; v++)
+		start[v + 1] += start[v];
+	std::vector<unsigned int> corners(indices.size());
+	std::vector<unsigned int> next(start.begin(), start.end() - 1);
+	for (unsigned int c = 0; c < indices.size(); c++)
+		corners[next[indices[c] / stride]++] = c;
+
+	std::vector<glm::vec3> sums(vertices);
+	parallelChunks(vertices, [&](size_t begin, size_t end)
+	{
+		for (size_t v = begin; v < end; v++)
+		{
+			glm::vec3 sum(0.0f);
+			for (unsigned int k = start[v]; k < start[v + 1]; k++)
+			{
+				unsigned int c = corners[k];
+				unsigned int t = c / 3;
+				if (weighting == Weighting::Area)
+				{
+					sum += faces[t];
+					continue;
+				}
+				const glm::vec3& p = points[indices[c]];
+				glm::vec3 e1 = glm::normalize(points[indices[3 * t + (c + 1) % 3]] - p);
+				glm::vec3 e2 = glm::normalize(points[indices[3 * t + (c + 2) % 3]] - p);
+				float angle = std::acos(std::clamp(glm::dot(e1, e2), -1.0f, 1.0f));
+				sum += glm::normalize(faces[t]) * angle;
+			}
+			sums[v] = sum;
+		}
+	});
+
+	// Normalised in place in the contiguous sums, then written out to the
+	// interleaved points. No branch in the first loop. FLT_MIN keeps
+	// inversesqrt() finite for the vertices in no triangle, which are then
+	// left with what they had.
+	parallelChunks(vertices, [&](size_t begin, size_t end)
+	{
+		for (size_t v = begin; v < end; v++)
+		{
+			float length2 = glm::dot(sums[v], sums[v]);
+			sums[v] *= glm::inversesqrt(std::max(length2, FLT_MIN));
+		}
+		for (size_t v = begin; v < end; v++)
+		{
+			if (sums[v] != glm::vec3(0.0f))
+				points[v * stride + normalOffset] = sums[v];
+		}
+	});
+}
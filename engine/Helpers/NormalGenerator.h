@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../OWEngine/OWEngine.h"
+
+/*
+	Smooth vertex normals for an indexed triangle mesh whose vertices are
+	interleaved in one vector of vec3, stride apart with the position first
+	(e.g. position, normal, position, normal with stride 2). The indices
+	are of the positions and each normal is written normalOffset after its
+	position.
+	Face normals are found for chunks of triangles in parallel. The
+	triangles at each vertex are then looked up in a compressed (CSR)
+	vertex to corner table, so each vertex sums its own faces with no
+	locking and the result does not depend on the thread count. Area
+	weighting sums the unnormalised cross products; Angle weights each
+	unit face normal by the angle of the triangle at that vertex.
+	Vertices in no triangle are left as they are. A triangle repeating an
+	index or with no area throws NMSLogicException.
+*/
+struct OWENGINE_API NormalGenerator
+{
+	enum class Weighting { Area, Angle };
+	static void generate(std::vector<glm::vec3>& points,
+		const std::vector<unsigned int>& indices,
+		unsigned int normalOffset, unsigned int stride,
+		Weighting weighting = Weighting::Area);
+};
@@ -18,6 +18,8 @@
 #include "../Core/Logger.h"
 #include "../Core/LogStream.h"
 
+#include "../Renderers/GLStateCache.h"
+
 #include "ShaderFactory.h"
 
 Shader::Shader(ShaderData* _data)
@@ -26,8 +28,8 @@ Shader::Shader(ShaderData* _data)
 	create(
 		mData->shaderV.length() == 0 ? ShaderFactory::boilerPlateVertexShader()
 		: mData->shaderV,
-		mData->shaderF.length() == 0 ? ShaderFactory::boilerPlateFragmentShader()
-		: mData->shaderF,
+		mData->shaderF.length() == 0 && mData->feedbackVaryings.empty()
+		? ShaderFactory::boilerPlateFragmentShader() : mData->shaderF,
 		mData->shaderG.length() == 0 ? ShaderFactory::boilerPlateGeometryShader()
 		: mData->shaderG);
 		
@@ -124,11 +126,9 @@ void Shader::use() const
 {
 	if (mShaderProgram)
 	{
-		if (true)//!mUseCalled)
-		{
-			glUseProgram(mShaderProgram);
-			mUseCalled = true;
-		}
+		// GLStateCache skips the call if this program is already current.
+		GLStateCache::useProgram(mShaderProgram);
+		mUseCalled = true;
 	}
 }
 
@@ -136,7 +136,7 @@ void Shader::setup()
 {
 	if (mShaderProgram)
 	{
-		glUseProgram(mShaderProgram);
+		GLStateCache::useProgram(mShaderProgram);
 		processUniforms();
 	}
 }
@@ -224,14 +224,50 @@ std::string readFile(const std::string& fileName,
 	}
 }
 
+// GLSL has no #include of its own. Each line
+//	#include "file"
+// is replaced by the text of file, found as any other shader is. A #line
+// after it keeps the line numbers of compile errors right.
+static std::string expandIncludes(const std::string& source, int depth = 0)
+{
+	if (source.find("#include") == std::string::npos)
+		return source;
+	if (depth > 8)
+		throw NMSLogicException("Shader #include nested more than 8 deep.\n");
+	std::istringstream in(source);
+	std::stringstream out;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(in, line))
+	{
+		lineNumber++;
+		size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+		{
+			out << line << "\n";
+			continue;
+		}
+		size_t open = line.find('"', start);
+		size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+		if (close == std::string::npos)
+		{
+			throw NMSLogicException(std::stringstream()
+				<< "Bad shader include [" << line << "]. Use #include \"file\"\n");
+		}
+		out << expandIncludes(readFile(line.substr(open + 1, close - open - 1)), depth + 1)
+			<< "\n#line " << lineNumber + 1 << "\n";
+	}
+	return out.str();
+}
+
 std::string getShaderCode(const std::string& s)
 {
 	if (!s.size())
 		return "";
 	if (s[0] == '#')
-		return s;
+		return expandIncludes(s);
 	else
-		return readFile(s);
+		return expandIncludes(readFile(s));
 }
 
 void Shader::loadBoilerPlates()
@@ -248,10 +284,19 @@ void Shader::loadShaders(const std::string& vertexShader,
 {
 	linkShaders(addVertexShader(getShaderCode(vertexShader)),
 		addFragmentShader(getShaderCode(fragShader)),
-		addGeometryShader(getShaderCode(geometryShader)));
+		addGeometryShader(getShaderCode(geometryShader)),
+		transformFeedbacks());
 
 }
 
+std::vector<Shader::TransformFeedback> Shader::transformFeedbacks() const
+{
+	std::vector<TransformFeedback> retval;
+	if (mData != nullptr && !mData->feedbackVaryings.empty())
+		retval.push_back({ mData->feedbackInterleaved, mData->feedbackVaryings });
+	return retval;
+}
+
 void Shader::setStandardUniformNames(const std::string& pvm,
 	const std::string& projection,
 	const std::string& view,
@@ -395,9 +440,16 @@ void Shader::linkShaders(int vertexShader, int fragmentShader, int geomShader,
 	if (feedbacks.size())
 	{
 		// https://open.gl/feedback
-		throw NMSNotYetImplementedException("Transform feedbacks");
-		//glTransformFeedbackVaryings(mShaderProgram, screenX.name.size(), screenX.name.data(),
-			//screenX.interleaved ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS);
+		// Only one set of varyings can be given to a program.
+		if (feedbacks.size() > 1)
+			throw NMSNotYetImplementedException("More than one Transform feedback");
+		const TransformFeedback& tf = feedbacks[0];
+		std::vector<const GLchar*> names;
+		for (const std::string& s : tf.name)
+			names.push_back(s.c_str());
+		// Must be before the link to take effect.
+		glTransformFeedbackVaryings(mShaderProgram, static_cast<GLsizei>(names.size()),
+			names.data(), tf.interleaved ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS);
 	}
 	glLinkProgram(mShaderProgram);
 	// check for linking errors
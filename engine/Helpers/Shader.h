@@ -37,6 +37,10 @@ struct OWENGINE_API ShaderData
 	std::vector<ShaderDataUniforms> uniforms;
 	std::vector<RenderTypes::ShaderMutator> mutatorCallbacks;
 	std::vector<RenderTypes::ShaderResizer> resizeCallbacks;
+	// Outputs captured by transform feedback. If set and shaderF is empty
+	// the program has no fragment shader (draw with GL_RASTERIZER_DISCARD).
+	std::vector<std::string> feedbackVaryings;
+	bool feedbackInterleaved = true;
 	ShaderData() {}
 	ShaderData(const std::string& _v, const std::string& _f, const std::string& _g, const std::string& _pvm)
 	: shaderV(_v), shaderF(_f), shaderG(_g), PVMName(_pvm)
@@ -129,6 +133,7 @@ private:
 	std::vector<json> uniforms;
 	int mShaderProgram = 0;
 	void processUniforms();
+	std::vector<TransformFeedback> transformFeedbacks() const;
 	static int addShader(const std::string& sourceCode, 
 					unsigned int type, const std::string& errmsg);
 	void attachShader(int shader);
@@ -9,6 +9,8 @@
 #include <glad/glad.h>
 #endif
 
+#include "../Renderers/GLStateCache.h"
+
 Texture::Texture()
 {
 	mLocation = GL_INVALID_INDEX;
@@ -21,8 +23,7 @@ void Texture::init(unsigned char* data, int width, int height, const InitData& i
 	if (width > 0 && height > 0)
 	{
 		glGenTextures(1, &mLocation);
-		glActiveTexture(mImageUnit);
-		glBindTexture(mTarget, mLocation);
+		GLStateCache::bindTexture(mImageUnit - GL_TEXTURE0, mTarget, mLocation);
 
 		// set the texture wrapping parameters
 		// set texture wrapping to GL_REPEAT (default wrapping method)
@@ -56,8 +57,8 @@ void Texture::init(unsigned char* data, int width, int height, const InitData& i
 		// Enable blending, necessary for alpha texture
 		if (initData.internalFormat == GL_RGBA)
 		{
-			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			GLStateCache::blend(true);
+			GLStateCache::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		}
 	}
 //	glActiveTexture(0);
@@ -0,0 +1,53 @@
+#include "VertexPacking.h"
+
+#include <algorithm>
+
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// A flat mesh has no extent on one axis. Keep the matrix invertible.
+static glm::vec3 safeExtent(const AABB& bounds)
+{
+	glm::vec3 extent = bounds.size();
+	for (int i = 0; i < 3; i++)
+	{
+		if (extent[i] <= 0.0f)
+			extent[i] = 1.0f;
+	}
+	return extent;
+}
+
+uint32_t VertexPacking::packNormal(const glm::vec3& n)
+{
+	return glm::packSnorm3x10_1x2(glm::vec4(n, 0.0f));
+}
+
+uint32_t VertexPacking::packHalf2(const glm::vec2& v)
+{
+	return glm::packHalf2x16(v);
+}
+
+void VertexPacking::quantise(const glm::vec3& p, const AABB& bounds, uint16_t out[4])
+{
+	glm::vec3 extent = safeExtent(bounds);
+	glm::vec3 unit = (p - glm::vec3(bounds.minPoint())) / extent;
+	for (int i = 0; i < 3; i++)
+	{
+		float f = std::clamp(unit[i], 0.0f, 1.0f);
+		out[i] = static_cast<uint16_t>(f * 65535.0f + 0.5f);
+	}
+	out[3] = 0;
+}
+
+glm::mat4 VertexPacking::dequantise(const AABB& bounds)
+{
+	const glm::mat4 I(1.0f);
+	return glm::scale(glm::translate(I, glm::vec3(bounds.minPoint())), safeExtent(bounds));
+}
+
+glm::vec3 VertexPacking::scaleNormal(const glm::vec3& n, const AABB& bounds)
+{
+	glm::vec3 scaled = n * safeExtent(bounds);
+	float len = glm::length(scaled);
+	return len > 0.0f ? scaled / len : n;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "../OWEngine/OWEngine.h"
+#include "../Geometry/BoundingBox.h"
+
+/*
+	Helpers for the compact vertex formats.
+	Normals are GL_INT_2_10_10_10_REV (normalised), texture coordinates are
+	two GL_HALF_FLOATs and positions are three normalised GL_UNSIGNED_SHORTs
+	relative to the mesh bounds. A renderer using quantised positions returns
+	dequantise(bounds) from RendererBase::localTransform() so the shaders are
+	unchanged.
+*/
+struct OWENGINE_API VertexPacking
+{
+	// Position (6 bytes, padded to 8) then normal (4 bytes).
+	struct PositionNormal
+	{
+		uint16_t position[4];
+		uint32_t normal;
+	};
+	// As PositionNormal followed by two half float texture coordinates.
+	struct PositionNormalTexture
+	{
+		uint16_t position[4];
+		uint32_t normal;
+		uint32_t textureCoord;
+	};
+	static uint32_t packNormal(const glm::vec3& n);
+	static uint32_t packHalf2(const glm::vec2& v);
+	// p mapped to [0, 65535] across bounds. w is 0.
+	static void quantise(const glm::vec3& p, const AABB& bounds, uint16_t out[4]);
+	// Maps the [0, 1] cube the quantised positions unpack to back onto bounds.
+	static glm::mat4 dequantise(const AABB& bounds);
+	/*
+		The dequantise() scale is part of the model matrix so shaders using
+		transpose(inverse(model)) would divide the normal by it. Multiplying
+		by the extent first cancels that out. The result is normalised.
+	*/
+	static glm::vec3 scaleNormal(const glm::vec3& n, const AABB& bounds);
+	// True if GL_UNSIGNED_SHORT can hold largestIndex leaving 0xFFFF for primitive restart.
+	static bool fitsShortIndices(size_t largestIndex) { return largestIndex < 0xFFFF; }
+};
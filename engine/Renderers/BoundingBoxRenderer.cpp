@@ -0,0 +1,108 @@
+#include "BoundingBoxRenderer.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../Core/ErrorHandling.h"
+
+#include "GLStateCache.h"
+
+BoundingBoxRenderer* BoundingBoxRenderer::mInstance = nullptr;
+ShaderData BoundingBoxRenderer::mShaderData;
+std::vector<BoundingBoxRenderer::Instance> BoundingBoxRenderer::mPending;
+
+BoundingBoxRenderer::BoundingBoxRenderer(Shader* shader)
+	: RendererBase(shader)
+{
+}
+
+void BoundingBoxRenderer::submit(const AABB& box, const glm::mat4& model,
+				const glm::vec4& colour)
+{
+	const glm::mat4 I(1.0f);
+	glm::mat4 unitToBox = glm::scale(glm::translate(I, box.minPoint()), box.size());
+	mPending.push_back({ model * unitToBox, colour });
+}
+
+size_t BoundingBoxRenderer::lastFrameCount()
+{
+	return mInstance ? mInstance->mDrawCount : 0;
+}
+
+void BoundingBoxRenderer::flush(const glm::mat4& proj, const glm::mat4& view,
+				const glm::vec3& cameraPos)
+{
+	if (mPending.empty())
+		return;
+	if (mInstance == nullptr)
+	{
+		mShaderData.shaderV = "boundingBoxes.v.glsl";
+		mShaderData.shaderF = "boundingBoxes.f.glsl";
+		mShaderData.PVMName = "VP";
+		mShaderData.projectionName = "";
+		mShaderData.viewName = "";
+		mShaderData.modelName = "";
+		mInstance = new BoundingBoxRenderer(new Shader(&mShaderData));
+		mInstance->setup();
+	}
+	mInstance->upload();
+	mInstance->render(proj, view, glm::mat4(1.0f), cameraPos);
+	mPending.clear();
+}
+
+void BoundingBoxRenderer::setup()
+{
+	validateBase();
+	// The 12 edges of the unit cube.
+	const glm::vec3 lines[] = {
+		{ 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 },
+		{ 1, 1, 0 }, { 0, 1, 0 }, { 0, 1, 0 }, { 0, 0, 0 },
+		{ 0, 0, 1 }, { 1, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 },
+		{ 1, 1, 1 }, { 0, 1, 1 }, { 0, 1, 1 }, { 0, 0, 1 },
+		{ 0, 0, 0 }, { 0, 0, 1 }, { 1, 0, 0 }, { 1, 0, 1 },
+		{ 1, 1, 0 }, { 1, 1, 1 }, { 0, 1, 0 }, { 0, 1, 1 }
+	};
+	glGenVertexArrays(1, &mVao);
+	GLStateCache::bindVertexArray(mVao);
+	glGenBuffers(2, &mVbo[0]);
+
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[0]);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(lines), lines, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+	glVertexAttribDivisor(0, 0);
+
+	// A mat4 attribute takes 4 consecutive locations.
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[1]);
+	constexpr GLsizei stride = sizeof(Instance);
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		glEnableVertexAttribArray(1 + i);
+		glVertexAttribPointer(1 + i, 4, GL_FLOAT, GL_FALSE, stride,
+			(void*)(offsetof(Instance, model) + sizeof(glm::vec4) * i));
+		glVertexAttribDivisor(1 + i, 1);
+	}
+	glEnableVertexAttribArray(5);
+	glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, stride,
+		(void*)offsetof(Instance, colour));
+	glVertexAttribDivisor(5, 1);
+	GLStateCache::bindVertexArray(0);
+}
+
+void BoundingBoxRenderer::upload()
+{
+	mDrawCount = mPending.size();
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[1]);
+	if (mDrawCount > mCapacity)
+	{
+		mCapacity = std::max(mDrawCount, mCapacity * 2);
+	}
+	// Orphan the old storage so we never wait on last frame's draw.
+	glBufferData(GL_ARRAY_BUFFER, mCapacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, mDrawCount * sizeof(Instance), mPending.data());
+}
+
+void BoundingBoxRenderer::doRender() const
+{
+	GLStateCache::bindVertexArray(mVao);
+	glDrawArraysInstanced(GL_LINES, 0, 24, static_cast<GLsizei>(mDrawCount));
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+
+#include "../OWEngine/OWEngine.h"
+
+#include "../Geometry/BoundingBox.h"
+#include "../Helpers/Shader.h"
+
+#include "RendererBase.h"
+
+/*
+	Draws every debug bounding box in the frame with one instanced draw call.
+	Components submit() their box while rendering and the Movie calls flush()
+	once the scene has been rendered. The geometry is a single unit cube drawn
+	as GL_LINES; each instance carries the matrix mapping the unit cube onto 
+	the box plus a colour. The instance buffer is orphaned and refilled each frame.
+*/
+class OWENGINE_API BoundingBoxRenderer : public RendererBase
+{
+public:
+	static void submit(const AABB& box, const glm::mat4& model,
+				const glm::vec4& colour);
+	static void flush(const glm::mat4& proj, const glm::mat4& view,
+				const glm::vec3& cameraPos);
+	static size_t lastFrameCount();
+protected:
+	void doRender() const override;
+private:
+	BoundingBoxRenderer(Shader* shader);
+	void setup();
+	void upload();
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	struct Instance
+	{
+		glm::mat4 model;
+		glm::vec4 colour;
+	};
+	static BoundingBoxRenderer* mInstance;
+	static ShaderData mShaderData;
+	static std::vector<Instance> mPending;
+	size_t mCapacity = 0;
+	size_t mDrawCount = 0;
+	unsigned int mVao = 0;
+	// mVbo[0] The unit cube lines
+	// mVbo[1] The streamed instance data
+	unsigned int mVbo[2] = { 0, 0 };
+#pragma warning( pop )
+};
@@ -0,0 +1,246 @@
+#include "GLStateCache.h"
+
+GLuint GLStateCache::mProgram = GLStateCache::Unknown;
+GLuint GLStateCache::mVao = GLStateCache::Unknown;
+GLuint GLStateCache::mTransformFeedback = GLStateCache::Unknown;
+std::array<GLuint, 8> GLStateCache::mBuffers;
+GLuint GLStateCache::mActiveUnit = GLStateCache::Unknown;
+std::array<GLStateCache::TextureBinding, GLStateCache::MaxTextureUnits> GLStateCache::mTextures;
+std::array<GLuint, 8> GLStateCache::mCapabilities;
+GLuint GLStateCache::mBlendSrc = GLStateCache::Unknown;
+GLuint GLStateCache::mBlendDst = GLStateCache::Unknown;
+GLuint GLStateCache::mPolygonMode = GLStateCache::Unknown;
+float GLStateCache::mLineWidth = -1.0f;
+GLuint GLStateCache::mDepthFunc = GLStateCache::Unknown;
+GLuint GLStateCache::mDepthMask = GLStateCache::Unknown;
+unsigned int GLStateCache::mElided = 0;
+unsigned int GLStateCache::mIssued = 0;
+unsigned int GLStateCache::mLastElided = 0;
+unsigned int GLStateCache::mLastIssued = 0;
+
+void GLStateCache::invalidate()
+{
+	mProgram = Unknown;
+	mVao = Unknown;
+	mTransformFeedback = Unknown;
+	mBuffers.fill(Unknown);
+	mActiveUnit = Unknown;
+	mTextures.fill(TextureBinding());
+	mCapabilities.fill(Unknown);
+	mBlendSrc = Unknown;
+	mBlendDst = Unknown;
+	mPolygonMode = Unknown;
+	mLineWidth = -1.0f;
+	mDepthFunc = Unknown;
+	mDepthMask = Unknown;
+}
+
+bool GLStateCache::changed(GLuint& cached, GLuint newValue)
+{
+	if (cached == newValue)
+	{
+		mElided++;
+		return false;
+	}
+	cached = newValue;
+	mIssued++;
+	return true;
+}
+
+int GLStateCache::bufferSlot(GLenum target)
+{
+	switch (target)
+	{
+		case GL_ARRAY_BUFFER: return 0;
+		case GL_ELEMENT_ARRAY_BUFFER: return 1;
+		case GL_DRAW_INDIRECT_BUFFER: return 2;
+		case GL_UNIFORM_BUFFER: return 3;
+		case GL_TEXTURE_BUFFER: return 4;
+		case GL_COPY_READ_BUFFER: return 5;
+		case GL_COPY_WRITE_BUFFER: return 6;
+		case GL_TRANSFORM_FEEDBACK_BUFFER: return 7;
+		default: return -1;
+	}
+}
+
+int GLStateCache::capabilitySlot(GLenum cap)
+{
+	switch (cap)
+	{
+		case GL_BLEND: return 0;
+		case GL_DEPTH_TEST: return 1;
+		case GL_CULL_FACE: return 2;
+		case GL_PRIMITIVE_RESTART: return 3;
+		case GL_PROGRAM_POINT_SIZE: return 4;
+		case GL_RASTERIZER_DISCARD: return 5;
+		case GL_SCISSOR_TEST: return 6;
+		case GL_MULTISAMPLE: return 7;
+		default: return -1;
+	}
+}
+
+void GLStateCache::useProgram(GLuint program)
+{
+	if (changed(mProgram, program))
+		glUseProgram(program);
+}
+
+void GLStateCache::bindVertexArray(GLuint vao)
+{
+	if (changed(mVao, vao))
+	{
+		glBindVertexArray(vao);
+		// The element buffer binding is part of the VAO state.
+		mBuffers[bufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = Unknown;
+	}
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+	int slot = bufferSlot(target);
+	if (slot == -1)
+	{
+		mIssued++;
+		glBindBuffer(target, buffer);
+	}
+	else if (changed(mBuffers[slot], buffer))
+	{
+		glBindBuffer(target, buffer);
+	}
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	mIssued++;
+	glBindBufferBase(target, index, buffer);
+	int slot = bufferSlot(target);
+	if (slot != -1)
+		mBuffers[slot] = buffer;
+}
+
+void GLStateCache::bindTransformFeedback(GLuint tfo)
+{
+	if (changed(mTransformFeedback, tfo))
+	{
+		glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, tfo);
+		// The feedback buffer bindings are part of the transform feedback object.
+		mBuffers[bufferSlot(GL_TRANSFORM_FEEDBACK_BUFFER)] = Unknown;
+	}
+}
+
+void GLStateCache::deleteBuffers(GLsizei n, const GLuint* buffers)
+{
+	glDeleteBuffers(n, buffers);
+	for (GLsizei i = 0; i < n; i++)
+	{
+		for (GLuint& b : mBuffers)
+		{
+			if (b == buffers[i])
+				b = 0;
+		}
+	}
+}
+
+void GLStateCache::activeTexture(unsigned int unit)
+{
+	if (changed(mActiveUnit, unit))
+		glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLStateCache::bindTexture(unsigned int unit, GLenum target, GLuint texture)
+{
+	if (unit >= MaxTextureUnits)
+	{
+		activeTexture(unit);
+		mIssued++;
+		glBindTexture(target, texture);
+		return;
+	}
+	TextureBinding& tb = mTextures[unit];
+	if (tb.target == target && tb.texture == texture)
+	{
+		mElided++;
+		return;
+	}
+	activeTexture(unit);
+	tb.target = target;
+	tb.texture = texture;
+	mIssued++;
+	glBindTexture(target, texture);
+}
+
+void GLStateCache::enable(GLenum cap, bool enable)
+{
+	int slot = capabilitySlot(cap);
+	if (slot == -1 || changed(mCapabilities[slot], enable ? 1 : 0))
+	{
+		if (slot == -1)
+			mIssued++;
+		if (enable)
+			glEnable(cap);
+		else
+			glDisable(cap);
+	}
+}
+
+void GLStateCache::blend(bool enable)
+{
+	GLStateCache::enable(GL_BLEND, enable);
+}
+
+void GLStateCache::blendFunc(GLenum sfactor, GLenum dfactor)
+{
+	if (mBlendSrc == sfactor && mBlendDst == dfactor)
+	{
+		mElided++;
+		return;
+	}
+	mBlendSrc = sfactor;
+	mBlendDst = dfactor;
+	mIssued++;
+	glBlendFunc(sfactor, dfactor);
+}
+
+void GLStateCache::polygonMode(GLenum mode)
+{
+	// Core profile only accepts GL_FRONT_AND_BACK.
+	if (changed(mPolygonMode, mode))
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLStateCache::lineWidth(float width)
+{
+	if (mLineWidth == width)
+	{
+		mElided++;
+		return;
+	}
+	mLineWidth = width;
+	mIssued++;
+	glLineWidth(width);
+}
+
+void GLStateCache::depthTest(bool enable)
+{
+	GLStateCache::enable(GL_DEPTH_TEST, enable);
+}
+
+void GLStateCache::depthFunc(GLenum func)
+{
+	if (changed(mDepthFunc, func))
+		glDepthFunc(func);
+}
+
+void GLStateCache::depthMask(bool enable)
+{
+	if (changed(mDepthMask, enable ? 1 : 0))
+		glDepthMask(enable ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::endFrame()
+{
+	mLastElided = mElided;
+	mLastIssued = mIssued;
+	mElided = 0;
+	mIssued = 0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <climits>
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+
+#include "../OWEngine/OWEngine.h"
+
+/*
+	A shadow copy of the OpenGL state the renderers touch. Every call compares
+	against the shadow and only reaches the driver when the value really changes.
+	All renderers must go through here (and not call glUseProgram, glBindVertexArray
+	etc directly) otherwise the shadow goes stale. If some code has to bypass the
+	cache then call invalidate() afterwards.
+	https://www.khronos.org/opengl/wiki/Common_Mistakes#Unnecessary_state_changes
+*/
+class OWENGINE_API GLStateCache
+{
+public:
+	// Used as the 'driver state is unknown' flag.
+	static constexpr GLuint Unknown = UINT_MAX;
+	static constexpr unsigned int MaxTextureUnits = 32;
+
+	// Forget everything. The next call of each setter always reaches the driver.
+	static void invalidate();
+
+	static void useProgram(GLuint program);
+	static void bindVertexArray(GLuint vao);
+	static void bindBuffer(GLenum target, GLuint buffer);
+	// Also binds the generic target (as OpenGL does).
+	static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	static void bindTransformFeedback(GLuint tfo);
+	// glDeleteBuffers() unbinds the buffers so the shadow must forget them.
+	static void deleteBuffers(GLsizei n, const GLuint* buffers);
+	// unit is zero based (i.e. not GL_TEXTURE0 + n)
+	static void bindTexture(unsigned int unit, GLenum target, GLuint texture);
+	static void activeTexture(unsigned int unit);
+
+	static void blend(bool enable);
+	static void blendFunc(GLenum sfactor, GLenum dfactor);
+	static void polygonMode(GLenum mode);
+	static void lineWidth(float width);
+	static void depthTest(bool enable);
+	static void depthFunc(GLenum func);
+	static void depthMask(bool enable);
+	static void enable(GLenum cap, bool enable);
+
+	// Called once per frame by the Movie. Moves the running counts into the
+	// 'last frame' values and resets them.
+	static void endFrame();
+	static unsigned int lastFrameElided() { return mLastElided; }
+	static unsigned int lastFrameIssued() { return mLastIssued; }
+	static unsigned int elided() { return mElided; }
+	static unsigned int issued() { return mIssued; }
+private:
+	static bool changed(GLuint& cached, GLuint newValue);
+	static int bufferSlot(GLenum target);
+	static int capabilitySlot(GLenum cap);
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	struct TextureBinding
+	{
+		GLenum target = Unknown;
+		GLuint texture = Unknown;
+	};
+	static GLuint mProgram;
+	static GLuint mVao;
+	static GLuint mTransformFeedback;
+	static std::array<GLuint, 8> mBuffers;
+	static GLuint mActiveUnit;
+	static std::array<TextureBinding, MaxTextureUnits> mTextures;
+	static std::array<GLuint, 8> mCapabilities;
+	static GLuint mBlendSrc;
+	static GLuint mBlendDst;
+	static GLuint mPolygonMode;
+	static float mLineWidth;
+	static GLuint mDepthFunc;
+	static GLuint mDepthMask;
+	static unsigned int mElided;
+	static unsigned int mIssued;
+	static unsigned int mLastElided;
+	static unsigned int mLastIssued;
+#pragma warning( pop )
+};
@@ -0,0 +1,191 @@
+#include "GeometryPool.h"
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+
+#include "../Core/ErrorHandling.h"
+
+#include "GLStateCache.h"
+
+std::map<GeometryPool::Format, GeometryPool*> GeometryPool::mPools;
+
+// Smallest buffers in elements (vertices or indices). Saves lots of
+// doubling while the scene is loaded.
+static const size_t MinCapacity = 64 * 1024;
+
+bool GeometryPool::Attribute::operator<(const Attribute& other) const
+{
+	return std::tie(location, components, type, normalised, offset)
+		< std::tie(other.location, other.components, other.type, other.normalised, other.offset);
+}
+
+bool GeometryPool::Format::operator<(const Format& other) const
+{
+	return std::tie(stride, attributes) < std::tie(other.stride, other.attributes);
+}
+
+size_t GeometryPool::RangeAllocator::allocate(size_t count)
+{
+	for (auto iter = mFree.begin(); iter != mFree.end(); ++iter)
+	{
+		if (iter->second >= count)
+		{
+			size_t first = iter->first;
+			size_t left = iter->second - count;
+			mFree.erase(iter);
+			if (left)
+				mFree[first + count] = left;
+			return first;
+		}
+	}
+	return SIZE_MAX;
+}
+
+void GeometryPool::RangeAllocator::release(size_t first, size_t count)
+{
+	if (count == 0)
+		return;
+	auto next = mFree.lower_bound(first);
+	// Merge with the following free range
+	if (next != mFree.end() && first + count == next->first)
+	{
+		count += next->second;
+		next = mFree.erase(next);
+	}
+	// and the preceding one.
+	if (next != mFree.begin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == first)
+		{
+			prev->second += count;
+			return;
+		}
+	}
+	mFree[first] = count;
+}
+
+void GeometryPool::RangeAllocator::grow(size_t newCapacity)
+{
+	size_t old = mCapacity;
+	mCapacity = newCapacity;
+	release(old, newCapacity - old);
+}
+
+GeometryPool::GeometryPool(const Format& format)
+	: mFormat(format)
+{
+	glGenVertexArrays(1, &mVao);
+}
+
+GeometryPool* GeometryPool::pool(const Format& format)
+{
+	auto iter = mPools.find(format);
+	if (iter != mPools.end())
+		return iter->second;
+	GeometryPool* gp = new GeometryPool(format);
+	mPools[format] = gp;
+	return gp;
+}
+
+size_t GeometryPool::allocateRange(RangeAllocator& ra, unsigned int& buffer,
+	size_t elementSize, size_t count)
+{
+	size_t first = ra.allocate(count);
+	if (first != SIZE_MAX)
+		return first;
+
+	size_t oldCapacity = ra.capacity();
+	size_t newCapacity = std::max(MinCapacity, oldCapacity * 2);
+	while (newCapacity - oldCapacity < count)
+		newCapacity *= 2;
+	unsigned int newBuffer = 0;
+	glGenBuffers(1, &newBuffer);
+	GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, newCapacity * elementSize, nullptr, GL_STATIC_DRAW);
+	if (buffer)
+	{
+		GLStateCache::bindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+			0, 0, oldCapacity * elementSize);
+		GLStateCache::deleteBuffers(1, &buffer);
+	}
+	buffer = newBuffer;
+	ra.grow(newCapacity);
+	// The VAO refers to the buffers by name so it has to be told.
+	pointAttributes();
+	first = ra.allocate(count);
+	if (first == SIZE_MAX)
+		throw NMSLogicException("GeometryPool failed to allocate after growing.\n");
+	return first;
+}
+
+void GeometryPool::pointAttributes()
+{
+	GLStateCache::bindVertexArray(mVao);
+	if (mVbo)
+	{
+		GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo);
+		for (const Attribute& a : mFormat.attributes)
+		{
+			glEnableVertexAttribArray(a.location);
+			glVertexAttribPointer(a.location, a.components, a.type, a.normalised,
+				mFormat.stride, (void*)a.offset);
+		}
+	}
+	if (mEbo)
+		GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEbo);
+	GLStateCache::bindVertexArray(0);
+}
+
+GeometryPool::Allocation GeometryPool::allocate(const void* vertices, size_t vertexCount,
+	const unsigned int* indices, size_t indexCount)
+{
+	Allocation a;
+	a.pool = this;
+	// Nothing to store or draw.
+	if (vertexCount == 0)
+		return a;
+	a.vertexCount = static_cast<GLsizei>(vertexCount);
+	a.baseVertex = static_cast<GLint>(allocateRange(mVertices, mVbo,
+		mFormat.stride, vertexCount));
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo);
+	glBufferSubData(GL_ARRAY_BUFFER, a.baseVertex * mFormat.stride,
+		vertexCount * mFormat.stride, vertices);
+	if (indexCount)
+	{
+		a.indexCount = static_cast<GLsizei>(indexCount);
+		a.firstIndex = static_cast<GLsizei>(allocateRange(mIndices, mEbo,
+			sizeof(unsigned int), indexCount));
+		// Not through GL_ELEMENT_ARRAY_BUFFER as that would change the bound VAO.
+		GLStateCache::bindBuffer(GL_COPY_WRITE_BUFFER, mEbo);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, a.firstIndex * sizeof(unsigned int),
+			indexCount * sizeof(unsigned int), indices);
+	}
+	return a;
+}
+
+void GeometryPool::release(const Allocation& a)
+{
+	if (a.pool != this)
+		throw NMSLogicException("GeometryPool::release() of an allocation from another pool.\n");
+	mVertices.release(a.baseVertex, a.vertexCount);
+	mIndices.release(a.firstIndex, a.indexCount);
+}
+
+void GeometryPool::draw(const Allocation& a, GLenum mode)
+{
+	if (a.vertexCount == 0)
+		return;
+	GLStateCache::bindVertexArray(a.pool->mVao);
+	if (a.indexCount)
+	{
+		glDrawElementsBaseVertex(mode, a.indexCount, GL_UNSIGNED_INT,
+			(void*)(a.firstIndex * sizeof(unsigned int)), a.baseVertex);
+	}
+	else
+	{
+		glDrawArrays(mode, a.baseVertex, a.vertexCount);
+	}
+}
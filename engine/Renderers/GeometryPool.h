@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <map>
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+
+#include "../OWEngine/OWEngine.h"
+
+/*
+	Shares a few large vertex and index buffers between all the meshes with
+	the same vertex format. Each format has one VAO, one VBO and one EBO; a mesh
+	is a range of vertices and a range of indices in them, handed out by a
+	first fit free list. Indices are stored relative to the mesh and drawn with
+	glDrawElementsBaseVertex, so meshes of the same format drawn one after the
+	other need no VAO or buffer changes at all.
+	The buffers double (with glCopyBufferSubData) when they run out of room.
+*/
+class OWENGINE_API GeometryPool
+{
+public:
+	struct Attribute
+	{
+		GLuint location;
+		GLint components;
+		GLenum type;
+		GLboolean normalised;
+		size_t offset;
+		bool operator<(const Attribute& other) const;
+	};
+	struct Format
+	{
+		GLsizei stride = 0;
+		std::vector<Attribute> attributes;
+		bool operator<(const Format& other) const;
+	};
+	// Where a mesh lives in its pool.
+	struct Allocation
+	{
+		GeometryPool* pool = nullptr;
+		GLint baseVertex = 0;
+		GLsizei vertexCount = 0;
+		GLsizei firstIndex = 0;
+		GLsizei indexCount = 0;
+	};
+
+	// The pool for format, created on first use.
+	static GeometryPool* pool(const Format& format);
+	// No vertices gives an empty allocation which draws nothing.
+	Allocation allocate(const void* vertices, size_t vertexCount,
+				const unsigned int* indices = nullptr, size_t indexCount = 0);
+	// The owner of an allocation releases it when the mesh goes.
+	void release(const Allocation& a);
+	// Draws with glDrawElementsBaseVertex if the mesh has indices otherwise glDrawArrays.
+	static void draw(const Allocation& a, GLenum mode);
+	static size_t poolCount() { return mPools.size(); }
+private:
+	GeometryPool(const Format& format);
+	// First fit allocator of element ranges with coalescing on release.
+	class RangeAllocator
+	{
+	public:
+		// Returns SIZE_MAX if there is no room.
+		size_t allocate(size_t count);
+		void release(size_t first, size_t count);
+		void grow(size_t newCapacity);
+		size_t capacity() const { return mCapacity; }
+	private:
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+		// first -> count of the free ranges
+		std::map<size_t, size_t> mFree;
+		size_t mCapacity = 0;
+#pragma warning( pop )
+	};
+	size_t allocateRange(RangeAllocator& ra, unsigned int& buffer,
+				size_t elementSize, size_t count);
+	void pointAttributes();
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	static std::map<Format, GeometryPool*> mPools;
+	Format mFormat;
+	RangeAllocator mVertices;
+	RangeAllocator mIndices;
+	unsigned int mVao = 0;
+	unsigned int mVbo = 0;
+	unsigned int mEbo = 0;
+#pragma warning( pop )
+};
@@ -0,0 +1,48 @@
+#include "GridRenderer.h"
+
+#include "../Core/ErrorHandling.h"
+#include "../Core/GlobalSettings.h"
+
+#include "../Helpers/Shader.h"
+
+#include "GLStateCache.h"
+
+void GridRenderer::setup(const AABB& box, const glm::vec3& spacing,
+	const glm::vec4& colour, float lineWidth, float fadeStart, float fadeEnd)
+{
+	validateBase();
+	if (spacing.x <= 0 || spacing.y <= 0 || spacing.z <= 0)
+		throw NMSLogicException("GridRenderer spacing must be positive.\n");
+	// Lines across each axis, including the one on the minimum side.
+	glm::vec3 counts = glm::floor(box.size() / spacing) + glm::vec3(1.0f);
+	mLineCount = static_cast<GLsizei>(counts.y * counts.z
+		+ counts.x * counts.z + counts.x * counts.y);
+	// Nothing in it but OpenGL will not draw without one.
+	glGenVertexArrays(1, &mVao);
+
+	blendFunction(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	shader()->use();
+	shader()->setVector3f("boxMin", box.minPoint());
+	shader()->setVector3f("boxMax", box.maxPoint());
+	shader()->setVector3f("spacing", spacing);
+	shader()->setVector3f("counts", counts);
+	shader()->setVector4f("uColour", colour);
+	shader()->setFloat("lineWidth", lineWidth);
+	shader()->setFloat("fadeStart", fadeStart);
+	shader()->setFloat("fadeEnd", fadeEnd);
+	shader()->appendMutator([](const glm::mat4& OW_UNUSED(proj),
+		const glm::mat4& OW_UNUSED(view), const glm::mat4& OW_UNUSED(model),
+		const glm::vec3& OW_UNUSED(cameraPos), const Shader* shader)
+	{
+		shader->setVector2f("viewport", glm::vec2(globals->physicalWindowSize()));
+	});
+}
+
+void GridRenderer::doRender() const
+{
+	GLStateCache::bindVertexArray(mVao);
+	// The anti-aliased edges must not hide what is drawn behind them later.
+	GLStateCache::depthMask(false);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, mLineCount);
+	GLStateCache::depthMask(true);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+
+#include "../OWEngine/OWEngine.h"
+
+#include "../Geometry/BoundingBox.h"
+
+#include "RendererBase.h"
+
+/*
+	Draws a box filled with a grid of lines without any vertex data.
+	grid.v.glsl makes each unique line from gl_InstanceID. It is expanded
+	into a screen space quad, so the whole grid is one instanced draw of 4
+	vertices per line, whatever its density. grid.f.glsl anti-aliases the
+	edges and fades the grid out with distance.
+	Lines are at box.minPoint() + n * spacing on each axis and run from one
+	side of the box to the other.
+*/
+class OWENGINE_API GridRenderer: public RendererBase
+{
+public:
+	GridRenderer(Shader* shader)
+		: RendererBase(shader) {}
+	void setup(const AABB& box, const glm::vec3& spacing, const glm::vec4& colour,
+				float lineWidth, float fadeStart, float fadeEnd);
+	GLsizei lineCount() const { return mLineCount; }
+protected:
+	void doRender() const override;
+private:
+	GLsizei mLineCount = 0;
+	unsigned int mVao = 0;
+};
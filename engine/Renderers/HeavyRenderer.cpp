@@ -5,6 +5,9 @@
 
 #include "../Helpers/MeshDataHeavy.h"
 #include "../Helpers/Shader.h"
+#include "../Helpers/VertexPacking.h"
+
+#include "GLStateCache.h"
 
 void HeavyRenderer::setup(const MeshDataHeavy* data, unsigned int vertexMode, unsigned int vertexLocation)
 {
@@ -15,52 +18,91 @@ void HeavyRenderer::setup(const MeshDataHeavy* data, unsigned int vertexMode, un
 	validate();
 	shader()->use();
 
-	glGenVertexArrays(1, &mVao);
-	glGenBuffers(1, &mVbo);
-	if (!data->indices.empty())
+	if (data->compact)
 	{
-		glGenBuffers(1, &mEbo);
+		setupCompact(data);
+		return;
 	}
-	glBindVertexArray(mVao);
-	glBindBuffer(GL_ARRAY_BUFFER, mVbo);
-
 	constexpr GLsizei vertexSize = sizeof(MeshDataHeavy::Vertex);
 	constexpr GLsizei glmv3Size = glm::vec3::length();
 	constexpr GLsizei glmv2Size = glm::vec2::length();
 
-	glBufferData(GL_ARRAY_BUFFER, vertexSize * data->vertices.size(),
-		data->vertices.data(), GL_STATIC_DRAW);
-
-	if (data->indices.size())
-	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEbo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-			data->indices.size() * sizeof(unsigned int),
-			data->indices.data(), GL_STATIC_DRAW);
-	}
-
+	// The attribute locations come from the shader so meshes share a pool
+	// when their shaders agree on them (i.e. use layout(location = n)).
+	GeometryPool::Format format;
+	format.stride = vertexSize;
 	// vertex Positions first
 	GLint xx = shader()->getAttributeLocation("aPos");
-	glEnableVertexAttribArray(xx);
-	glVertexAttribPointer(xx, glmv3Size, GL_FLOAT, GL_FALSE, vertexSize, 0);
+	format.attributes.push_back({ static_cast<GLuint>(xx), glmv3Size,
+		GL_FLOAT, GL_FALSE, 0 });
 
-	xx = shader()->getAttributeLocation("aTexCoords");
 	// vertex texture coords
-	glEnableVertexAttribArray(xx);
-	glVertexAttribPointer(xx, glmv2Size, GL_FLOAT, GL_FALSE, vertexSize,
-		(GLvoid*)(glmv3Size * sizeof(float)));
+	xx = shader()->getAttributeLocation("aTexCoords");
+	if (xx != -1)
+	{
+		format.attributes.push_back({ static_cast<GLuint>(xx), glmv2Size,
+			GL_FLOAT, GL_FALSE, glmv3Size * sizeof(float) });
+	}
 
 	// vertex normals
 	xx = shader()->getAttributeLocation("normal");
 	if (xx != -1)
 	{
-		glEnableVertexAttribArray(xx);
-		glVertexAttribPointer(xx, glmv3Size, GL_FLOAT, GL_FALSE, vertexSize,
-			(GLvoid*)(sizeof(float) * (glmv3Size + glmv2Size)));
+		format.attributes.push_back({ static_cast<GLuint>(xx), glmv3Size,
+			GL_FLOAT, GL_FALSE, sizeof(float) * (glmv3Size + glmv2Size) });
+	}
+	releaseMesh();
+	mMesh = GeometryPool::pool(format)->allocate(data->vertices.data(),
+		data->vertices.size(), data->indices.data(), data->indices.size());
+}
+
+void HeavyRenderer::setupCompact(const MeshDataHeavy* data)
+{
+	typedef VertexPacking::PositionNormalTexture Packed;
+	AABB bounds = data->bounds();
+	std::vector<Packed> packed(data->vertices.size());
+	for (size_t i = 0; i < packed.size(); i++)
+	{
+		const MeshDataHeavy::Vertex& v = data->vertices[i];
+		VertexPacking::quantise(v.position, bounds, packed[i].position);
+		packed[i].normal = VertexPacking::packNormal(VertexPacking::scaleNormal(v.normal, bounds));
+		packed[i].textureCoord = VertexPacking::packHalf2(v.textureCoord);
+	}
+	mLocalTransform = VertexPacking::dequantise(bounds);
+
+	// The shaders still see vec3/vec2 attributes; OpenGL does the unpacking.
+	GeometryPool::Format format;
+	format.stride = sizeof(Packed);
+	GLint xx = shader()->getAttributeLocation("aPos");
+	format.attributes.push_back({ static_cast<GLuint>(xx), 3,
+		GL_UNSIGNED_SHORT, GL_TRUE, offsetof(Packed, position) });
+	xx = shader()->getAttributeLocation("aTexCoords");
+	if (xx != -1)
+	{
+		format.attributes.push_back({ static_cast<GLuint>(xx), 2,
+			GL_HALF_FLOAT, GL_FALSE, offsetof(Packed, textureCoord) });
+	}
+	xx = shader()->getAttributeLocation("normal");
+	if (xx != -1)
+	{
+		format.attributes.push_back({ static_cast<GLuint>(xx), 4,
+			GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(Packed, normal) });
 	}
-	glBindVertexArray(0);
-	if (data->indices.size())
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); //Unbind the index buffer AFTER the vao has been unbound
+	releaseMesh();
+	mMesh = GeometryPool::pool(format)->allocate(packed.data(),
+		packed.size(), data->indices.data(), data->indices.size());
+}
+
+HeavyRenderer::~HeavyRenderer()
+{
+	releaseMesh();
+}
+
+void HeavyRenderer::releaseMesh()
+{
+	if (mMesh.pool != nullptr)
+		mMesh.pool->release(mMesh);
+	mMesh = GeometryPool::Allocation();
 }
 
 void HeavyRenderer::doRender() const
@@ -73,34 +115,13 @@ void HeavyRenderer::doRender() const
 		// https://www.reddit.com/r/opengl/comments/6gnc9x/trouble_with_framebuffer/
 		for (const auto& tex : mData->textures)
 		{
-			glActiveTexture(tex.imageUnit());
-			glBindTexture(tex.target(), tex.location());
+			GLStateCache::bindTexture(tex.imageUnit() - GL_TEXTURE0,
+				tex.target(), tex.location());
 			// associate sampler with textureImageUnit
 			constShader()->setInteger(tex.samplerName(), tex.imageUnit() - GL_TEXTURE0);
 		}
 	}
-	glBindVertexArray(mVao);
-
-	if (mData->indices.size())
-	{
-		glDrawElements(mIndicesMode,
-			static_cast<GLsizei>(mData->indices.size()), GL_UNSIGNED_INT, 0);
-	}
-	else if (mData->vertices.size())
-	{
-		glDrawArrays(mVertexMode, 0,
-			static_cast<GLsizei>(mData->vertices.size()));
-	}
-	if (mData->textures.size())
-	{
-		// clean up.
-		for (auto t : mData->textures)
-		{
-			glActiveTexture(t.imageUnit());
-			glBindTexture(t.target(), 0);
-		}
-	}
-	glBindVertexArray(0);
+	GeometryPool::draw(mMesh, mMesh.indexCount ? mIndicesMode : mVertexMode);
 }
 
 void HeavyRenderer::validate() const
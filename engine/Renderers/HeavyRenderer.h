@@ -7,6 +7,7 @@
 
 #include "../OWEngine/OWEngine.h"
 
+#include "GeometryPool.h"
 #include "RendererBase.h"
 
 class Particles;
@@ -17,21 +18,26 @@ class OWENGINE_API HeavyRenderer: public RendererBase
 public:
 	HeavyRenderer(Shader* shader)
 		: RendererBase(shader) {}
+	~HeavyRenderer();
 	void setup(const MeshDataHeavy* data, unsigned int vertexMode, 
 			unsigned int vertexLocation = 0);
 
 	virtual void doRender() const override;
+	glm::mat4 localTransform() const override { return mLocalTransform; }
 protected:
 	void validate() const;
 private:
+	void setupCompact(const MeshDataHeavy* data);
+	void releaseMesh();
 #pragma warning( push )
 #pragma warning( disable : 4251 )
 	const MeshDataHeavy* mData = nullptr;
 	unsigned int mIndicesMode = GL_INVALID_ENUM;
 	unsigned int mVertexMode = GL_INVALID_ENUM;
 	unsigned int mVertexLocation = GL_INVALID_ENUM;
-	unsigned int mVao = 0;
-	unsigned int mVbo = 0;
-	unsigned int mEbo = 0;
+	// The vertices and indices are kept in the GeometryPool for their format
+	GeometryPool::Allocation mMesh;
+	// Expands compact positions (MeshDataHeavy::compact)
+	glm::mat4 mLocalTransform = glm::mat4(1.0f);
 #pragma warning( pop )
 };
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "HelixWireRenderer.h"
+
+#include "../Core/ErrorHandling.h"
+
+#include "../Helpers/Shader.h"
+
+#include "GLStateCache.h"
+
+void HelixWireRenderer::setup(const std::vector<Wire>& wires, float length,
+	unsigned int rings, unsigned int pointsPerWire)
+{
+	validateBase();
+	if (wires.empty())
+		throw NMSLogicException("HelixWireRenderer has no wires.\n");
+	if (length <= 0.0f || rings < 2 || pointsPerWire < 3)
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "HelixWireRenderer needs a length, at least 2 rings and 3 points a wire. "
+			<< "Given length [" << length << "], rings [" << rings
+			<< "] and points [" << pointsPerWire << "].\n");
+	}
+	mWireCount = static_cast<GLsizei>(wires.size());
+	mPointsPerWire = pointsPerWire;
+
+	glGenVertexArrays(1, &mVao);
+	glGenBuffers(1, &mVbo);
+	GLStateCache::bindVertexArray(mVao);
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo);
+	glBufferData(GL_ARRAY_BUFFER, wires.size() * sizeof(Wire), wires.data(), GL_STATIC_DRAW);
+	// Two vec4 a wire
+	for (unsigned int i = 0; i < 2; i++)
+	{
+		glEnableVertexAttribArray(i);
+		glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, sizeof(Wire),
+			(void*)(i * sizeof(glm::vec4)));
+		glVertexAttribDivisor(i, 1);
+	}
+	GLStateCache::bindVertexArray(0);
+
+	shader()->use();
+	shader()->setFloat("ropeLength", length);
+	shader()->setInteger("pointsPerWire", static_cast<int>(pointsPerWire));
+	this->rings(rings);
+}
+
+void HelixWireRenderer::rings(unsigned int rings)
+{
+	if (rings < 2)
+		throw NMSLogicException("HelixWireRenderer needs at least 2 rings.\n");
+	mRings = rings;
+	shader()->setInteger("rings", static_cast<int>(rings), true);
+}
+
+GLsizei HelixWireRenderer::vertexCount() const
+{
+	// Two triangles between each pair of points on neighbouring rings and
+	// a fan of triangles over each end.
+	return static_cast<GLsizei>(((mRings - 1) * 6 + 2 * 3) * mPointsPerWire);
+}
+
+void HelixWireRenderer::doRender() const
+{
+	GLStateCache::bindVertexArray(mVao);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount(), mWireCount);
+}
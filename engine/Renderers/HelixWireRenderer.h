@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+
+#include "../OWEngine/OWEngine.h"
+
+#include "RendererBase.h"
+
+/*
+	Draws the wires of a rope as tubes swept along helices, one instance a
+	wire, with no mesh. helixWire.v.glsl makes each vertex from gl_VertexID
+	(the ring along the wire and the point around it) and the instance's
+	helix, so the only data is the 32 byte Wire for each wire. Wires in a
+	layer differ only by phase, and the cross section of every wire is
+	worked out from its radius and lay, so one draw covers the whole rope.
+	The number of rings along the rope is a uniform and can be changed with
+	rings() without making anything again.
+	The rope runs along z from 0 to length. A wire cut across the rope axis
+	is an ellipse stretched along its lay, as calcNativeRope() makes it.
+*/
+class OWENGINE_API HelixWireRenderer: public RendererBase
+{
+public:
+	struct Wire
+	{
+		// Of the strand centre about the rope axis
+		float strandPitch;
+		float strandPhase;
+		// Of the wire about the strand centre
+		float wirePitch;
+		float wirePhase;
+		float radius;
+		// Radians a unit of length. Negative for a left hand lay.
+		float strandTwist;
+		float wireTwist;
+		float unused = 0.0f;
+	};
+	HelixWireRenderer(Shader* shader)
+		: RendererBase(shader) {}
+	// rings and pointsPerWire at least 2 and 3.
+	void setup(const std::vector<Wire>& wires, float length,
+				unsigned int rings, unsigned int pointsPerWire);
+	void rings(unsigned int rings);
+	GLsizei wireCount() const { return mWireCount; }
+protected:
+	void doRender() const override;
+private:
+	GLsizei vertexCount() const;
+	GLsizei mWireCount = 0;
+	unsigned int mRings = 0;
+	unsigned int mPointsPerWire = 0;
+	unsigned int mVao = 0;
+	unsigned int mVbo = 0;
+};
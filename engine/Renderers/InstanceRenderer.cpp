@@ -1,12 +1,21 @@
 #include "InstanceRenderer.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <string>
+
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "../Core/CommonUtils.h"
 #include "../Core/ErrorHandling.h"
 
 #include "../Helpers/Shader.h"
+#include "../Helpers/VertexPacking.h"
+
+#include "GLStateCache.h"
 
 
 // Basically code pasted from:
@@ -20,6 +29,8 @@
 // One buffer for the particles centers.
 // One buffer for the particles colors.
 
+size_t InstanceRenderer::mBytesUploaded = 0;
+size_t InstanceRenderer::mLastBytesUploaded = 0;
 
 void InstanceRenderer::setup(const MeshDataInstance* meshData)
 {
@@ -45,10 +56,10 @@ void InstanceRenderer::setup(const MeshDataInstance* meshData)
 	mData.vertexMode = mData.vertexMode;
 	mData.vertexLocation = mData.vertexLocation;
 	glGenVertexArrays(1, &mVao);
-	glBindVertexArray(mVao);
+	GLStateCache::bindVertexArray(mVao);
 
 	glGenBuffers(3, &mVbo[0]);
-	glBindBuffer(GL_ARRAY_BUFFER, mVbo[0]);
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[0]);
 
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(mData.vertexLocation,
@@ -58,33 +69,90 @@ void InstanceRenderer::setup(const MeshDataInstance* meshData)
 	glBufferData(GL_ARRAY_BUFFER,
 		mData.verticesCount * vertexSize * sizeof(float), ff, GL_STATIC_DRAW);
 
-	// The positions
-	glEnableVertexAttribArray(1);
-	glBindBuffer(GL_ARRAY_BUFFER, mVbo[1]);
-	glVertexAttribPointer(
-		mData.positionLocation, // must match the layout in the shader.
-		3, // size : x + y + z => 3
-		GL_FLOAT, // type
-		GL_FALSE, // normalized?
-		0, // stride
-		(void*)0 // array buffer offset
-	);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mData.positionCount,
-		meshData->mInstancePositions.data(), GL_STREAM_DRAW);
-	// The colours
-	glEnableVertexAttribArray(2);
-	glBindBuffer(GL_ARRAY_BUFFER, mVbo[2]);
-	glVertexAttribPointer(
-		mData.colourLocation, // must match the layout in the shader.
-		4, // size : r + g + b + a => 4
-		GL_FLOAT, // type
-		GL_TRUE, // normalized? *** YES, this means that the 
-				 // unsigned char[4] will be accessible with a vec4 (floats) in the shader ***
-		0, // stride
-		(void*)0 // array buffer offset
-	);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec4) * meshData->mInstanceColours.size(),
-		meshData->mInstanceColours.data(), GL_STREAM_DRAW);
+	// The positions and colours, packed as the formats say. A CPU copy
+	// is kept in case they are updated later.
+	mPositionFormat = meshData->mPositionFormat;
+	mPositionBounds = meshData->mPositionBounds;
+	mColourFormat = meshData->mColourFormat;
+	mPalette = meshData->mPalette;
+	mCapacity = mData.positionCount;
+	Stream& pos = mStreams[0];
+	pos.vbo = mVbo[1];
+	pos.location = mData.positionLocation;
+	pos.components = 3;
+	if (mPositionFormat == MeshDataInstance::PositionFormat::Quantised)
+	{
+		pos.type = GL_UNSIGNED_SHORT;
+		pos.normalised = GL_TRUE;
+		pos.elementSize = 3 * sizeof(uint16_t);
+	}
+	else
+	{
+		pos.elementSize = sizeof(glm::vec3);
+	}
+	pos.shadow.resize(mCapacity * pos.elementSize);
+	packPositions(0, meshData->mInstancePositions.data(), mCapacity);
+
+	Stream& col = mStreams[1];
+	col.vbo = mVbo[2];
+	col.location = mData.colourLocation;
+	if (mColourFormat == MeshDataInstance::ColourFormat::PaletteIndex)
+	{
+		// The index as a float, used by instanced.v.glsl to look up palette.
+		col.components = 1;
+		col.type = GL_UNSIGNED_BYTE;
+		col.elementSize = 1;
+	}
+	else if (mColourFormat == MeshDataInstance::ColourFormat::RGBA8)
+	{
+		col.components = 4;
+		col.type = GL_UNSIGNED_BYTE;
+		col.normalised = GL_TRUE;
+		col.elementSize = 4;
+	}
+	else
+	{
+		col.components = 4;
+		col.elementSize = sizeof(glm::vec4);
+	}
+	col.shadow.resize(mCapacity * col.elementSize, 0);
+	if (!meshData->mInstanceColourIndices.empty())
+	{
+		std::memcpy(col.shadow.data(), meshData->mInstanceColourIndices.data(),
+			std::min(mCapacity, meshData->mInstanceColourIndices.size()));
+	}
+	else
+	{
+		packColours(0, meshData->mInstanceColours.data(),
+			std::min(mCapacity, meshData->mInstanceColours.size()));
+	}
+
+	for (Stream& s : mStreams)
+	{
+		glEnableVertexAttribArray(s.location);
+		GLStateCache::bindBuffer(GL_ARRAY_BUFFER, s.vbo);
+		glVertexAttribPointer(s.location, s.components, s.type, s.normalised, 0, (void*)0);
+		glBufferData(GL_ARRAY_BUFFER, s.shadow.size(), s.shadow.data(), GL_STREAM_DRAW);
+		mBytesUploaded += s.shadow.size();
+	}
+
+	// instanced.v.glsl turns the quantised positions back into world
+	// positions and looks up the palette.
+	glm::vec3 origin(0.0f);
+	glm::vec3 extent(1.0f);
+	if (mPositionFormat == MeshDataInstance::PositionFormat::Quantised)
+	{
+		glm::mat4 d = VertexPacking::dequantise(mPositionBounds);
+		origin = glm::vec3(d[3]);
+		extent = glm::vec3(d[0][0], d[1][1], d[2][2]);
+	}
+	shader()->use();
+	shader()->setVector3f("instanceOrigin", origin);
+	shader()->setVector3f("instanceExtent", extent);
+	shader()->setInteger("paletteSize", mColourFormat == MeshDataInstance::ColourFormat::PaletteIndex
+		? static_cast<int>(mPalette.size()) : 0);
+	for (size_t i = 0; i < mPalette.size(); i++)
+		shader()->setVector4f("palette[" + std::to_string(i) + "]", mPalette[i]);
 
 	// These functions are specific to glDrawArrays*Instanced*.
 	// The first parameter is the attribute buffer we're talking about.
@@ -108,12 +176,260 @@ void InstanceRenderer::setup(const MeshDataInstance* meshData)
 	// accidentally modify this VAO, but this rarely happens. Modifying other
 	// VAOs requires a call to glBindVertexArray anyways so we generally don't 
 	// unbind VAOs (nor VBOs) when it's not directly necessary.
-	glBindVertexArray(0);
+	GLStateCache::bindVertexArray(0);
+}
+
+void InstanceRenderer::positions(size_t first, const glm::vec3* data, size_t count)
+{
+	checkRange(first, count);
+	packPositions(first, data, count);
+	update(mStreams[0], first, count);
+}
+
+void InstanceRenderer::colours(size_t first, const glm::vec4* data, size_t count)
+{
+	checkRange(first, count);
+	packColours(first, data, count);
+	update(mStreams[1], first, count);
+}
+
+void InstanceRenderer::colourIndices(size_t first, const unsigned char* data, size_t count)
+{
+	if (mColourFormat != MeshDataInstance::ColourFormat::PaletteIndex)
+		throw NMSLogicException("InstanceRenderer colour indices without a palette.\n");
+	checkRange(first, count);
+	std::memcpy(mStreams[1].shadow.data() + first, data, count);
+	update(mStreams[1], first, count);
+}
+
+void InstanceRenderer::checkRange(size_t first, size_t count) const
+{
+	if (first + count > mData.positionCount)
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "InstanceRenderer update of [" << first << ", " << first + count
+			<< ") is past the instance count [" << mData.positionCount << "]\n");
+	}
+}
+
+void InstanceRenderer::packPositions(size_t first, const glm::vec3* data, size_t count)
+{
+	Stream& s = mStreams[0];
+	unsigned char* dest = s.shadow.data() + first * s.elementSize;
+	if (mPositionFormat == MeshDataInstance::PositionFormat::Float)
+	{
+		std::memcpy(dest, data, count * s.elementSize);
+		return;
+	}
+	uint16_t q[4];
+	for (size_t i = 0; i < count; i++)
+	{
+		VertexPacking::quantise(data[i], mPositionBounds, q);
+		std::memcpy(dest + i * s.elementSize, q, s.elementSize);
+	}
+}
+
+void InstanceRenderer::packColours(size_t first, const glm::vec4* data, size_t count)
+{
+	Stream& s = mStreams[1];
+	unsigned char* dest = s.shadow.data() + first * s.elementSize;
+	switch (mColourFormat)
+	{
+	case MeshDataInstance::ColourFormat::Float:
+		std::memcpy(dest, data, count * s.elementSize);
+		break;
+	case MeshDataInstance::ColourFormat::RGBA8:
+		for (size_t i = 0; i < count; i++)
+		{
+			uint32_t rgba = glm::packUnorm4x8(data[i]);
+			std::memcpy(dest + i * s.elementSize, &rgba, s.elementSize);
+		}
+		break;
+	case MeshDataInstance::ColourFormat::PaletteIndex:
+		// The nearest palette colour.
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t best = 0;
+			float bestDistance = FLT_MAX;
+			for (size_t p = 0; p < mPalette.size(); p++)
+			{
+				glm::vec4 diff = data[i] - mPalette[p];
+				float distance = glm::dot(diff, diff);
+				if (distance < bestDistance)
+				{
+					best = p;
+					bestDistance = distance;
+				}
+			}
+			dest[i] = static_cast<unsigned char>(best);
+		}
+		break;
+	}
+}
+
+void InstanceRenderer::update(Stream& s, size_t first, size_t count)
+{
+	if (count == 0)
+		return;
+	if (!mStreaming)
+		startStreaming();
+	else if (mRegionDrawn)
+		advanceRegion();
+	// Straight into the region for this frame. The others catch up when their turn comes.
+	write(s, mRegion, first, count);
+	markDirty(s, first, count);
+	s.dirtyBegin[mRegion] = SIZE_MAX;
+	s.dirtyEnd[mRegion] = 0;
+}
+
+void InstanceRenderer::instanceCount(size_t count)
+{
+	const size_t oldCount = mData.positionCount;
+	// Before allocate(), which writes the first positionCount instances.
+	mData.positionCount = count;
+	if (count > mCapacity)
+	{
+		mCapacity = std::max(count, mCapacity * 2);
+		for (Stream& s : mStreams)
+		{
+			// Zero anything left from before a shrink.
+			std::fill(s.shadow.begin() + oldCount * s.elementSize, s.shadow.end(), 0);
+			s.shadow.resize(mCapacity * s.elementSize, 0);
+			if (mStreaming)
+			{
+				allocate(s);
+			}
+			else
+			{
+				GLStateCache::bindBuffer(GL_ARRAY_BUFFER, s.vbo);
+				glBufferData(GL_ARRAY_BUFFER, mCapacity * s.elementSize,
+					s.shadow.data(), GL_STREAM_DRAW);
+				mBytesUploaded += mCapacity * s.elementSize;
+			}
+		}
+	}
+	else if (count > oldCount)
+	{
+		// Within the capacity but the buffers may still hold instances
+		// from before a shrink.
+		for (Stream& s : mStreams)
+		{
+			std::fill(s.shadow.begin() + oldCount * s.elementSize,
+				s.shadow.begin() + count * s.elementSize, 0);
+			if (mStreaming)
+			{
+				update(s, oldCount, count - oldCount);
+			}
+			else
+			{
+				GLStateCache::bindBuffer(GL_ARRAY_BUFFER, s.vbo);
+				glBufferSubData(GL_ARRAY_BUFFER, oldCount * s.elementSize,
+					(count - oldCount) * s.elementSize,
+					s.shadow.data() + oldCount * s.elementSize);
+				mBytesUploaded += (count - oldCount) * s.elementSize;
+			}
+		}
+	}
+}
+
+void InstanceRenderer::startStreaming()
+{
+	mStreaming = true;
+	mRegion = 0;
+	mRegionDrawn = false;
+	for (Stream& s : mStreams)
+		allocate(s);
+}
+
+void InstanceRenderer::allocate(Stream& s)
+{
+	// Orphans the old storage. The VAO still refers to the same buffer
+	// name so only the attribute offsets change, which doRender() sets.
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, s.vbo);
+	glBufferData(GL_ARRAY_BUFFER, RingSize * mCapacity * s.elementSize,
+		nullptr, GL_STREAM_DRAW);
+	for (unsigned int r = 0; r < RingSize; r++)
+	{
+		s.dirtyBegin[r] = SIZE_MAX;
+		s.dirtyEnd[r] = 0;
+	}
+	write(s, mRegion, 0, mData.positionCount);
+	markDirty(s, 0, mData.positionCount);
+	s.dirtyBegin[mRegion] = SIZE_MAX;
+	s.dirtyEnd[mRegion] = 0;
+}
+
+void InstanceRenderer::advanceRegion()
+{
+	mRegion = (mRegion + 1) % RingSize;
+	mRegionDrawn = false;
+	GLsync& fence = mFences[mRegion];
+	if (fence)
+	{
+		// Normally signalled long ago; RingSize frames have passed.
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+			;
+		glDeleteSync(fence);
+		fence = 0;
+	}
+	for (Stream& s : mStreams)
+	{
+		if (s.dirtyBegin[mRegion] < s.dirtyEnd[mRegion])
+		{
+			write(s, mRegion, s.dirtyBegin[mRegion],
+				s.dirtyEnd[mRegion] - s.dirtyBegin[mRegion]);
+			s.dirtyBegin[mRegion] = SIZE_MAX;
+			s.dirtyEnd[mRegion] = 0;
+		}
+	}
+}
+
+void InstanceRenderer::write(Stream& s, unsigned int region, size_t first, size_t count)
+{
+	if (count == 0)
+		return;
+	size_t bytes = count * s.elementSize;
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, s.vbo);
+	// The fence for this region has been waited on so there is no need
+	// for the driver to synchronise.
+	void* dest = glMapBufferRange(GL_ARRAY_BUFFER,
+		(region * mCapacity + first) * s.elementSize, bytes,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (dest == nullptr)
+		throw NMSException("InstanceRenderer could not map the instance buffer.\n");
+	std::memcpy(dest, s.shadow.data() + first * s.elementSize, bytes);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	mBytesUploaded += bytes;
+}
+
+void InstanceRenderer::markDirty(Stream& s, size_t first, size_t count)
+{
+	for (unsigned int r = 0; r < RingSize; r++)
+	{
+		s.dirtyBegin[r] = std::min(s.dirtyBegin[r], first);
+		s.dirtyEnd[r] = std::max(s.dirtyEnd[r], first + count);
+	}
+}
+
+void InstanceRenderer::endFrame()
+{
+	mLastBytesUploaded = mBytesUploaded;
+	mBytesUploaded = 0;
 }
 
 void InstanceRenderer::doRender() const
 {
-	glBindVertexArray(mVao);
+	GLStateCache::bindVertexArray(mVao);
+	if (mStreaming)
+	{
+		// Point the instance attributes at the region written this frame.
+		for (const Stream& s : mStreams)
+		{
+			GLStateCache::bindBuffer(GL_ARRAY_BUFFER, s.vbo);
+			glVertexAttribPointer(s.location, s.components, s.type,
+				s.normalised, 0, (void*)(mRegion * mCapacity * s.elementSize));
+		}
+	}
 
 	// Draw the particles !
 	// This draws many times a small triangle_strip (which looks like a quad).
@@ -123,6 +439,14 @@ void InstanceRenderer::doRender() const
 	glDrawArraysInstanced(mData.vertexMode, 0,
 			static_cast<GLsizei>(mData.verticesCount),
 			static_cast<GLsizei>(mData.positionCount));
+	if (mStreaming)
+	{
+		GLsync& fence = mFences[mRegion];
+		if (fence)
+			glDeleteSync(fence);
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		mRegionDrawn = true;
+	}
 }
 
 void InstanceRenderer::validate(const MeshDataInstance* meshData) const
@@ -132,8 +456,18 @@ void InstanceRenderer::validate(const MeshDataInstance* meshData) const
 		throw NMSLogicException("InstanceRenderer missing vertices");
 	if (meshData->mInstancePositions.empty())
 		throw NMSLogicException("InstanceRenderer missing positions");
-	if (meshData->mInstanceColours.empty())
+	if (meshData->mInstanceColours.empty() && meshData->mInstanceColourIndices.empty())
 		throw NMSLogicException("InstanceRenderer missing colours");
+	if (meshData->mColourFormat == MeshDataInstance::ColourFormat::PaletteIndex
+		&& (meshData->mPalette.empty() || meshData->mPalette.size() > MeshDataInstance::MaxPalette))
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "InstanceRenderer palette has [" << meshData->mPalette.size()
+			<< "] colours. It must have 1 to " << MeshDataInstance::MaxPalette << ".\n");
+	}
+	if (!meshData->mInstanceColourIndices.empty()
+		&& meshData->mColourFormat != MeshDataInstance::ColourFormat::PaletteIndex)
+		throw NMSLogicException("InstanceRenderer colour indices without a palette.\n");
 	if (meshData->mRenderData.positionDivisor == UINT_MAX)
 		throw NMSLogicException("InstanceRenderer missing position divisor");
 	if (meshData->mRenderData.colourDivisor == UINT_MAX)
@@ -19,11 +19,70 @@ public:
 		: RendererBase(shader) {}
 	void setup(const MeshDataInstance* meshData);
 	void doRender() const override;
+
+	// Per frame updates of part of the instance data. The first update
+	// switches the instance buffers to a ring of RingSize regions. Each frame 
+	// writes into the next region (once its fence says the GPU has finished
+	// with it) so the CPU never waits on the frame being drawn.
+	// Packed as the MeshDataInstance formats say.
+	void positions(size_t first, const glm::vec3* data, size_t count);
+	void colours(size_t first, const glm::vec4* data, size_t count);
+	// Only with ColourFormat::PaletteIndex
+	void colourIndices(size_t first, const unsigned char* data, size_t count);
+	// Change the number of instances drawn. Growing past the capacity
+	// reallocates the instance buffers but keeps the VAO. New instances
+	// are zero until updated.
+	void instanceCount(size_t count);
+	size_t instanceCount() const { return mData.positionCount; }
+
+	// Called once per frame by the Movie.
+	static void endFrame();
+	static size_t lastFrameBytesUploaded() { return mLastBytesUploaded; }
 private:
+	static constexpr unsigned int RingSize = 3;
 	void validate(const MeshDataInstance* meshData) const;
 #pragma warning( push )
 #pragma warning( disable : 4251 )
+	struct Stream
+	{
+		unsigned int vbo = 0;
+		unsigned int location = 0;
+		int components = 0;
+		GLenum type = GL_FLOAT;
+		GLboolean normalised = GL_FALSE;
+		size_t elementSize = 0;
+		// CPU copy of all the instances. Regions that fall behind are
+		// brought up to date from here.
+		std::vector<unsigned char> shadow;
+		// Element range [begin, end) of each region that is out of date.
+		size_t dirtyBegin[RingSize] = { SIZE_MAX, SIZE_MAX, SIZE_MAX };
+		size_t dirtyEnd[RingSize] = { 0, 0, 0 };
+	};
+	void checkRange(size_t first, size_t count) const;
+	// Into the shadow copies
+	void packPositions(size_t first, const glm::vec3* data, size_t count);
+	void packColours(size_t first, const glm::vec4* data, size_t count);
+	// Sends [first, first + count) of the shadow copy.
+	void update(Stream& s, size_t first, size_t count);
+	void startStreaming();
+	void allocate(Stream& s);
+	void advanceRegion();
+	void write(Stream& s, unsigned int region, size_t first, size_t count);
+	void markDirty(Stream& s, size_t first, size_t count);
+	static size_t mBytesUploaded;
+	static size_t mLastBytesUploaded;
+	Stream mStreams[2];
+	size_t mCapacity = 0;
+	bool mStreaming = false;
+	unsigned int mRegion = 0;
+	// Set once the current region has been drawn from. The next update moves on.
+	mutable bool mRegionDrawn = false;
+	mutable GLsync mFences[RingSize] = { 0, 0, 0 };
 	MeshDataInstance::RenderData mData;
+	MeshDataInstance::PositionFormat mPositionFormat = MeshDataInstance::PositionFormat::Float;
+	AABB mPositionBounds;
+	MeshDataInstance::ColourFormat mColourFormat = MeshDataInstance::ColourFormat::Float;
+	std::vector<glm::vec4> mPalette;
 	// mVbo[0] The VBO containing the triangles to draw
 	// mVbo[1] The VBO containing the positions of the particles
 	// mVbo[2] The VBO containing the colors of the particles
@@ -9,6 +9,8 @@
 
 #include "../Helpers/Shader.h"
 
+#include "GLStateCache.h"
+
 void LightRenderer::setup(const MeshDataLight& meshData)
 {
 	const float* ff = nullptr;
@@ -30,40 +32,20 @@ void LightRenderer::setup(const MeshDataLight& meshData)
 		vertexSize = 4;
 	}
 	validateBase();
-	mData.vertexMode = mData.vertexMode;
-	mData.vertexLocation = mData.vertexLocation;
-	glGenVertexArrays(1, &mVao);
-	glBindVertexArray(mVao);
-
-	glGenBuffers(1, &mVbo);
-	glBindBuffer(GL_ARRAY_BUFFER, mVbo);
 	shader()->use();
 	if (!mData.shaderColourName.empty())
 	{
 		shader()->setVector4f(mData.shaderColourName, mData.colour);
 	}
 
-	if (!meshData.mIndices.empty())
-	{
-		glGenBuffers(1, &mEbo);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEbo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-			sizeof(unsigned int) * static_cast<GLsizei>(meshData.mIndices.size()),
-			meshData.mIndices.data(), GL_STATIC_DRAW);
-	}
-	glVertexAttribPointer(mData.vertexLocation,
-		vertexSize, GL_FLOAT, GL_FALSE, 0, (void*)0);
-	glEnableVertexAttribArray(mData.vertexLocation);
-	glBufferData(GL_ARRAY_BUFFER,
-		mData.verticesCount * vertexSize * sizeof(float), ff, GL_STATIC_DRAW);
-
-	glEnableVertexAttribArray(0);
-
-	// You can unbind the VAO afterwards so other VAO calls won't 
-	// accidentally modify this VAO, but this rarely happens. Modifying other
-	// VAOs requires a call to glBindVertexArray anyways so we generally don't 
-	// unbind VAOs (nor VBOs) when it's not directly necessary.
-	glBindVertexArray(0);
+	// Every LightRenderer with the same vertex size and location shares a VAO.
+	GeometryPool::Format format;
+	format.stride = static_cast<GLsizei>(vertexSize * sizeof(float));
+	format.attributes.push_back({ mData.vertexLocation,
+		static_cast<GLint>(vertexSize), GL_FLOAT, GL_FALSE, 0 });
+	releaseMesh();
+	mMesh = GeometryPool::pool(format)->allocate(ff, mData.verticesCount,
+		meshData.mIndices.data(), meshData.mIndices.size());
 }
 
 void LightRenderer::setup(const std::vector<glm::vec3>& v,
@@ -92,6 +74,18 @@ void LightRenderer::setup(const std::vector<glm::vec4>& v,
 	setup(mdl);
 }
 
+LightRenderer::~LightRenderer()
+{
+	releaseMesh();
+}
+
+void LightRenderer::releaseMesh()
+{
+	if (mMesh.pool != nullptr)
+		mMesh.pool->release(mMesh);
+	mMesh = GeometryPool::Allocation();
+}
+
 void LightRenderer::doRender() const
 {
 	if (!mData.shaderColourName.empty())
@@ -99,18 +93,7 @@ void LightRenderer::doRender() const
 		constShader()->setVector4f(mData.shaderColourName, mData.colour);
 	}
 
-	glBindVertexArray(mVao);
-	if (mData.indicesCount)
-	{
-		glDrawElements(mData.indicesMode, 
-				static_cast<GLsizei>(mData.indicesCount), 
-				GL_UNSIGNED_INT, 0);
-	}
-	else
-	{
-		glDrawArrays(mData.vertexMode, 0, static_cast<GLsizei>(mData.verticesCount));
-	}
-	glBindVertexArray(0);
+	GeometryPool::draw(mMesh, mData.indicesCount ? mData.indicesMode : mData.vertexMode);
 }
 
 void LightRenderer::validate(const MeshDataLight* mdl)
@@ -9,6 +9,7 @@
 
 #include "../Helpers/MeshDataLight.h"
 
+#include "GeometryPool.h"
 #include "RendererBase.h"
 
 class OWENGINE_API LightRenderer : public RendererBase
@@ -16,6 +17,7 @@ class OWENGINE_API LightRenderer : public RendererBase
 public:
 	LightRenderer(Shader* shader)
 		: RendererBase(shader) {}
+	~LightRenderer();
 	void setup(const MeshDataLight& meshData);
 	void setup(const std::vector<glm::vec3>& v,
 		unsigned int vertexMode, unsigned int vertexLocation = 0);
@@ -24,14 +26,11 @@ public:
 	virtual void doRender() const override;
 private:
 	void validate(const MeshDataLight* mdl);
+	void releaseMesh();
 #pragma warning( push )
 #pragma warning( disable : 4251 )
 	MeshDataLight::RenderData mData;
-	// mVbo[0] The VBO containing the triangles to draw
-	// mVbo[1] The VBO containing the positions of the particles
-	// mVbo[2] The VBO containing the colors of the particles
-	unsigned int mVao = std::numeric_limits<unsigned int>::max();
-	unsigned int mVbo = std::numeric_limits<unsigned int>::max();
-	unsigned int mEbo = std::numeric_limits<unsigned int>::max();
+	// The vertices and indices are kept in the GeometryPool for their format
+	GeometryPool::Allocation mMesh;
 #pragma warning( pop )
 };
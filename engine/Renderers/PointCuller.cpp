@@ -0,0 +1,71 @@
+#include "PointCuller.h"
+
+#include "../Core/ErrorHandling.h"
+#include "../Core/GPUProfiler.h"
+#include "../Core/GlobalSettings.h"
+
+#include "../Helpers/Shader.h"
+
+#include "GLStateCache.h"
+
+void PointCuller::setup(unsigned int positionVbo, unsigned int colourVbo, GLsizei count,
+	GLenum positionType, GLenum colourType)
+{
+	if (mShader == nullptr)
+		throw NMSLogicException("PointCuller::Shader must be set");
+	mCount = count;
+
+	// The points to cull
+	glGenVertexArrays(1, &mInputVao);
+	GLStateCache::bindVertexArray(mInputVao);
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, positionVbo);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, positionType, positionType != GL_FLOAT, 0, (void*)0);
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, colourVbo);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, colourType, colourType != GL_FLOAT, 0, (void*)0);
+
+	// The points kept, room for all of them.
+	constexpr GLsizei stride = 2 * sizeof(glm::vec4);
+	glGenBuffers(1, &mOutputVbo);
+	glGenVertexArrays(1, &mOutputVao);
+	GLStateCache::bindVertexArray(mOutputVao);
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mOutputVbo);
+	glBufferData(GL_ARRAY_BUFFER, count * stride, nullptr, GL_DYNAMIC_COPY);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)sizeof(glm::vec4));
+	GLStateCache::bindVertexArray(0);
+
+	glGenTransformFeedbacks(1, &mTfo);
+	GLStateCache::bindTransformFeedback(mTfo);
+	GLStateCache::bindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, mOutputVbo);
+	GLStateCache::bindTransformFeedback(0);
+}
+
+void PointCuller::cull(const glm::mat4& proj, const glm::mat4& view,
+	const glm::mat4& model, const glm::vec3& cameraPos)
+{
+	GPUProfileScope gp("PointCuller");
+	mShader->use();
+	mShader->setStandardUniformValues(proj, view, model, cameraPos);
+	mShader->setFloat("viewportHeight",
+		static_cast<float>(globals->physicalWindowSize().y));
+	mShader->callMutators(proj, view, model, cameraPos, nullptr);
+
+	GLStateCache::enable(GL_RASTERIZER_DISCARD, true);
+	GLStateCache::bindVertexArray(mInputVao);
+	GLStateCache::bindTransformFeedback(mTfo);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, 0, mCount);
+	glEndTransformFeedback();
+	GLStateCache::bindTransformFeedback(0);
+	GLStateCache::enable(GL_RASTERIZER_DISCARD, false);
+}
+
+void PointCuller::draw(GLenum mode) const
+{
+	GLStateCache::bindVertexArray(mOutputVao);
+	glDrawTransformFeedback(mode, mTfo);
+}
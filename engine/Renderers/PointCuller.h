@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+
+#include "../OWEngine/OWEngine.h"
+
+class Shader;
+
+/*
+	Culls a buffer of points on the GPU with transform feedback so only the
+	visible ones are drawn. The cull program (e.g. starCull.v.glsl and
+	starCull.g.glsl) tests each point in the vertex shader and its geometry
+	shader only emits the points that pass. These are captured into an
+	output buffer with the same layout as the input and draw() renders them
+	with glDrawTransformFeedback(). Nothing is read back: the points and
+	their count stay on the GPU.
+	Each input point is a vec4 position and a vec4 colour (attributes 0
+	and 1), either floats or normalised integers of positionType and
+	colourType. The program must capture two interleaved vec4s, so the
+	points kept are always floats.
+*/
+class OWENGINE_API PointCuller
+{
+public:
+	PointCuller(Shader* shader)
+		: mShader(shader) {}
+	void setup(unsigned int positionVbo, unsigned int colourVbo, GLsizei count,
+			GLenum positionType = GL_FLOAT, GLenum colourType = GL_FLOAT);
+	// Runs the cull program with the rasterizer off.
+	void cull(const glm::mat4& proj, const glm::mat4& view,
+			const glm::mat4& model, const glm::vec3& cameraPos);
+	// Draws the points kept by the last cull() from the output buffer,
+	// with whatever program is in use.
+	void draw(GLenum mode) const;
+	Shader* shader() { return mShader; }
+private:
+	Shader* mShader;
+	GLsizei mCount = 0;
+	unsigned int mInputVao = 0;
+	unsigned int mOutputVao = 0;
+	unsigned int mOutputVbo = 0;
+	unsigned int mTfo = 0;
+};
@@ -0,0 +1,303 @@
+#include "PointSpriteRenderer.h"
+
+#include <algorithm>
+#include <string>
+
+#include <glm/gtc/packing.hpp>
+
+#include "../Core/ErrorHandling.h"
+#include "../Core/GlobalSettings.h"
+
+#include "../Helpers/Shader.h"
+#include "../Helpers/VertexPacking.h"
+
+#include "GLStateCache.h"
+#include "PointCuller.h"
+
+void PointSpriteRenderer::positionFormat(MeshDataInstance::PositionFormat format,
+	const AABB& bounds)
+{
+	if (format == MeshDataInstance::PositionFormat::Quantised
+		&& (bounds.size().x < 0 || bounds.size().y < 0 || bounds.size().z < 0))
+	{
+		throw NMSLogicException("PointSpriteRenderer quantised points need bounds.\n");
+	}
+	mPositionFormat = format;
+	mPositionBounds = bounds;
+	mPositionSize = format == MeshDataInstance::PositionFormat::Quantised
+		? 4 * sizeof(uint16_t) : sizeof(glm::vec4);
+}
+
+void PointSpriteRenderer::colourFormat(MeshDataInstance::ColourFormat format)
+{
+	if (format == MeshDataInstance::ColourFormat::PaletteIndex)
+		throw NMSLogicException("PointSpriteRenderer cannot use palette colours.\n");
+	mColourFormat = format;
+	mColourSize = format == MeshDataInstance::ColourFormat::RGBA8
+		? sizeof(uint32_t) : sizeof(glm::vec4);
+}
+
+GLenum PointSpriteRenderer::positionType() const
+{
+	return mPositionFormat == MeshDataInstance::PositionFormat::Quantised
+		? GL_UNSIGNED_SHORT : GL_FLOAT;
+}
+
+GLenum PointSpriteRenderer::colourType() const
+{
+	return mColourFormat == MeshDataInstance::ColourFormat::RGBA8
+		? GL_UNSIGNED_BYTE : GL_FLOAT;
+}
+
+void PointSpriteRenderer::allocate(GLsizei count, GLenum usage)
+{
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[0]);
+	glBufferData(GL_ARRAY_BUFFER, count * mPositionSize, nullptr, usage);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, positionType(), positionType() != GL_FLOAT, 0, (void*)0);
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[1]);
+	glBufferData(GL_ARRAY_BUFFER, count * mColourSize, nullptr, usage);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, colourType(), colourType() != GL_FLOAT, 0, (void*)0);
+}
+
+void PointSpriteRenderer::send(GLsizei first, const glm::vec4* points,
+	const glm::vec4* colours, GLsizei count)
+{
+	const void* positionData = points;
+	if (mPositionFormat == MeshDataInstance::PositionFormat::Quantised)
+	{
+		mPackedPositions.resize(4 * static_cast<size_t>(count));
+		const float range = MaxMagnitude - MinMagnitude;
+		for (GLsizei i = 0; i < count; i++)
+		{
+			uint16_t* q = &mPackedPositions[4 * static_cast<size_t>(i)];
+			VertexPacking::quantise(glm::vec3(points[i]), mPositionBounds, q);
+			float m = glm::clamp((points[i].w - MinMagnitude) / range, 0.0f, 1.0f);
+			q[3] = static_cast<uint16_t>(m * 65535.0f + 0.5f);
+		}
+		positionData = mPackedPositions.data();
+	}
+	const void* colourData = colours;
+	if (mColourFormat == MeshDataInstance::ColourFormat::RGBA8)
+	{
+		mPackedColours.resize(count);
+		for (GLsizei i = 0; i < count; i++)
+			mPackedColours[i] = glm::packUnorm4x8(colours[i]);
+		colourData = mPackedColours.data();
+	}
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[0]);
+	glBufferSubData(GL_ARRAY_BUFFER, first * mPositionSize, count * mPositionSize, positionData);
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[1]);
+	glBufferSubData(GL_ARRAY_BUFFER, first * mColourSize, count * mColourSize, colourData);
+}
+
+void PointSpriteRenderer::setupUnpacking()
+{
+	// Float points unpack to themselves.
+	glm::vec4 origin(0.0f);
+	glm::vec4 extent(1.0f);
+	if (mPositionFormat == MeshDataInstance::PositionFormat::Quantised)
+	{
+		glm::mat4 d = VertexPacking::dequantise(mPositionBounds);
+		origin = glm::vec4(glm::vec3(d[3]), MinMagnitude);
+		extent = glm::vec4(d[0][0], d[1][1], d[2][2], MaxMagnitude - MinMagnitude);
+	}
+	// The culler hands on floats so only it unpacks.
+	Shader* unpacker = mCuller != nullptr ? mCuller->shader() : shader();
+	unpacker->use();
+	unpacker->setVector4f("starOrigin", origin);
+	unpacker->setVector4f("starExtent", extent);
+	if (mCuller != nullptr)
+	{
+		shader()->use();
+		shader()->setVector4f("starOrigin", glm::vec4(0.0f));
+		shader()->setVector4f("starExtent", glm::vec4(1.0f));
+	}
+}
+
+void PointSpriteRenderer::setup(const std::vector<glm::vec4>& points,
+	const std::vector<glm::vec4>& colours)
+{
+	validateBase();
+	if (points.empty())
+		throw NMSLogicException("PointSpriteRenderer has no points.\n");
+	if (colours.size() != points.size())
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "PointSpriteRenderer has [" << points.size() << "] points but ["
+			<< colours.size() << "] colours.\n");
+	}
+	mCount = static_cast<GLsizei>(points.size());
+	glGenVertexArrays(1, &mVao);
+	GLStateCache::bindVertexArray(mVao);
+	glGenBuffers(2, &mVbo[0]);
+	allocate(mCount, GL_STATIC_DRAW);
+	send(0, points.data(), colours.data(), mCount);
+	GLStateCache::bindVertexArray(0);
+	// Not needed again.
+	mPackedPositions = std::vector<uint16_t>();
+	mPackedColours = std::vector<uint32_t>();
+	if (mCullShader != nullptr)
+	{
+		mCuller = new PointCuller(mCullShader);
+		mCuller->setup(mVbo[0], mVbo[1], mCount, positionType(), colourType());
+	}
+	setupUnpacking();
+	setupState();
+}
+
+void PointSpriteRenderer::setupProcedural(GLsizei count, int seed,
+	const glm::vec3& centre, const glm::vec3& spread,
+	const std::vector<glm::vec4>& palette)
+{
+	validateBase();
+	if (count <= 0)
+		throw NMSLogicException("PointSpriteRenderer has no points.\n");
+	if (mCullShader != nullptr)
+		throw NMSLogicException("PointSpriteRenderer cannot cull procedural points.\n");
+	if (palette.empty() || palette.size() > 8)
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "PointSpriteRenderer palette has [" << palette.size()
+			<< "] colours. It must have 1 to 8.\n");
+	}
+	mCount = count;
+	// Nothing in it but OpenGL will not draw without one.
+	glGenVertexArrays(1, &mVao);
+	shader()->use();
+	shader()->setInteger("seed", seed);
+	shader()->setVector3f("centre", centre);
+	shader()->setVector3f("spread", spread);
+	shader()->setInteger("paletteSize", static_cast<int>(palette.size()));
+	for (size_t i = 0; i < palette.size(); i++)
+		shader()->setVector4f("palette[" + std::to_string(i) + "]", palette[i]);
+	setupState();
+}
+
+void PointSpriteRenderer::setupCatalogue(const float* positions,
+	const unsigned int* colours, GLsizei count)
+{
+	validateBase();
+	if (count <= 0)
+		throw NMSLogicException("PointSpriteRenderer has no points.\n");
+	if (mCullShader != nullptr)
+		throw NMSLogicException("PointSpriteRenderer cannot cull catalogue points.\n");
+	mCount = count;
+	glGenVertexArrays(1, &mVao);
+	GLStateCache::bindVertexArray(mVao);
+	glGenBuffers(2, &mVbo[0]);
+
+	// One upload of the whole block. x, y and z are separate attributes
+	// reading from their own part of it.
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[0]);
+	glBufferData(GL_ARRAY_BUFFER, 3 * count * sizeof(float), positions, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 1, GL_FLOAT, GL_FALSE, 0, (void*)0);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 0, (void*)(count * sizeof(float)));
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, 0, (void*)(2 * count * sizeof(float)));
+
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[1]);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(unsigned int), colours, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (void*)0);
+	GLStateCache::bindVertexArray(0);
+	setupState();
+}
+
+void PointSpriteRenderer::setupPaged(GLsizei slots, GLsizei slotSize)
+{
+	validateBase();
+	if (slots <= 0 || slotSize <= 0)
+		throw NMSLogicException("PointSpriteRenderer has no slots.\n");
+	if (mCullShader != nullptr)
+		throw NMSLogicException("PointSpriteRenderer cannot cull paged points.\n");
+	mSlotSize = slotSize;
+	mSlotCounts.assign(slots, 0);
+	// All the memory the points will ever use, allocated once.
+	GLsizeiptr points = static_cast<GLsizeiptr>(slots) * slotSize;
+	glGenVertexArrays(1, &mVao);
+	GLStateCache::bindVertexArray(mVao);
+	glGenBuffers(2, &mVbo[0]);
+	allocate(static_cast<GLsizei>(points), GL_DYNAMIC_DRAW);
+	GLStateCache::bindVertexArray(0);
+	setupUnpacking();
+	setupState();
+}
+
+void PointSpriteRenderer::fillSlot(GLsizei slot, const std::vector<glm::vec4>& points,
+	const std::vector<glm::vec4>& colours)
+{
+	GLsizei count = static_cast<GLsizei>(std::min(points.size(), colours.size()));
+	count = std::min(count, mSlotSize);
+	if (count > 0)
+		send(slot * mSlotSize, points.data(), colours.data(), count);
+	mSlotCounts[slot] = count;
+	slotsChanged();
+}
+
+void PointSpriteRenderer::emptySlot(GLsizei slot)
+{
+	mSlotCounts[slot] = 0;
+	slotsChanged();
+}
+
+void PointSpriteRenderer::slotsChanged()
+{
+	mDrawFirsts.clear();
+	mDrawCounts.clear();
+	for (GLsizei i = 0; i < static_cast<GLsizei>(mSlotCounts.size()); i++)
+	{
+		if (mSlotCounts[i] > 0)
+		{
+			mDrawFirsts.push_back(i * mSlotSize);
+			mDrawCounts.push_back(mSlotCounts[i]);
+		}
+	}
+}
+
+void PointSpriteRenderer::setupState()
+{
+	// Additive so close stars brighten each other as the glow meshes did.
+	blendFunction(GL_SRC_ALPHA, GL_ONE);
+	GLfloat range[2] = { 1.0f, 64.0f };
+	glGetFloatv(GL_POINT_SIZE_RANGE, range);
+	shader()->use();
+	shader()->setFloat("maxPointSize", range[1]);
+	shader()->appendMutator([](const glm::mat4& OW_UNUSED(proj),
+		const glm::mat4& OW_UNUSED(view), const glm::mat4& OW_UNUSED(model),
+		const glm::vec3& OW_UNUSED(cameraPos), const Shader* shader)
+	{
+		shader->setFloat("viewportHeight",
+			static_cast<float>(globals->physicalWindowSize().y));
+	});
+}
+
+void PointSpriteRenderer::cull(const glm::mat4& proj, const glm::mat4& view,
+	const glm::mat4& model, const glm::vec3& cameraPos)
+{
+	if (mCuller == nullptr)
+		return;
+	mCuller->shader()->use();
+	mCuller->shader()->setFloat("nearDistance", mNearDistance);
+	mCuller->cull(proj, view, model, cameraPos);
+}
+
+void PointSpriteRenderer::doRender() const
+{
+	constShader()->setFloat("nearDistance", mNearDistance);
+	GLStateCache::bindVertexArray(mVao);
+	GLStateCache::enable(GL_PROGRAM_POINT_SIZE, true);
+	GLStateCache::depthMask(false);
+	if (mCuller != nullptr)
+		mCuller->draw(GL_POINTS);
+	else if (mSlotSize > 0)
+		glMultiDrawArrays(GL_POINTS, mDrawFirsts.data(), mDrawCounts.data(),
+			static_cast<GLsizei>(mDrawCounts.size()));
+	else
+		glDrawArrays(GL_POINTS, 0, mCount);
+	GLStateCache::depthMask(true);
+	GLStateCache::enable(GL_PROGRAM_POINT_SIZE, false);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+
+#include "../OWEngine/OWEngine.h"
+
+#include "../Geometry/BoundingBox.h"
+#include "../Helpers/MeshDataInstance.h"
+
+#include "RendererBase.h"
+
+class PointCuller;
+
+/*
+	Draws lots of stars as GL_POINTS sprites, one vertex each, instead of an
+	instanced mesh per star. A point is an xyz position with its magnitude in
+	w, plus a colour. starPoints.v.glsl sizes the sprite from the distance
+	and magnitude, and starPoints.f.glsl draws the glow analytically.
+	Blending is additive and depth writes are off so overlapping glows add up.
+	Points closer than nearDistance() to the camera, in view space, are
+	dropped by the vertex shader so the StarComponent can draw them as meshes.
+	Given a cull shader the points are first culled on the GPU by a
+	PointCuller; call cull() each frame before render().
+	setupProcedural() needs no points at all. starProcedural.v.glsl makes
+	each one from gl_VertexID and a seed so nothing is generated or stored
+	on the CPU. These cannot be culled.
+	setupCatalogue() takes the positions as all the x's then all the y's
+	then all the z's and RGBA8 colours, e.g. straight from a memory mapped
+	file, and uploads them as they are for starCatalogue.v.glsl. The stars
+	all have the magnitude set in the shader. These cannot be culled either.
+	setupPaged() makes room for a number of slots of points, filled and
+	emptied as regions are paged in and out (see RegionPager). Only the
+	full slots are drawn, with one glMultiDrawArrays. These are not culled.
+	The points of setup() and setupPaged() are packed as positionFormat()
+	and colourFormat() say, as MeshDataInstance does for instances. A
+	Quantised point is four normalised shorts, xyz across the bounds and w
+	from MinMagnitude to MaxMagnitude, and an RGBA8 colour one uint: 12
+	bytes a star instead of 32. starOrigin and starExtent unpack them in
+	the shaders. The culler unpacks them as it culls so the points it keeps
+	are floats.
+*/
+class OWENGINE_API PointSpriteRenderer: public RendererBase
+{
+public:
+	// The magnitudes a Quantised point can hold.
+	static constexpr float MinMagnitude = -8.0f;
+	static constexpr float MaxMagnitude = 24.0f;
+	PointSpriteRenderer(Shader* shader)
+		: RendererBase(shader) {}
+	// Before setup() or setupPaged(). Quantised points must be inside bounds.
+	void positionFormat(MeshDataInstance::PositionFormat format,
+				const AABB& bounds = AABB());
+	// Before setup() or setupPaged(). PaletteIndex is not supported.
+	void colourFormat(MeshDataInstance::ColourFormat format);
+	// The bytes one point and its colour take in the buffers.
+	size_t pointSize() const { return mPositionSize + mColourSize; }
+	// Before setup()
+	void culling(Shader* cullShader) { mCullShader = cullShader; }
+	void setup(const std::vector<glm::vec4>& points,
+				const std::vector<glm::vec4>& colours);
+	// palette has at most 8 colours.
+	void setupProcedural(GLsizei count, int seed, const glm::vec3& centre,
+				const glm::vec3& spread, const std::vector<glm::vec4>& palette);
+	// positions has 3 * count floats and colours count RGBA8.
+	void setupCatalogue(const float* positions, const unsigned int* colours,
+				GLsizei count);
+	void setupPaged(GLsizei slots, GLsizei slotSize);
+	// Points past slotSize are dropped.
+	void fillSlot(GLsizei slot, const std::vector<glm::vec4>& points,
+				const std::vector<glm::vec4>& colours);
+	void emptySlot(GLsizei slot);
+	void cull(const glm::mat4& proj, const glm::mat4& view,
+				const glm::mat4& model, const glm::vec3& cameraPos);
+	void nearDistance(float newValue) { mNearDistance = newValue; }
+	float nearDistance() const { return mNearDistance; }
+protected:
+	void doRender() const override;
+private:
+	void setupState();
+	void slotsChanged();
+	// Makes room for count points and points attributes 0 and 1 of the
+	// bound vertex array at them.
+	void allocate(GLsizei count, GLenum usage);
+	void send(GLsizei first, const glm::vec4* points,
+				const glm::vec4* colours, GLsizei count);
+	void setupUnpacking();
+	GLenum positionType() const;
+	GLenum colourType() const;
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	float mNearDistance = 0.0f;
+	Shader* mCullShader = nullptr;
+	PointCuller* mCuller = nullptr;
+	GLsizei mCount = 0;
+	unsigned int mVao = 0;
+	// mVbo[0] The positions and magnitudes
+	// mVbo[1] The colours
+	unsigned int mVbo[2] = { 0, 0 };
+	MeshDataInstance::PositionFormat mPositionFormat = MeshDataInstance::PositionFormat::Float;
+	AABB mPositionBounds;
+	MeshDataInstance::ColourFormat mColourFormat = MeshDataInstance::ColourFormat::Float;
+	size_t mPositionSize = sizeof(glm::vec4);
+	size_t mColourSize = sizeof(glm::vec4);
+	// Reused to pack the points before they are sent.
+	std::vector<uint16_t> mPackedPositions;
+	std::vector<uint32_t> mPackedColours;
+	// Paged
+	GLsizei mSlotSize = 0;
+	std::vector<GLsizei> mSlotCounts;
+	// The full slots
+	std::vector<GLint> mDrawFirsts;
+	std::vector<GLsizei> mDrawCounts;
+#pragma warning( pop )
+};
@@ -1,123 +1,54 @@
 #include "RendererBase.h"
 
+#include <cstring>
+#include <typeinfo>
+
 #include "../Core/ErrorHandling.h"
+#include "../Core/GPUProfiler.h"
 #include "../Core/GlobalSettings.h"
 #include "../Helpers/Shader.h"
 
+#include "GLStateCache.h"
+
+// The class name for the profiler. MSVC prefixes it with "class ".
+static const char* profileName(const std::type_info& ti)
+{
+	const char* name = ti.name();
+	return strncmp(name, "class ", 6) == 0 ? name + 6 : name;
+}
+
 void RendererBase::validateBase() const
 {
 	if (constShader() == nullptr)
 		throw NMSLogicException("RendererBase::Shader must be set");
 }
 
-/*
-* Following three classes use the dtor to restore values after being called in render.
-*/
-class OWENGINE_API PolygonModeRIAA
-{
-	static GLint mOriginalMode;
-	bool mActive = true;
-public:
-	PolygonModeRIAA(GLenum face, GLenum mode)
-		: mActive(face != UINT_MAX && mode != UINT_MAX)
-	{
-		if (mActive)
-		{
-			static bool onceOnly = true;
-			if (onceOnly)
-			{
-				glGetIntegerv(GL_POLYGON_MODE, &mOriginalMode);
-				onceOnly = false;
-			}
-			glPolygonMode(face, mode);
-		}
-	}
-	~PolygonModeRIAA()
-	{
-		if (mActive)
-			glPolygonMode(GL_FRONT_AND_BACK, mOriginalMode);
-	}
-};
-GLint PolygonModeRIAA::mOriginalMode;
-
-class OWENGINE_API LineWidthRIAA
-{
-	static GLfloat mOriginalWidth;
-	bool mActive = true;
-public:
-	LineWidthRIAA(float width)
-		: mActive(width >= 0)
-	{
-		if (mActive)
-		{
-			static bool onceOnly = true;
-			if (onceOnly)
-			{
-				glGetFloatv(GL_LINE_WIDTH, &mOriginalWidth);
-				onceOnly = false;
-			}
-			glLineWidth(width);
-		}
-	}
-	~LineWidthRIAA()
-	{
-		if (mActive)
-			glLineWidth(mOriginalWidth);
-	}
-};
-GLfloat LineWidthRIAA::mOriginalWidth;
-
-class OWENGINE_API BlendFuncRIAA
-{
-	static GLenum mSfactor;
-	static GLenum mDfactor;
-	bool mActive = true;
-public:
-	BlendFuncRIAA(GLenum sfactor, GLenum dfactor)
-		: mActive(sfactor != UINT_MAX && dfactor != UINT_MAX)
-	{
-		if (mActive)
-		{
-			glEnable(GL_BLEND);
-			//glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-			static bool onceOnly = true;
-			if (onceOnly)
-			{
-				mSfactor = GL_SRC_ALPHA; // jfw not sure why I did this? maybe delete both statics
-				mDfactor = GL_ONE_MINUS_SRC_ALPHA;
-				onceOnly = false;
-			}
-			glBlendFunc(sfactor, dfactor);
-		}
-	}
-	~BlendFuncRIAA()
-	{
-		if (mActive)
-		{
-			glDisable(GL_BLEND);
-			glBlendFunc(mSfactor, mDfactor);
-		}
-	}
-};
-
-GLenum BlendFuncRIAA::mSfactor;
-GLenum BlendFuncRIAA::mDfactor;
-
 void RendererBase::render(const glm::mat4& proj,
 	const glm::mat4& view, const glm::mat4& model,
 	const glm::vec3& cameraPos,
 	RenderTypes::ShaderMutator renderCb,
 	RenderTypes::ShaderResizer resizeCb) 
 {
-	PolygonModeRIAA temp1(mPolygonFace, mPolygonMode);
-	LineWidthRIAA temp2(mLineWidth);
-	BlendFuncRIAA temp3(mSfactor, mDfactor);
+	GPUProfileScope gp(GPUProfiler::enabled() ? profileName(typeid(*this)) : "");
+	// State not asked for by this renderer reverts to the default. The cache
+	// only calls OpenGL if the previous renderer left something different.
+	GLStateCache::polygonMode(mPolygonMode != UINT_MAX ? mPolygonMode : GL_FILL);
+	GLStateCache::lineWidth(mLineWidth >= 0 ? mLineWidth : 1.0f);
+	if (mSfactor != UINT_MAX && mDfactor != UINT_MAX)
+	{
+		GLStateCache::blend(true);
+		GLStateCache::blendFunc(mSfactor, mDfactor);
+	}
+	else
+	{
+		GLStateCache::blend(false);
+	}
 
+	glm::mat4 localModel = model * localTransform();
 	constShader()->use();
 	constShader()->callResizers(resizeCb);
-	const_cast<Shader*>(constShader())->setStandardUniformValues(proj, view, model, cameraPos);
-	constShader()->callMutators(proj, view, model, cameraPos, renderCb);
+	const_cast<Shader*>(constShader())->setStandardUniformValues(proj, view, localModel, cameraPos);
+	constShader()->callMutators(proj, view, localModel, cameraPos, renderCb);
 
 	doRender();
 }
@@ -15,6 +15,7 @@ class OWENGINE_API RendererBase
 {
 public:
 	RendererBase(Shader* sh = nullptr): mShader(sh) {}
+	virtual ~RendererBase() {}
 
 	const Shader* constShader() const  { return mShader; }
 	virtual Shader* shader() { return mShader; }
@@ -32,6 +33,9 @@ public:
 		mDfactor = dfactor;
 	}
 	virtual void prepare() {}
+	// Applied before the model matrix. Renderers whose vertices are stored
+	// quantised return the transform that expands them (see VertexPacking).
+	virtual glm::mat4 localTransform() const { return glm::mat4(1.0f); }
 	/*
 		virtual void buildBoundingBox(AABB& bb, const glm::mat4& proj,
 		const glm::mat4& view,
@@ -60,8 +64,8 @@ private:
 	Shader* mShader;
 #pragma warning( push )
 #pragma warning( disable : 4251 )
-	// OpenGL state variables. The default values are used as flags 
-	// in the various RIAA Utility classes in CommonUtils.h
+	// OpenGL state variables. The default values are used as flags meaning
+	// 'use the OpenGL default'. Applied through GLStateCache in render().
 
 	float mLineWidth = -1.0f;
 
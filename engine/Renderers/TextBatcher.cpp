@@ -0,0 +1,294 @@
+#include "TextBatcher.h"
+
+#include <algorithm>
+
+#include "../Core/ErrorHandling.h"
+
+#include "../Helpers/FontFactory.h"
+#include "../Helpers/Shader.h"
+#include "../Component/TextComponent.h"
+
+#include "GLStateCache.h"
+#include "TextRenderer.h"
+
+std::map<const FreeTypeFontAtlas::FontDetails*, TextBatcher*> TextBatcher::mBatches;
+std::vector<TextBatcher::Handle> TextBatcher::mHandles;
+std::vector<TextBatcher::LabelId> TextBatcher::mFreeHandles;
+size_t TextBatcher::mLastDraws = 0;
+size_t TextBatcher::mLastLabels = 0;
+
+static ShaderData* getBatchTextData()
+{
+	ShaderData* shaderData = new ShaderData();
+	shaderData->shaderV = "textStaticBatch.v.glsl";
+	shaderData->shaderF = "textBatch.f.glsl";
+	shaderData->shaderG = "";
+	shaderData->PVMName = "VP";
+	shaderData->projectionName = "";
+	shaderData->viewName = "";
+	shaderData->modelName = "";
+	return shaderData;
+}
+
+TextBatcher::TextBatcher(Shader* shader, const Texture& texture)
+	: RendererBase(shader), mTexture(texture)
+{
+	mTexture.samplerName("textureImageId");
+}
+
+std::vector<glm::vec4> TextBatcher::createText(const TextData& td,
+	const FreeTypeFontAtlas::FontDetails* font, AABB& bounds)
+{
+	if (td.text.empty())
+		throw NMSLogicException("Text to display is empty\n");
+	std::vector<glm::vec4> v4 = font->createText(td.text, td.fontSpacing.x, td.fontSpacing.y);
+	if (v4.empty())
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "No Triangles generated for Text ["
+			<< td.text << "] is empty\n");
+	}
+	bounds = TextRenderer::adjustPosition(v4, td.referencePos);
+	return v4;
+}
+
+TextBatcher::LabelId TextBatcher::add(const TextData& td, AABB& bounds)
+{
+	if (td.fontName.empty())
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "Font File name for Text ["
+			<< td.text << "] is empty\n");
+	}
+	const FreeTypeFontAtlas::FontDetails* font
+		= FontFactory().loadFreeTypeFont(td.fontName, td.fontHeight);
+	std::vector<glm::vec4> v4 = createText(td, font, bounds);
+
+	TextBatcher* batch;
+	auto iter = mBatches.find(font);
+	if (iter == mBatches.end())
+	{
+		batch = new TextBatcher(new Shader(getBatchTextData()), font->texture());
+		batch->setup();
+		mBatches[font] = batch;
+	}
+	else
+	{
+		batch = iter->second;
+	}
+	Label label;
+	label.centre = bounds.center();
+	label.anchor = label.centre;
+	label.count = static_cast<GLsizei>(v4.size());
+	label.first = static_cast<GLint>(batch->append(v4, td.colour, label.anchor));
+	size_t slot = batch->mLabels.size();
+	if (batch->mFreeLabels.empty())
+	{
+		batch->mLabels.push_back(label);
+	}
+	else
+	{
+		slot = batch->mFreeLabels.back();
+		batch->mFreeLabels.pop_back();
+		batch->mLabels[slot] = label;
+	}
+	if (mFreeHandles.empty())
+	{
+		mHandles.push_back({ batch, slot });
+		return mHandles.size() - 1;
+	}
+	LabelId id = mFreeHandles.back();
+	mFreeHandles.pop_back();
+	mHandles[id] = { batch, slot };
+	return id;
+}
+
+void TextBatcher::remove(LabelId id)
+{
+	Handle& h = mHandles.at(id);
+	if (h.batch == nullptr)
+		throw NMSLogicException("TextBatcher::remove() label already removed.\n");
+	Label& label = h.batch->mLabels[h.label];
+	label.alive = false;
+	label.submitted = false;
+	h.batch->mDeadVertices += label.count;
+	// Nothing is drawn from the dead range so it can wait until there
+	// is enough of it to be worth moving the live labels down.
+	if (h.batch->mDeadVertices > h.batch->mVertices.size() / 2)
+		h.batch->compact();
+	h.batch->mFreeLabels.push_back(h.label);
+	h.batch = nullptr;
+	mFreeHandles.push_back(id);
+}
+
+void TextBatcher::submit(LabelId id, const glm::mat4& model)
+{
+	const Handle& h = mHandles.at(id);
+	if (h.batch == nullptr)
+		throw NMSLogicException("TextBatcher::submit() label has been removed.\n");
+	Label& label = h.batch->mLabels[h.label];
+	glm::vec3 anchor = glm::vec3(model * glm::vec4(label.centre, 1.0f));
+	if (anchor != label.anchor)
+	{
+		label.anchor = anchor;
+		for (GLsizei i = 0; i < label.count; i++)
+			h.batch->mVertices[label.first + i].anchor = anchor;
+		h.batch->markDirty(label.first, label.count);
+	}
+	label.submitted = true;
+}
+
+glm::vec2 TextBatcher::pixelsPerUnit(const glm::vec2& viewport)
+{
+	// textStaticBatch.v.glsl offsets by coord * BillboardSize in NDC, which
+	// the resizer sets to Shader::scaleByAspectRatio({ 0.5, 0.5 }).
+	float aspectRatio = viewport.x / viewport.y;
+	glm::vec2 billboardSize = { 0.5f / aspectRatio, 0.5f };
+	if (aspectRatio < 1)
+		billboardSize.y *= aspectRatio;
+	return billboardSize * viewport * 0.5f;
+}
+
+size_t TextBatcher::append(const std::vector<glm::vec4>& v4,
+	const glm::vec4& colour, const glm::vec3& anchor)
+{
+	size_t first = mVertices.size();
+	for (const glm::vec4& coord : v4)
+		mVertices.push_back({ coord, anchor, colour });
+	markDirty(first, v4.size());
+	return first;
+}
+
+void TextBatcher::markDirty(size_t first, size_t count)
+{
+	mDirtyBegin = std::min(mDirtyBegin, first);
+	mDirtyEnd = std::max(mDirtyEnd, first + count);
+}
+
+void TextBatcher::compact()
+{
+	std::vector<Vertex> live;
+	live.reserve(mVertices.size() - mDeadVertices);
+	for (Label& label : mLabels)
+	{
+		if (!label.alive)
+		{
+			label.count = 0;
+			continue;
+		}
+		GLint first = static_cast<GLint>(live.size());
+		live.insert(live.end(), mVertices.begin() + label.first,
+			mVertices.begin() + label.first + label.count);
+		label.first = first;
+	}
+	mVertices.swap(live);
+	mDeadVertices = 0;
+	mDirtyBegin = 0;
+	mDirtyEnd = mVertices.size();
+}
+
+void TextBatcher::setup()
+{
+	validateBase();
+	glGenVertexArrays(1, &mVao);
+	GLStateCache::bindVertexArray(mVao);
+	glGenBuffers(1, &mVbo);
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo);
+
+	constexpr GLsizei stride = sizeof(Vertex);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride,
+		(void*)offsetof(Vertex, coord));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+		(void*)offsetof(Vertex, anchor));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride,
+		(void*)offsetof(Vertex, colour));
+	GLStateCache::bindVertexArray(0);
+
+	blendFunction(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	shader()->appendResizer([](const Shader* shader,
+		RenderTypes::ScaleByAspectRatioType scaler,
+		float aspectRatio)
+	{
+		glm::vec2 vv = { 0.5, 0.5 };
+		glm::vec2 v2 = scaler(vv);
+		shader->setVector2f("BillboardSize", v2);
+	});
+}
+
+void TextBatcher::upload()
+{
+	if (mDirtyBegin >= mDirtyEnd)
+		return;
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo);
+	if (mVertices.size() > mCapacity)
+	{
+		// Grow geometrically so adding labels one at a time stays cheap.
+		mCapacity = std::max(mVertices.size(), mCapacity * 2);
+		glBufferData(GL_ARRAY_BUFFER, mCapacity * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+		mDirtyBegin = 0;
+		mDirtyEnd = mVertices.size();
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, mDirtyBegin * sizeof(Vertex),
+		(mDirtyEnd - mDirtyBegin) * sizeof(Vertex), &mVertices[mDirtyBegin]);
+	mDirtyBegin = SIZE_MAX;
+	mDirtyEnd = 0;
+}
+
+void TextBatcher::buildRuns()
+{
+	// Labels submitted this frame, merged into runs of adjacent vertices.
+	std::vector<std::pair<GLint, GLsizei>> visible;
+	for (Label& label : mLabels)
+	{
+		if (label.submitted)
+		{
+			visible.push_back({ label.first, label.count });
+			label.submitted = false;
+		}
+	}
+	mLastLabels += visible.size();
+	std::sort(visible.begin(), visible.end());
+	mFirsts.clear();
+	mCounts.clear();
+	for (const auto& v : visible)
+	{
+		if (!mFirsts.empty() && mFirsts.back() + mCounts.back() == v.first)
+		{
+			mCounts.back() += v.second;
+		}
+		else
+		{
+			mFirsts.push_back(v.first);
+			mCounts.push_back(v.second);
+		}
+	}
+}
+
+void TextBatcher::flush(const glm::mat4& proj, const glm::mat4& view,
+	const glm::vec3& cameraPos)
+{
+	mLastDraws = 0;
+	mLastLabels = 0;
+	for (auto& iter : mBatches)
+	{
+		TextBatcher* batch = iter.second;
+		batch->buildRuns();
+		if (batch->mFirsts.empty())
+			continue;
+		batch->upload();
+		batch->render(proj, view, glm::mat4(1.0f), cameraPos);
+		mLastDraws++;
+	}
+}
+
+void TextBatcher::doRender() const
+{
+	GLStateCache::bindVertexArray(mVao);
+	GLStateCache::bindTexture(mTexture.imageUnit() - GL_TEXTURE0,
+		mTexture.target(), mTexture.location());
+	glMultiDrawArrays(GL_TRIANGLES, mFirsts.data(), mCounts.data(),
+		static_cast<GLsizei>(mFirsts.size()));
+}
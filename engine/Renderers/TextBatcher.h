@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <map>
+
+#include <glm/glm.hpp>
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+
+#include "../OWEngine/OWEngine.h"
+
+#include "../Geometry/BoundingBox.h"
+#include "../Helpers/FreeTypeFontAtlas.h"
+#include "../Helpers/Texture.h"
+
+#include "RendererBase.h"
+
+struct TextData;
+
+/*
+	Draws static (fixed screen size) text. All the labels that use the same font
+	atlas have their quads appended to one vertex buffer, each vertex carrying the
+	label position and colour, and are drawn with one glMultiDrawArrays call.
+	Labels are added once and then submit()ed every frame they are visible; the
+	Movie calls flush() once the scene has been rendered. Only the ranges of
+	labels that moved or changed are uploaded again.
+*/
+class OWENGINE_API TextBatcher : public RendererBase
+{
+public:
+	typedef size_t LabelId;
+	static constexpr LabelId NoLabel = SIZE_MAX;
+
+	// bounds is set to the bounds of the generated text (as TextRenderer::bounds())
+	static LabelId add(const TextData& td, AABB& bounds);
+	static void remove(LabelId id);
+	// The label is drawn this frame centred on model * bounds.center()
+	static void submit(LabelId id, const glm::mat4& model);
+	static void flush(const glm::mat4& proj, const glm::mat4& view,
+				const glm::vec3& cameraPos);
+	// Screen pixels per unit of the bounds from add() for a viewport of
+	// this size.
+	static glm::vec2 pixelsPerUnit(const glm::vec2& viewport);
+	// Number of draw calls and labels drawn in the last flush()
+	static size_t lastFrameDraws() { return mLastDraws; }
+	static size_t lastFrameLabels() { return mLastLabels; }
+protected:
+	void doRender() const override;
+private:
+	TextBatcher(Shader* shader, const Texture& texture);
+	void setup();
+	size_t append(const std::vector<glm::vec4>& v4, const glm::vec4& colour,
+				const glm::vec3& anchor);
+	void markDirty(size_t first, size_t count);
+	void compact();
+	void upload();
+	void buildRuns();
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	struct Vertex
+	{
+		glm::vec4 coord;
+		glm::vec3 anchor;
+		glm::vec4 colour;
+	};
+	struct Label
+	{
+		GLint first = 0;
+		GLsizei count = 0;
+		glm::vec3 centre = glm::vec3(0);
+		glm::vec3 anchor = glm::vec3(0);
+		bool alive = true;
+		bool submitted = false;
+	};
+	struct Handle
+	{
+		TextBatcher* batch;
+		size_t label;
+	};
+	static std::map<const FreeTypeFontAtlas::FontDetails*, TextBatcher*> mBatches;
+	static std::vector<Handle> mHandles;
+	// Removed ids, reused by add() so labels can come and go every frame.
+	static std::vector<LabelId> mFreeHandles;
+	static size_t mLastDraws;
+	static size_t mLastLabels;
+
+	static std::vector<glm::vec4> createText(const TextData& td,
+				const FreeTypeFontAtlas::FontDetails* font, AABB& bounds);
+	Texture mTexture;
+	std::vector<Vertex> mVertices;
+	std::vector<Label> mLabels;
+	std::vector<size_t> mFreeLabels;
+	size_t mDeadVertices = 0;
+	size_t mCapacity = 0;
+	// Vertex range [mDirtyBegin, mDirtyEnd) that must be sent to the GPU.
+	size_t mDirtyBegin = SIZE_MAX;
+	size_t mDirtyEnd = 0;
+	std::vector<GLint> mFirsts;
+	std::vector<GLsizei> mCounts;
+	unsigned int mVao = 0;
+	unsigned int mVbo = 0;
+#pragma warning( pop )
+};
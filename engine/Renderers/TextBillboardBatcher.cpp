@@ -0,0 +1,286 @@
+#include "TextBillboardBatcher.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "../Core/ErrorHandling.h"
+
+#include "../Helpers/FontFactory.h"
+#include "../Helpers/Shader.h"
+#include "../Component/TextComponent.h"
+
+#include "GLStateCache.h"
+#include "TextRenderer.h"
+
+std::map<const FreeTypeFontAtlas::FontDetails*, TextBillboardBatcher*> TextBillboardBatcher::mBatches;
+std::vector<TextBillboardBatcher::Handle> TextBillboardBatcher::mHandles;
+std::vector<TextBillboardBatcher::LabelId> TextBillboardBatcher::mFreeHandles;
+size_t TextBillboardBatcher::mLastDraws = 0;
+size_t TextBillboardBatcher::mLastLabels = 0;
+
+// The glyph buffer is bound to this unit. The font atlas uses unit 0.
+static const unsigned int GlyphTextureUnit = 1;
+// The smallest glyph count bucket.
+static const GLint MinBucketGlyphs = 4;
+
+static ShaderData* getBillboardTextData()
+{
+	ShaderData* shaderData = new ShaderData();
+	shaderData->shaderV = "textDynamicBillboard.v.glsl";
+	shaderData->shaderF = "textBatch.f.glsl";
+	shaderData->shaderG = "";
+	shaderData->PVMName = "VP";
+	shaderData->projectionName = "";
+	shaderData->viewName = "";
+	shaderData->modelName = "";
+	return shaderData;
+}
+
+static GLint bucketGlyphs(GLint glyphCount)
+{
+	GLint bucket = MinBucketGlyphs;
+	while (bucket < glyphCount)
+		bucket *= 2;
+	return bucket;
+}
+
+TextBillboardBatcher::TextBillboardBatcher(Shader* shader, const Texture& texture)
+	: RendererBase(shader), mTexture(texture)
+{
+	mTexture.samplerName("textureImageId");
+}
+
+TextBillboardBatcher::LabelId TextBillboardBatcher::add(const TextData& td,
+	const glm::vec3& scale, AABB& bounds)
+{
+	if (td.text.empty())
+		throw NMSLogicException("Text to display is empty\n");
+	if (td.fontName.empty())
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "Font File name for Text ["
+			<< td.text << "] is empty\n");
+	}
+	const FreeTypeFontAtlas::FontDetails* font
+		= FontFactory().loadFreeTypeFont(td.fontName, td.fontHeight);
+	TextBillboardBatcher* batch;
+	auto iter = mBatches.find(font);
+	if (iter == mBatches.end())
+	{
+		batch = new TextBillboardBatcher(new Shader(getBillboardTextData()), font->texture());
+		batch->setup();
+		mBatches[font] = batch;
+	}
+	else
+	{
+		batch = iter->second;
+	}
+
+	// The same text laid out the same way always gives the same glyphs.
+	std::stringstream key;
+	key << td.referencePos << ":" << td.fontSpacing.x << ":"
+		<< td.fontSpacing.y << ":" << td.text;
+	std::vector<glm::vec4> v4 = font->createText(td.text, td.fontSpacing.x, td.fontSpacing.y);
+	if (v4.empty())
+	{
+		throw NMSLogicException(std::stringstream()
+			<< "No Triangles generated for Text ["
+			<< td.text << "] is empty\n");
+	}
+	bounds = TextRenderer::adjustPosition(v4, td.referencePos);
+	auto range = batch->mGlyphRanges.find(key.str());
+	if (range == batch->mGlyphRanges.end())
+	{
+		// createText() makes 6 vertices per glyph. The first is the top
+		// left corner and the last the bottom right.
+		GlyphRange gr;
+		gr.first = static_cast<GLint>(batch->mGlyphs.size() / 2);
+		gr.count = static_cast<GLint>(v4.size() / 6);
+		for (size_t i = 0; i < v4.size(); i += 6)
+		{
+			batch->mGlyphs.push_back(v4[i]);
+			batch->mGlyphs.push_back(v4[i + 5]);
+		}
+		range = batch->mGlyphRanges.insert({ key.str(), gr }).first;
+	}
+
+	Label label;
+	label.centre = bounds.center();
+	label.instance.position = label.centre;
+	label.instance.size = glm::vec2(bounds.size() * scale);
+	label.instance.colour = td.colour;
+	label.instance.glyphFirst = range->second.first;
+	label.instance.glyphCount = range->second.count;
+	size_t slot = batch->mLabels.size();
+	if (batch->mFreeLabels.empty())
+	{
+		batch->mLabels.push_back(label);
+	}
+	else
+	{
+		slot = batch->mFreeLabels.back();
+		batch->mFreeLabels.pop_back();
+		batch->mLabels[slot] = label;
+	}
+	if (mFreeHandles.empty())
+	{
+		mHandles.push_back({ batch, slot });
+		return mHandles.size() - 1;
+	}
+	LabelId id = mFreeHandles.back();
+	mFreeHandles.pop_back();
+	mHandles[id] = { batch, slot };
+	return id;
+}
+
+void TextBillboardBatcher::remove(LabelId id)
+{
+	Handle& h = mHandles.at(id);
+	if (h.batch == nullptr)
+		throw NMSLogicException("TextBillboardBatcher::remove() label already removed.\n");
+	// The glyphs stay as other labels may share them.
+	h.batch->mLabels[h.label].alive = false;
+	h.batch->mLabels[h.label].submitted = false;
+	h.batch->mFreeLabels.push_back(h.label);
+	h.batch = nullptr;
+	mFreeHandles.push_back(id);
+}
+
+void TextBillboardBatcher::submit(LabelId id, const glm::mat4& model)
+{
+	const Handle& h = mHandles.at(id);
+	if (h.batch == nullptr)
+		throw NMSLogicException("TextBillboardBatcher::submit() label has been removed.\n");
+	Label& label = h.batch->mLabels[h.label];
+	label.instance.position = glm::vec3(model * glm::vec4(label.centre, 1.0f));
+	label.submitted = true;
+}
+
+void TextBillboardBatcher::setup()
+{
+	validateBase();
+	glGenVertexArrays(1, &mVao);
+	GLStateCache::bindVertexArray(mVao);
+	glGenBuffers(2, &mVbo[0]);
+
+	// Attribute 0 (coord) is only used by the non instanced path so it is
+	// left disabled. The instance attributes are pointed at each bucket in doRender().
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[0]);
+	for (unsigned int i = 1; i <= 4; i++)
+	{
+		glEnableVertexAttribArray(i);
+		glVertexAttribDivisor(i, 1);
+	}
+	GLStateCache::bindVertexArray(0);
+
+	glGenTextures(1, &mGlyphTexture);
+
+	blendFunction(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	shader()->use();
+	shader()->setInteger("instanced", 1);
+	shader()->setInteger("glyphs", GlyphTextureUnit);
+	shader()->appendMutator([](const glm::mat4& proj, const glm::mat4& view,
+		const glm::mat4& model, const glm::vec3& cameraPos, const Shader* shader)
+	{
+		glm::vec3 CameraRight_worldspace = { view[0][0], view[1][0], view[2][0] };
+		shader->setVector3f("CameraRight_worldspace", CameraRight_worldspace);
+		glm::vec3 CameraUp_worldspace = { view[0][1], view[1][1], view[2][1] };
+		shader->setVector3f("CameraUp_worldspace", CameraUp_worldspace);
+	});
+}
+
+void TextBillboardBatcher::uploadGlyphs()
+{
+	if (mGlyphsUploaded == mGlyphs.size())
+		return;
+	GLStateCache::bindBuffer(GL_TEXTURE_BUFFER, mVbo[1]);
+	if (mGlyphs.size() > mGlyphCapacity)
+	{
+		mGlyphCapacity = std::max(mGlyphs.size(), mGlyphCapacity * 2);
+		glBufferData(GL_TEXTURE_BUFFER, mGlyphCapacity * sizeof(glm::vec4), nullptr, GL_STATIC_DRAW);
+		mGlyphsUploaded = 0;
+		// Reattach the new storage to the texture.
+		GLStateCache::bindTexture(GlyphTextureUnit, GL_TEXTURE_BUFFER, mGlyphTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mVbo[1]);
+	}
+	// Glyphs are only ever appended.
+	glBufferSubData(GL_TEXTURE_BUFFER, mGlyphsUploaded * sizeof(glm::vec4),
+		(mGlyphs.size() - mGlyphsUploaded) * sizeof(glm::vec4), &mGlyphs[mGlyphsUploaded]);
+	mGlyphsUploaded = mGlyphs.size();
+}
+
+void TextBillboardBatcher::uploadInstances()
+{
+	// Gather the visible labels grouped by glyph count bucket.
+	mFrameInstances.clear();
+	mDraws.clear();
+	for (Label& label : mLabels)
+	{
+		if (label.submitted)
+		{
+			mFrameInstances.push_back(label.instance);
+			label.submitted = false;
+		}
+	}
+	mLastLabels += mFrameInstances.size();
+	if (mFrameInstances.empty())
+		return;
+	std::sort(mFrameInstances.begin(), mFrameInstances.end(),
+		[](const Instance& a, const Instance& b) { return a.glyphCount < b.glyphCount; });
+	for (size_t i = 0; i < mFrameInstances.size(); i++)
+	{
+		GLsizei vertexCount = bucketGlyphs(mFrameInstances[i].glyphCount) * 6;
+		if (mDraws.empty() || mDraws.back().vertexCount != vertexCount)
+			mDraws.push_back({ i, 0, vertexCount });
+		mDraws.back().instanceCount++;
+	}
+
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[0]);
+	if (mFrameInstances.size() > mInstanceCapacity)
+		mInstanceCapacity = std::max(mFrameInstances.size(), mInstanceCapacity * 2);
+	// Orphan the old storage so we never wait on last frame's draw.
+	glBufferData(GL_ARRAY_BUFFER, mInstanceCapacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, mFrameInstances.size() * sizeof(Instance),
+		mFrameInstances.data());
+}
+
+void TextBillboardBatcher::flush(const glm::mat4& proj, const glm::mat4& view,
+	const glm::vec3& cameraPos)
+{
+	mLastDraws = 0;
+	mLastLabels = 0;
+	for (auto& iter : mBatches)
+	{
+		TextBillboardBatcher* batch = iter.second;
+		batch->uploadInstances();
+		if (batch->mDraws.empty())
+			continue;
+		batch->uploadGlyphs();
+		batch->render(proj, view, glm::mat4(1.0f), cameraPos);
+		mLastDraws += batch->mDraws.size();
+	}
+}
+
+void TextBillboardBatcher::doRender() const
+{
+	GLStateCache::bindVertexArray(mVao);
+	GLStateCache::bindTexture(mTexture.imageUnit() - GL_TEXTURE0,
+		mTexture.target(), mTexture.location());
+	GLStateCache::bindTexture(GlyphTextureUnit, GL_TEXTURE_BUFFER, mGlyphTexture);
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo[0]);
+	constexpr GLsizei stride = sizeof(Instance);
+	for (const Draw& d : mDraws)
+	{
+		// No base instance in GL 3.3 so move the attributes to the bucket.
+		size_t base = d.firstInstance * sizeof(Instance);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+			(void*)(base + offsetof(Instance, position)));
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+			(void*)(base + offsetof(Instance, size)));
+		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride,
+			(void*)(base + offsetof(Instance, colour)));
+		glVertexAttribIPointer(4, 2, GL_INT, stride,
+			(void*)(base + offsetof(Instance, glyphFirst)));
+		glDrawArraysInstanced(GL_TRIANGLES, 0, d.vertexCount, d.instanceCount);
+	}
+}
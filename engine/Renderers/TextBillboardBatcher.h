@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+
+#include "../OWEngine/OWEngine.h"
+
+#include "../Geometry/BoundingBox.h"
+#include "../Helpers/FreeTypeFontAtlas.h"
+#include "../Helpers/Texture.h"
+
+#include "RendererBase.h"
+
+struct TextData;
+
+/*
+	Draws dynamic (camera facing, world sized) text as instances. The glyph
+	rectangles of every distinct string are stored once per font atlas in a
+	texture buffer; a label is just an instance record of position, size, colour
+	and glyph range. textDynamicBillboard.v.glsl expands each instance into its
+	glyph quads. Labels are grouped by glyph count (in powers of 2) so short
+	labels do not pay for the longest one, giving a handful of draws per font
+	whatever the number of labels.
+	Usage is the same as TextBatcher: add() once, submit() every visible frame
+	and the Movie calls flush() after the scene.
+*/
+class OWENGINE_API TextBillboardBatcher : public RendererBase
+{
+public:
+	typedef size_t LabelId;
+	static constexpr LabelId NoLabel = SIZE_MAX;
+
+	// scale is the component scale which sizes the billboard (as TextRendererDynamic)
+	static LabelId add(const TextData& td, const glm::vec3& scale, AABB& bounds);
+	static void remove(LabelId id);
+	// The label is drawn this frame centred on model * bounds.center()
+	static void submit(LabelId id, const glm::mat4& model);
+	static void flush(const glm::mat4& proj, const glm::mat4& view,
+				const glm::vec3& cameraPos);
+	static size_t lastFrameDraws() { return mLastDraws; }
+	static size_t lastFrameLabels() { return mLastLabels; }
+protected:
+	void doRender() const override;
+private:
+	TextBillboardBatcher(Shader* shader, const Texture& texture);
+	void setup();
+	void uploadGlyphs();
+	void uploadInstances();
+#pragma warning( push )
+#pragma warning( disable : 4251 )
+	struct Instance
+	{
+		glm::vec3 position;
+		glm::vec2 size;
+		glm::vec4 colour;
+		GLint glyphFirst;
+		GLint glyphCount;
+	};
+	struct Label
+	{
+		Instance instance;
+		glm::vec3 centre;
+		bool alive = true;
+		bool submitted = false;
+	};
+	struct GlyphRange
+	{
+		GLint first;
+		GLint count;
+	};
+	struct Handle
+	{
+		TextBillboardBatcher* batch;
+		size_t label;
+	};
+	struct Draw
+	{
+		size_t firstInstance;
+		GLsizei instanceCount;
+		GLsizei vertexCount;
+	};
+	static std::map<const FreeTypeFontAtlas::FontDetails*, TextBillboardBatcher*> mBatches;
+	static std::vector<Handle> mHandles;
+	// Removed ids, reused by add() so labels can come and go every frame.
+	static std::vector<LabelId> mFreeHandles;
+	static size_t mLastDraws;
+	static size_t mLastLabels;
+
+	Texture mTexture;
+	// Two texels per glyph: top left and bottom right (x, y, u, v)
+	std::vector<glm::vec4> mGlyphs;
+	// Glyph ranges already in mGlyphs keyed on the text and its layout.
+	std::map<std::string, GlyphRange> mGlyphRanges;
+	size_t mGlyphsUploaded = 0;
+	size_t mGlyphCapacity = 0;
+	std::vector<Label> mLabels;
+	std::vector<size_t> mFreeLabels;
+	std::vector<Instance> mFrameInstances;
+	std::vector<Draw> mDraws;
+	size_t mInstanceCapacity = 0;
+	unsigned int mVao = 0;
+	// mVbo[0] The instance records
+	// mVbo[1] The glyph texture buffer
+	unsigned int mVbo[2] = { 0, 0 };
+	unsigned int mGlyphTexture = 0;
+#pragma warning( pop )
+};
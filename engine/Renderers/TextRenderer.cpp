@@ -7,7 +7,9 @@
 #include "../Helpers/Shader.h"
 #include "../Component/TextComponent.h"
 
-AABB adjustPosition(std::vector<glm::vec4>& v4, unsigned int mReferencePos)
+#include "GLStateCache.h"
+
+AABB TextRenderer::adjustPosition(std::vector<glm::vec4>& v4, unsigned int mReferencePos)
 {
 	AABB bounds(v4);
 
@@ -75,10 +77,10 @@ void TextRenderer::setup(const TextComponent* tc, const glm::vec3& initialPositi
 	glGenVertexArrays(1, &mVao);
 	// bind the Vertex Array Object first, then bind and set 
 	// vertex buffer(s), and then configure vertex attributes(s).
-	glBindVertexArray(mVao);
+	GLStateCache::bindVertexArray(mVao);
 
 	glGenBuffers(1, &mVbo);
-	glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo);
 
 	shader()->use();
 	shader()->setVector4f("textcolor", td->colour);
@@ -96,7 +98,7 @@ void TextRenderer::setup(const TextComponent* tc, const glm::vec3& initialPositi
 	// accidentally modify this VAO, but this rarely happens. Modifying other
 	// VAOs requires a call to glBindVertexArray anyways so we generally don't 
 	// unbind VAOs (nor VBOs) when it's not directly necessary.
-	glBindVertexArray(0);
+	GLStateCache::bindVertexArray(0);
 	blendFunction(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	doSetup(tc, initialPosition);
 }
@@ -104,17 +106,14 @@ void TextRenderer::setup(const TextComponent* tc, const glm::vec3& initialPositi
 void TextRenderer::doRender() const
 {
 	constShader()->setVector4f("textcolor", mColour);
-	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-	glBindVertexArray(mVao);
-	glActiveTexture(mTexture.imageUnit());
-	glBindTexture(mTexture.target(), mTexture.location());
+	GLStateCache::bindVertexArray(mVao);
+	// Labels mostly share a font atlas so leave it bound for the next one.
+	GLStateCache::bindTexture(mTexture.imageUnit() - GL_TEXTURE0,
+		mTexture.target(), mTexture.location());
 	// associate sampler with name in shader
 	//shader()->setInteger(mTexture.samplerName(), mTexture.imageUnit() - GL_TEXTURE0);
 
 	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(mV4Size));
-	glBindVertexArray(0);
-	glActiveTexture(mTexture.imageUnit());
-	glBindTexture(mTexture.target(), 0);
 }
 
 void TextRenderer::validate(const TextComponent* tc) const
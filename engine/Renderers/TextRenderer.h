@@ -22,6 +22,9 @@ public:
 	void setup(const TextComponent* td, 
 				const glm::vec3& initialPosition = glm::vec3(0.0f, 0.0f, 0.0f));
 	AABB bounds() const { return mBounds; }
+	// Moves the text quads so they are placed around the origin according to 
+	// TextData::referencePos. Returns the bounds of the moved text.
+	static AABB adjustPosition(std::vector<glm::vec4>& v4, unsigned int referencePos);
 	virtual void doRender() const override;
 protected:
 	virtual void doSetup(const TextComponent* td, const glm::vec3& initialPosition) = 0;
@@ -7,6 +7,9 @@
 #include "../Core/ErrorHandling.h"
 
 #include "../Helpers/Shader.h"
+#include "../Helpers/VertexPacking.h"
+
+#include "GLStateCache.h"
 
 
 /*
@@ -18,6 +21,41 @@ https://fgiesen.wordpress.com/2011/07/01/a-trip-through-the-graphics-pipeline-20
 
 unsigned int VAOBuffer::mPrimitiveRestart = 0xFFFF;
 
+// Uploads indices to the bound target as 16 bit if every index (ignoring
+// restart) fits, otherwise as 32 bit with restart widened to 0xFFFFFFFF.
+static GLenum uploadIndices(GLenum target, const std::vector<unsigned int>& indices,
+	unsigned int restart)
+{
+	unsigned int largest = 0;
+	for (unsigned int i : indices)
+	{
+		if (i != restart)
+			largest = std::max(largest, i);
+	}
+	if (VertexPacking::fitsShortIndices(largest))
+	{
+		std::vector<uint16_t> shorts;
+		shorts.reserve(indices.size());
+		for (unsigned int i : indices)
+			shorts.push_back(static_cast<uint16_t>(i == restart ? 0xFFFF : i));
+		glBufferData(target, shorts.size() * sizeof(uint16_t), shorts.data(), GL_STATIC_DRAW);
+		return GL_UNSIGNED_SHORT;
+	}
+	std::vector<unsigned int> ints = indices;
+	for (unsigned int& i : ints)
+	{
+		if (i == restart)
+			i = 0xFFFFFFFF;
+	}
+	glBufferData(target, ints.size() * sizeof(unsigned int), ints.data(), GL_STATIC_DRAW);
+	return GL_UNSIGNED_INT;
+}
+
+static GLsizei indexSize(GLenum indexType)
+{
+	return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+}
+
 VAOBuffer::VAOBuffer()
 	: VAOBuffer(nullptr, DRAW_NONE) 
 {
@@ -33,6 +71,15 @@ void VAOBuffer::add(const MeshDataLight* meshData)
 {
 	validate(meshData);
 	MeshDataLight::RenderData rd = meshData->mRenderData;
+	// Indices are relative to this mesh so remember where its vertices start.
+	GLint baseVertex = static_cast<GLint>(mVec3.size() + mVec4.size());
+	if (mVertexFormat == COMPACT)
+	{
+		if (meshData->mIndices.empty() || meshData->mVec3.size() % 2)
+			throw NMSLogicException("VAOBuffer::add COMPACT needs indexed position/normal pairs.");
+		// A position and its normal become one vertex.
+		baseVertex /= 2;
+	}
 	if (!meshData->mVec3.empty())
 	{
 		mVec3.insert(mVec3.end(), meshData->mVec3.begin(), meshData->mVec3.end());
@@ -58,8 +105,23 @@ void VAOBuffer::add(const MeshDataLight* meshData)
 	}
 	if (!meshData->mIndices.empty())
 	{
-		mIndices.insert(mIndices.end(), meshData->mIndices.begin(), meshData->mIndices.end());
-		rd.indicesCount = sizeof(unsigned int) * static_cast<GLsizei>(meshData->mIndices.size());
+		mFirstIndices.push_back(static_cast<GLuint>(mIndices.size()));
+		mIndexCounts.push_back(static_cast<GLsizei>(meshData->mIndices.size()));
+		mBaseVertices.push_back(baseVertex);
+		if (mVertexFormat == COMPACT)
+		{
+			for (unsigned int i : meshData->mIndices)
+			{
+				if (i % 2)
+					throw NMSLogicException("VAOBuffer::add COMPACT index refers to a normal.");
+				mIndices.push_back(i / 2);
+			}
+		}
+		else
+		{
+			mIndices.insert(mIndices.end(), meshData->mIndices.begin(), meshData->mIndices.end());
+		}
+		rd.indicesCount = meshData->mIndices.size();
 	}
 	mData.push_back(rd);
 }
@@ -110,10 +172,10 @@ void VAOBuffer::prepare()
 	validateBase();
 	if (mVao == std::numeric_limits<unsigned int>::max())
 		glGenVertexArrays(1, &mVao);
-	glBindVertexArray(mVao);
+	GLStateCache::bindVertexArray(mVao);
 
 	glGenBuffers(1, &mVbo);
-	glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+	GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo);
 	shader()->use();
 	if (!mData[0].shaderColourName.empty())
 	{
@@ -123,12 +185,17 @@ void VAOBuffer::prepare()
 	if (!mIndices.empty())
 	{
 		glGenBuffers(1, &mEbo);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEbo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-			sizeof(unsigned int) * static_cast<GLsizei>(mIndices.size()),
-			mIndices.data(), GL_STATIC_DRAW);
+		GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEbo);
+		mIndexType = uploadIndices(GL_ELEMENT_ARRAY_BUFFER, mIndices, UINT_MAX);
+		mIndexOffsets.clear();
+		for (GLuint first : mFirstIndices)
+			mIndexOffsets.push_back((const void*)(size_t(first) * indexSize(mIndexType)));
 	}
-	if (mVec4.size())
+	if (mVertexFormat == COMPACT)
+	{
+		prepareCompact();
+	}
+	else if (mVec4.size())
 	{
 		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (void*)0);
 		glEnableVertexAttribArray(0); //mData.vertexLocation);
@@ -148,11 +215,37 @@ void VAOBuffer::prepare()
 	if (mDrawType == RenderType::DRAW_PRIMITIVE)
 	{
 		glGenBuffers(1, &mPrimitiveEbo);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mPrimitiveEbo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * mPrimitiveIndices.size(), mPrimitiveIndices.data(), GL_STATIC_DRAW);
+		GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mPrimitiveEbo);
+		mPrimitiveIndexType = uploadIndices(GL_ELEMENT_ARRAY_BUFFER, mPrimitiveIndices, mPrimitiveRestart);
 	}
 
 	glEnableVertexAttribArray(0);
+	if (mDrawType == RenderType::DRAW_MULTI_INDEXED)
+	{
+		if (mIndexCounts.size() != mData.size())
+			throw NMSLogicException("VAOBuffer::prepare DRAW_MULTI_INDEXED needs indices for every mesh.");
+		for (const MeshDataLight::RenderData& rd : mData)
+		{
+			if (rd.indicesMode != mData[0].indicesMode)
+				throw NMSLogicException("VAOBuffer::prepare DRAW_MULTI_INDEXED meshes must have the same indicesMode.");
+		}
+		if (GLAD_GL_VERSION_4_3)
+		{
+			// The draw commands live on the GPU so the draw is a single call
+			// with nothing read from client memory.
+			std::vector<DrawElementsIndirectCommand> commands;
+			for (size_t i = 0; i < mIndexCounts.size(); i++)
+			{
+				commands.push_back({ static_cast<GLuint>(mIndexCounts[i]), 1,
+					mFirstIndices[i], mBaseVertices[i], 0 });
+			}
+			glGenBuffers(1, &mIndirectBuffer);
+			GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, mIndirectBuffer);
+			glBufferData(GL_DRAW_INDIRECT_BUFFER,
+				commands.size() * sizeof(DrawElementsIndirectCommand),
+				commands.data(), GL_STATIC_DRAW);
+		}
+	}
 	if (mDrawType == RenderType::DRAW_MULTI)
 	{
 		GLint startIndex = 0;
@@ -168,9 +261,43 @@ void VAOBuffer::prepare()
 	// accidentally modify this VAO, but this rarely happens. Modifying other
 	// VAOs requires a call to glBindVertexArray anyways so we generally don't 
 	// unbind VAOs (nor VBOs) when it's not directly necessary.
-	glBindVertexArray(0);
+	GLStateCache::bindVertexArray(0);
 	if (!mIndices.empty())
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); //Unbind the index buffer AFTER the vao has been unbound
+		GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); //Unbind the index buffer AFTER the vao has been unbound
+}
+
+void VAOBuffer::prepareCompact()
+{
+	if (mVec3.empty() || mIndexCounts.size() != mData.size())
+		throw NMSLogicException("VAOBuffer::prepare COMPACT needs indexed vec3 meshes.");
+	if (mDrawType != RenderType::DRAW_ARRAYS && mDrawType != RenderType::DRAW_MULTI_INDEXED)
+		throw NMSLogicException("VAOBuffer::prepare COMPACT needs DRAW_ARRAYS or DRAW_MULTI_INDEXED.");
+	glm::vec3 minPoint = mVec3[0];
+	glm::vec3 maxPoint = mVec3[0];
+	for (size_t i = 0; i < mVec3.size(); i += 2)
+	{
+		minPoint = glm::min(minPoint, mVec3[i]);
+		maxPoint = glm::max(maxPoint, mVec3[i]);
+	}
+	AABB bounds(minPoint, maxPoint, false);
+	std::vector<VertexPacking::PositionNormal> packed(mVec3.size() / 2);
+	for (size_t i = 0; i < packed.size(); i++)
+	{
+		VertexPacking::quantise(mVec3[i * 2], bounds, packed[i].position);
+		packed[i].normal = VertexPacking::packNormal(
+			VertexPacking::scaleNormal(mVec3[i * 2 + 1], bounds));
+	}
+	// The shaders see [0, 1] positions; the model matrix puts them back.
+	mLocalTransform = VertexPacking::dequantise(bounds);
+
+	constexpr GLsizei stride = sizeof(VertexPacking::PositionNormal);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+		(void*)offsetof(VertexPacking::PositionNormal, position));
+	glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+		(void*)offsetof(VertexPacking::PositionNormal, normal));
+	glBufferData(GL_ARRAY_BUFFER, packed.size() * stride, packed.data(), GL_STATIC_DRAW);
 }
 
 //void VAOBuffer::scale(const glm::vec3& factor)
@@ -196,32 +323,56 @@ void VAOBuffer::doRender() const
 		constShader()->setVector4f(mData[0].shaderColourName, mData[0].colour);
 	}
 
-	glBindVertexArray(mVao);
-	glPolygonMode(GL_FRONT_AND_BACK, mData[0].mPolygonMode_mode);
+	GLStateCache::bindVertexArray(mVao);
+	GLStateCache::polygonMode(mData[0].mPolygonMode_mode);
 	if (mDrawType == RenderType::DRAW_PRIMITIVE)
 	{
 		// FPS = 27/28
-		glBindBuffer(GL_ARRAY_BUFFER, mVbo);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mPrimitiveEbo);
+		GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVbo);
+		GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mPrimitiveEbo);
+		GLStateCache::enable(GL_PRIMITIVE_RESTART, true);
+		glPrimitiveRestartIndex(mPrimitiveIndexType == GL_UNSIGNED_SHORT ? 0xFFFF : 0xFFFFFFFF);
 		checkGLError();
-		glDrawElements(mData[0].vertexMode, mPrimitiveIndices.size(), GL_UNSIGNED_INT, 0);
+		glDrawElements(mData[0].vertexMode, static_cast<GLsizei>(mPrimitiveIndices.size()),
+			mPrimitiveIndexType, 0);
 		checkGLError();
+		GLStateCache::enable(GL_PRIMITIVE_RESTART, false);
 	}
 	if (mDrawType == RenderType::DRAW_ARRAYS)
 	{
 		// FPS = 26/27
 		size_t sum = 0;
+		size_t indexed = 0;
 		for (const MeshDataLight::RenderData& rd : mData)
 		{
-			if (mIndices.size())
+			if (rd.indicesCount)
 			{
-				glDrawElements(rd.indicesMode, static_cast<GLsizei>(rd.indicesCount), GL_UNSIGNED_INT, 0);
+				glDrawElementsBaseVertex(rd.indicesMode, mIndexCounts[indexed],
+					mIndexType, mIndexOffsets[indexed],
+					mBaseVertices[indexed]);
+				indexed++;
 			}
 			else
 			{
 				glDrawArrays(rd.vertexMode, sum, static_cast<GLsizei>(rd.verticesCount));
-				sum += rd.verticesCount;
 			}
+			sum += rd.verticesCount;
+		}
+	}
+	if (mDrawType == RenderType::DRAW_MULTI_INDEXED)
+	{
+		if (mIndirectBuffer)
+		{
+			GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, mIndirectBuffer);
+			glMultiDrawElementsIndirect(mData[0].indicesMode, mIndexType,
+				nullptr, static_cast<GLsizei>(mIndexCounts.size()), 0);
+		}
+		else
+		{
+			// GL 3.3 fallback. Still one call but the offsets come from client memory.
+			glMultiDrawElementsBaseVertex(mData[0].indicesMode, mIndexCounts.data(),
+				mIndexType, mIndexOffsets.data(),
+				static_cast<GLsizei>(mIndexCounts.size()), mBaseVertices.data());
 		}
 	}
 	if (mDrawType == RenderType::DRAW_MULTI)
@@ -229,7 +380,6 @@ void VAOBuffer::doRender() const
 		// FPS = 27/28
 		glMultiDrawArrays(mData[0].vertexMode, mMultiArrayStartIndexes.data(), mMultiArrayVertexCount.data(), mData.size());
 	}
-	glBindVertexArray(0);
 }
 
 void VAOBuffer::validate(const MeshDataLight* mdl)
@@ -253,6 +403,14 @@ void VAOBuffer::clear()
 	mPrimitiveIndices.clear();
 	mMultiArrayVertexCount.clear();
 	mIndices.clear();
+	mIndexCounts.clear();
+	mFirstIndices.clear();
+	mIndexOffsets.clear();
+	mBaseVertices.clear();
+	mIndirectBuffer = 0;
+	mIndexType = GL_UNSIGNED_INT;
+	mPrimitiveIndexType = GL_UNSIGNED_INT;
+	mLocalTransform = glm::mat4(1.0f);
 	mVao = std::numeric_limits<unsigned int>::max();
 	mVbo = std::numeric_limits<unsigned int>::max();
 	mEbo = std::numeric_limits<unsigned int>::max();
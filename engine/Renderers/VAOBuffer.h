@@ -17,7 +17,14 @@ class Shader;
 class OWENGINE_API VAOBuffer : public RendererBase
 {
 public:
-	enum RenderType { DRAW_NONE, DRAW_ARRAYS, DRAW_MULTI, DRAW_PRIMITIVE };
+	// DRAW_MULTI_INDEXED draws every indexed mesh with one call. All the
+	// meshes must use the same indicesMode.
+	enum RenderType { DRAW_NONE, DRAW_ARRAYS, DRAW_MULTI, DRAW_PRIMITIVE, DRAW_MULTI_INDEXED };
+	// COMPACT stores vec3 data that is interleaved position/normal pairs
+	// (as made by RopeNormaliser::createNormals(points, 1, 2)) as 16 bit
+	// positions within the bounds and 2_10_10_10 normals: 12 bytes a vertex
+	// instead of 24. Every mesh must be indexed.
+	enum VertexFormat { FULL, COMPACT };
 	VAOBuffer();
 	VAOBuffer(Shader* shader, RenderType rt);
 	void clear();
@@ -27,11 +34,14 @@ public:
 	void add(const std::vector<glm::vec4>& v,
 		unsigned int vertexMode, unsigned int vertexLocation = 0);
 	void addLightSource(RendererBase* aLight);
+	void vertexFormat(VertexFormat vf) { mVertexFormat = vf; }
+	glm::mat4 localTransform() const override { return mLocalTransform; }
 	virtual void prepare() override;
 	//void scale(const glm::vec3& factor);
 	virtual void doRender() const override;
 private:
 	void validate(const MeshDataLight* mdl);
+	void prepareCompact();
 #pragma warning( push )
 #pragma warning( disable : 4251 )
 	std::vector<MeshDataLight::RenderData> mData;
@@ -42,6 +52,23 @@ private:
 	static unsigned int mPrimitiveRestart;
 	std::vector<GLsizei> mMultiArrayVertexCount;
 	std::vector<unsigned int> mIndices;
+	// Per mesh offsets into mIndices and the vertex arrays. mIndexOffsets
+	// are in bytes so are only known once the index type is chosen.
+	std::vector<GLsizei> mIndexCounts;
+	std::vector<GLuint> mFirstIndices;
+	std::vector<const void*> mIndexOffsets;
+	std::vector<GLint> mBaseVertices;
+	// Layout required by glMultiDrawElementsIndirect
+	struct DrawElementsIndirectCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+	// Only used when GL 4.3 is available.
+	unsigned int mIndirectBuffer = 0;
 	// mVbo[0] The VBO containing the triangles to draw
 	// mVbo[1] The VBO containing the positions of the particles
 	// mVbo[2] The VBO containing the colors of the particles
@@ -50,5 +77,10 @@ private:
 	unsigned int mEbo = std::numeric_limits<unsigned int>::max();
 	unsigned int mPrimitiveEbo = std::numeric_limits<unsigned int>::max();
 	RenderType mDrawType = DRAW_NONE;
+	VertexFormat mVertexFormat = FULL;
+	// GL_UNSIGNED_SHORT when every index fits.
+	GLenum mIndexType = GL_UNSIGNED_INT;
+	GLenum mPrimitiveIndexType = GL_UNSIGNED_INT;
+	glm::mat4 mLocalTransform = glm::mat4(1.0f);
 #pragma warning( pop )
 };
\ No newline at end of file
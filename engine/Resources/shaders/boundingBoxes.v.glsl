@@ -0,0 +1,17 @@
+#version 330 core
+
+// One unit cube [0,1] drawn as GL_LINES, instanced once per bounding box.
+// The instance model matrix maps the unit cube onto the box.
+layout (location = 0) in vec3 corner;
+layout (location = 1) in mat4 boxModel; // uses locations 1, 2, 3 and 4
+layout (location = 5) in vec4 boxColour;
+
+out vec4 colour;
+
+uniform mat4 VP;
+
+void main()
+{
+	gl_Position = VP * boxModel * vec4(corner, 1.0);
+	colour = boxColour;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+// The lines of grid.v.glsl. across is the distance in pixels from the
+// centre of the line so the edge coverage is worked out exactly. The grid
+// fades out between fadeStart and fadeEnd from the camera.
+
+in vec3 viewPos;
+noperspective in float across;
+
+uniform vec4 uColour;
+uniform float lineWidth;
+uniform float fadeStart;
+uniform float fadeEnd;
+
+out vec4 colourOut;
+
+void main()
+{
+	float coverage = clamp(lineWidth * 0.5 + 0.5 - abs(across), 0.0, 1.0);
+	float fade = 1.0 - smoothstep(fadeStart, fadeEnd, length(viewPos));
+	float alpha = uColour.a * coverage * fade;
+	if (alpha <= 0.0)
+		discard;
+	colourOut = vec4(uColour.rgb, alpha);
+}
@@ -0,0 +1,92 @@
+#version 330 core
+
+// A grid of lines with no vertex data. Each instance is one unique line:
+// first the lines along x (one per y, z pair), then along y, then along z.
+// Each line is expanded into a screen space quad lineWidth pixels wide plus
+// a pixel each side for the anti-aliasing in grid.f.glsl.
+// Drawn as a GL_TRIANGLE_STRIP of 4 vertices per instance.
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform vec3 boxMin;
+uniform vec3 boxMax;
+uniform vec3 spacing;
+// Lines across each axis (as floats)
+uniform vec3 counts;
+uniform vec2 viewport;
+uniform float lineWidth;
+
+out vec3 viewPos;
+noperspective out float across;
+
+void main()
+{
+	int nx = int(counts.x);
+	int ny = int(counts.y);
+	int nz = int(counts.z);
+	int id = gl_InstanceID;
+	vec3 a;
+	vec3 b;
+	if (id < ny * nz)
+	{
+		a = vec3(boxMin.x, boxMin.y + (id % ny) * spacing.y, boxMin.z + (id / ny) * spacing.z);
+		b = vec3(boxMax.x, a.y, a.z);
+	}
+	else if (id < ny * nz + nx * nz)
+	{
+		id -= ny * nz;
+		a = vec3(boxMin.x + (id % nx) * spacing.x, boxMin.y, boxMin.z + (id / nx) * spacing.z);
+		b = vec3(a.x, boxMax.y, a.z);
+	}
+	else
+	{
+		id -= ny * nz + nx * nz;
+		a = vec3(boxMin.x + (id % nx) * spacing.x, boxMin.y + (id / nx) * spacing.y, boxMin.z);
+		b = vec3(a.x, a.y, boxMax.z);
+	}
+
+	vec4 va = view * model * vec4(a, 1.0);
+	vec4 vb = view * model * vec4(b, 1.0);
+	vec4 ca = projection * va;
+	vec4 cb = projection * vb;
+	// Clip to the near plane so lines through the camera have a sensible
+	// direction on screen.
+	float da = ca.z + ca.w;
+	float db = cb.z + cb.w;
+	if (da < 0.0 && db < 0.0)
+	{
+		// Outside the clip volume so the triangles are dropped.
+		gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+		viewPos = va.xyz;
+		across = 0.0;
+		return;
+	}
+	if (da < 0.0)
+	{
+		float t = da / (da - db);
+		ca = mix(ca, cb, t);
+		va = mix(va, vb, t);
+	}
+	else if (db < 0.0)
+	{
+		float t = db / (db - da);
+		cb = mix(cb, ca, t);
+		vb = mix(vb, va, t);
+	}
+
+	vec2 sa = ca.xy / ca.w * viewport * 0.5;
+	vec2 sb = cb.xy / cb.w * viewport * 0.5;
+	vec2 dir = sb - sa;
+	dir = length(dir) > 0.0001 ? normalize(dir) : vec2(1.0, 0.0);
+	vec2 normal = vec2(-dir.y, dir.x);
+
+	bool second = (gl_VertexID & 2) != 0;
+	float side = (gl_VertexID & 1) != 0 ? 1.0 : -1.0;
+	float halfWidth = lineWidth * 0.5 + 1.0;
+	vec4 c = second ? cb : ca;
+	vec2 offset = normal * side * halfWidth * 2.0 / viewport;
+	gl_Position = c + vec4(offset * c.w, 0.0, 0.0);
+	viewPos = second ? vb.xyz : va.xyz;
+	across = side * halfWidth;
+}
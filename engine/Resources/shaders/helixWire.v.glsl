@@ -0,0 +1,97 @@
+#version 330 core
+
+// The wires of a rope as tubes along helices with no mesh. Each instance is
+// one wire (see HelixWireRenderer::Wire) and each vertex is worked out from
+// gl_VertexID: two triangles between each pair of neighbouring points on
+// neighbouring rings, then a fan over the start and one over the end.
+// Drawn as GL_TRIANGLES and lit by Wires.f.glsl.
+
+// Strand pitch and phase, wire pitch and phase
+layout (location = 0) in vec4 helix;
+// Radius, strand twist, wire twist
+layout (location = 1) in vec4 radiusTwist;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 LightPos;
+
+uniform vec3 viewLightPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// The rope runs along z from 0 to ropeLength.
+uniform float ropeLength;
+uniform int rings;
+uniform int pointsPerWire;
+
+const float TwoPi = 6.28318530718;
+
+vec2 u;
+vec2 v;
+
+// Centre of the wire at depth z. Sets u (out from the strand centre) and v.
+vec2 wireCentre(float z)
+{
+	float strandAngle = helix.y + radiusTwist.y * z;
+	vec2 strand = helix.x * vec2(cos(strandAngle), sin(strandAngle));
+	float wireAngle = helix.w + radiusTwist.z * z;
+	u = vec2(cos(wireAngle), sin(wireAngle));
+	v = vec2(-u.y, u.x);
+	return strand + helix.z * u;
+}
+
+// Point p around the wire, clockwise, at depth z. The wire is cut across
+// the rope axis so its circle is stretched along the lay by 1 / cos(lay angle).
+vec3 wirePoint(float z, int p, out vec3 normal)
+{
+	vec2 centre = wireCentre(z);
+	// tan(lay angle)
+	float k = helix.z * radiusTwist.z;
+	float stretch = sqrt(1.0 + k * k);
+	float t = -TwoPi * float(p % pointsPerWire) / float(pointsPerWire);
+	float radius = radiusTwist.x;
+	// At right angles to the wire, which leans along v.
+	normal = vec3(u * cos(t) + v * (sin(t) / stretch), -k * sin(t) / stretch);
+	return vec3(centre + u * (radius * cos(t)) + v * (radius * stretch * sin(t)), z);
+}
+
+void main()
+{
+	const ivec2 corners[6] = ivec2[6](ivec2(1, 0), ivec2(0, 0), ivec2(0, 1),
+		ivec2(1, 0), ivec2(0, 1), ivec2(1, 1));
+	int sideVertices = (rings - 1) * pointsPerWire * 6;
+	float ringSpacing = ropeLength / float(rings - 1);
+	vec3 pos;
+	vec3 norm;
+	if (gl_VertexID < sideVertices)
+	{
+		int quad = gl_VertexID / 6;
+		ivec2 corner = corners[gl_VertexID % 6];
+		int ring = quad / pointsPerWire + corner.y;
+		pos = wirePoint(float(ring) * ringSpacing, quad % pointsPerWire + corner.x, norm);
+	}
+	else
+	{
+		// The start is centre, p, p + 1 and the end p + 1, p, centre.
+		int id = gl_VertexID - sideVertices;
+		bool end = id >= pointsPerWire * 3;
+		if (end)
+			id -= pointsPerWire * 3;
+		int p = id / 3;
+		int corner = id % 3;
+		float z = end ? ropeLength : 0.0;
+		vec3 unused;
+		if (corner == (end ? 2 : 0))
+			pos = vec3(wireCentre(z), z);
+		else
+			pos = wirePoint(z, corner == 1 ? p : p + 1, unused);
+		norm = vec3(0.0, 0.0, end ? 1.0 : -1.0);
+	}
+
+	gl_Position = projection * view * model * vec4(pos, 1.0);
+	FragPos = vec3(view * model * vec4(pos, 1.0));
+	Normal = mat3(transpose(inverse(view * model))) * norm;
+	LightPos = vec3(view * vec4(viewLightPos, 1.0));
+}
@@ -18,11 +18,18 @@ uniform vec3 CameraRight_worldspace;
 uniform vec3 CameraUp_worldspace;
 uniform mat4 VP; // Model-View-Projection matrix, but without the Model (the position is in BillboardPos; the orientation depends on the camera)
 uniform vec2 u_resolution;
+// Quantised positions are in [0, 1] across the bounds of the instances.
+// 0 and 1 for float positions.
+uniform vec3 instanceOrigin;
+uniform vec3 instanceExtent;
+// With a palette color.x is the index of the colour.
+uniform int paletteSize;
+uniform vec4 palette[16];
 
 void main()
 {
 	float particleSize = 1.0;
-	vec3 particleCenter_worldspace = xyzs.xyz;
+	vec3 particleCenter_worldspace = instanceOrigin + xyzs.xyz * instanceExtent;
 	
 	vec3 vertexPosition_worldspace = 
 		particleCenter_worldspace
@@ -35,8 +42,8 @@ void main()
     //vec2 ndcPos = gl_Position.xy / gl_Position.w;
     //UV = u_resolution * (ndcPos * 0.5 + 0.5);
 
-	vec4 temp = VP * vec4(xyzs.xyz, 1.0f);
+	vec4 temp = VP * vec4(particleCenter_worldspace, 1.0f);
 	vec2 tempPos = temp.xy / temp.w;
 	particleCenter = u_resolution * (tempPos * 0.5 + 0.5);
-	particlecolor = color;
+	particlecolor = paletteSize > 0 ? palette[int(color.x)] : color;
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#version 330 core
+
+// starPoints.v.glsl for catalogue stars. The positions come as separate
+// x, y and z attributes (the catalogue keeps them in separate arrays) and
+// the colours as normalised RGBA8. They all have the same magnitude.
+
+layout(location = 0) in float starX;
+layout(location = 2) in float starY;
+layout(location = 3) in float starZ;
+layout(location = 1) in vec4 colour;
+
+out vec4 starColour;
+out float starIntensity;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform float viewportHeight;
+uniform float starRadius;
+uniform float maxPointSize;
+uniform float nearDistance;
+uniform float magnitude;
+
+#include "starSprite.glsl"
+
+void main()
+{
+	vec4 viewPos = view * model * vec4(starX, starY, starZ, 1.0);
+	float dist = max(length(viewPos.xyz), 0.0001);
+	gl_Position = projection * viewPos;
+	if (dist < nearDistance)
+		gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+	float size = starPointSize(magnitude, dist);
+	gl_PointSize = clamp(size, 1.0, maxPointSize);
+	starIntensity = starPointIntensity(size);
+	starColour = colour;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+// Emits only the stars starCull.v.glsl kept. The outputs are captured by
+// transform feedback, interleaved in the same layout as the input.
+
+layout(points) in;
+layout(points, max_vertices = 1) out;
+
+in vec4 vStar[];
+in vec4 vColour[];
+flat in int vVisible[];
+
+out vec4 culledStar;
+out vec4 culledColour;
+
+void main()
+{
+	if (vVisible[0] == 0)
+		return;
+	culledStar = vStar[0];
+	culledColour = vColour[0];
+	gl_Position = gl_in[0].gl_Position;
+	EmitVertex();
+	EndPrimitive();
+}
@@ -0,0 +1,51 @@
+#version 330 core
+
+// The visibility test of the PointCuller. A star is kept if it is in the
+// frustum, is not drawn as a mesh and is bright enough to show up.
+// starCull.g.glsl emits the ones kept. The sprite size is from
+// starSprite.glsl, as in starPoints.v.glsl.
+
+layout(location = 0) in vec4 packedStar; // xyz position, w magnitude
+layout(location = 1) in vec4 colour;
+
+out vec4 vStar;
+out vec4 vColour;
+flat out int vVisible;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform float viewportHeight;
+uniform float starRadius;
+uniform float nearDistance;
+// Quantised stars are unpacked from [0, 1] with these, see
+// PointSpriteRenderer. Float stars have 0 and 1.
+uniform vec4 starOrigin;
+uniform vec4 starExtent;
+
+// About one step of an 8 bit colour channel.
+const float minIntensity = 1.0 / 255.0;
+
+#include "starSprite.glsl"
+
+void main()
+{
+	vec4 star = starOrigin + packedStar * starExtent;
+	vStar = star;
+	vColour = colour;
+	vec4 viewPos = view * model * vec4(star.xyz, 1.0);
+	float dist = max(length(viewPos.xyz), 0.0001);
+	float size = starPointSize(star.w, dist);
+
+	vec4 clip = projection * viewPos;
+	gl_Position = clip;
+	// The frustum is grown by the sprite size so stars just off screen
+	// still glow at the edge.
+	float margin = clip.w * size * 2.0 / viewportHeight;
+	bool inFrustum = abs(clip.x) <= clip.w + margin
+		&& abs(clip.y) <= clip.w + margin
+		&& abs(clip.z) <= clip.w;
+	bool visible = inFrustum && dist >= nearDistance
+		&& starPointIntensity(size) >= minIntensity;
+	vVisible = visible ? 1 : 0;
+}
@@ -0,0 +1,20 @@
+#version 330 core
+
+// The glow of glow.f.glsl worked out over the point sprite instead of a
+// star mesh. See that file for the shape of the curve.
+
+in vec4 starColour;
+in float starIntensity;
+out vec4 colourOut;
+
+void main()
+{
+	// 0 at the centre of the sprite and 1 at the edge of its circle.
+	float r = length(gl_PointCoord - vec2(0.5)) * 2.0;
+	if (r >= 1.0)
+		discard;
+	// 1/r fall off, pulled down to 0 at the edge so the square never shows.
+	float glow = pow(0.7 * (1.0 - r) / max(r, 0.02), 1.8);
+	vec3 col = 1.0 - exp(-glow * starColour.rgb);
+	colourOut = vec4(col, starIntensity);
+}
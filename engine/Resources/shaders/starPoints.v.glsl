@@ -0,0 +1,45 @@
+#version 330 core
+
+// Stars as point sprites. The sprite is sized from the distance to the
+// camera and the magnitude of the star so a distant star costs a few
+// fragments rather than a whole glow mesh.
+
+layout(location = 0) in vec4 packedStar; // xyz position, w magnitude
+layout(location = 1) in vec4 colour;
+
+out vec4 starColour;
+out float starIntensity;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform float viewportHeight;
+// World radius of the glow of a magnitude 0 star.
+uniform float starRadius;
+uniform float maxPointSize;
+// Stars closer than this are drawn as meshes by the StarComponent.
+uniform float nearDistance;
+// Quantised stars are unpacked from [0, 1] with these, see
+// PointSpriteRenderer. Float stars have 0 and 1.
+uniform vec4 starOrigin;
+uniform vec4 starExtent;
+
+#include "starSprite.glsl"
+
+void main()
+{
+	vec4 star = starOrigin + packedStar * starExtent;
+	vec4 viewPos = view * model * vec4(star.xyz, 1.0);
+	float dist = max(length(viewPos.xyz), 0.0001);
+	gl_Position = projection * viewPos;
+	if (dist < nearDistance)
+	{
+		// Outside the clip volume so the point is dropped.
+		gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+	}
+
+	float size = starPointSize(star.w, dist);
+	gl_PointSize = clamp(size, 1.0, maxPointSize);
+	starIntensity = starPointIntensity(size);
+	starColour = colour;
+}
@@ -0,0 +1,64 @@
+#version 330 core
+
+// Stars with no vertex data: each one is made from gl_VertexID and a seed
+// with a counter based hash so the same seed always gives the same sky.
+// Positions are normally distributed about centre (Box-Muller), magnitudes
+// are mostly faint with the odd bright one, and colours cycle through the
+// palette. The sprite is then sized by starSprite.glsl and drawn with
+// starPoints.f.glsl.
+
+out vec4 starColour;
+out float starIntensity;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform float viewportHeight;
+uniform float starRadius;
+uniform float maxPointSize;
+uniform int seed;
+uniform vec3 centre;
+// Standard deviations of the positions
+uniform vec3 spread;
+uniform vec4 palette[8];
+uniform int paletteSize;
+
+const float TwoPi = 6.28318530718;
+
+#include "starSprite.glsl"
+
+// PCG hash. Jarzynski and Olano, Hash Functions for GPU Rendering, 2020.
+uint pcg(uint v)
+{
+	uint state = v * 747796405u + 2891336453u;
+	uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+// The n'th uniform sample in (0, 1) of this star.
+float uniformSample(uint star, uint n)
+{
+	uint h = pcg(pcg(uint(seed)) + star * 5u + n);
+	return (float(h >> 8u) + 0.5) / 16777216.0;
+}
+
+void main()
+{
+	uint id = uint(gl_VertexID);
+	float r1 = sqrt(-2.0 * log(uniformSample(id, 0u)));
+	float a1 = TwoPi * uniformSample(id, 1u);
+	float r2 = sqrt(-2.0 * log(uniformSample(id, 2u)));
+	float a2 = TwoPi * uniformSample(id, 3u);
+	vec3 normal = vec3(r1 * cos(a1), r1 * sin(a1), r2 * cos(a2));
+	vec3 position = centre + spread * normal;
+	// Exponentially distributed below magnitude 6.
+	float magnitude = max(0.0, 6.0 + 2.0 * log(uniformSample(id, 4u)));
+
+	vec4 viewPos = view * model * vec4(position, 1.0);
+	float dist = max(length(viewPos.xyz), 0.0001);
+	gl_Position = projection * viewPos;
+	float size = starPointSize(magnitude, dist);
+	gl_PointSize = clamp(size, 1.0, maxPointSize);
+	starIntensity = starPointIntensity(size);
+	starColour = palette[int(id % uint(paletteSize))];
+}
@@ -0,0 +1,20 @@
+// The size of a star's point sprite, included by every star vertex shader
+// so the stars culled are the ones drawn. The includer declares the
+// projection, viewportHeight and starRadius uniforms first.
+
+// Pixels across for a star of this magnitude dist from the camera. Each
+// magnitude is 2.512 times fainter and the glow radius goes with the
+// square root so its area goes with the brightness. starRadius is the
+// world radius of the glow of a magnitude 0 star.
+float starPointSize(float magnitude, float dist)
+{
+	float radius = starRadius * sqrt(pow(2.512, -magnitude));
+	return radius * projection[1][1] * viewportHeight / dist;
+}
+
+// Stars smaller than a pixel are drawn as one pixel made fainter by the
+// difference in area so they do not shimmer as they move.
+float starPointIntensity(float size)
+{
+	return clamp(size * size, 0.0, 1.0);
+}
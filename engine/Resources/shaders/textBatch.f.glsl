@@ -0,0 +1,17 @@
+#version 330 core
+// textBatch.f.glsl
+// text.f.glsl with the colour supplied per vertex rather than as a uniform.
+in vec2 uv;
+in vec4 vColour;
+uniform sampler2D textureImageId;
+
+void main(void) {
+	float opacity = texture(textureImageId, uv).r;
+	gl_FragColor = vec4(1, 1, 1, opacity) * vColour;
+	
+	// https://stackoverflow.com/questions/42364244/stacking-partly-transparent-font-textures-is-broken-by-changing-render-order
+	if (opacity < 0.5)
+		gl_FragDepth = 1;
+	else
+		gl_FragDepth = gl_FragCoord.z;
+}
@@ -3,8 +3,17 @@
 // textDynamicBillboard.v.glsl
 layout(location = 0) in vec4 coord;
 
+// Used when instanced is true. One instance per label. The label glyphs are
+// read from the glyphs buffer, two texels per glyph holding the top left
+// and bottom right corners as (x, y, u, v).
+layout(location = 1) in vec3 labelPos;
+layout(location = 2) in vec2 labelSize;
+layout(location = 3) in vec4 labelColour;
+layout(location = 4) in ivec2 glyphRange; // first glyph, number of glyphs
+
 // Output data ; will be interpolated for each fragment.
 out vec2 uv;
+out vec4 vColour;
 
 // Values that stay constant for the whole mesh.
 uniform vec3 CameraRight_worldspace;
@@ -12,15 +21,42 @@ uniform vec3 CameraUp_worldspace;
 uniform mat4 VP; // Model-View-Projection matrix, but without the Model (the position is in BillboardPos; the orientation depends on the camera)
 uniform vec3 BillboardPos; // Position of the center of the billboard
 uniform vec2 BillboardSize; // Size of the billboard, in world units (probably meters)
+uniform bool instanced;
+uniform samplerBuffer glyphs;
 
 void main()
 {
 	vec3 particleCenter_wordspace = BillboardPos;
+	vec2 billboardSize = BillboardSize;
+	vec4 glyphCoord = coord;
+	vColour = vec4(1);
+	if (instanced)
+	{
+		// 6 vertices per glyph quad, ordered as createText() makes them.
+		int quad = gl_VertexID / 6;
+		if (quad >= glyphRange.y)
+		{
+			// This label has fewer glyphs than the draw. Collapse the triangle.
+			gl_Position = vec4(0, 0, 0, 1);
+			uv = vec2(0);
+			return;
+		}
+		int corner = gl_VertexID - quad * 6;
+		bool right = corner == 1 || corner == 3 || corner == 5;
+		bool bottom = corner == 2 || corner == 4 || corner == 5;
+		vec4 topLeft = texelFetch(glyphs, (glyphRange.x + quad) * 2);
+		vec4 bottomRight = texelFetch(glyphs, (glyphRange.x + quad) * 2 + 1);
+		glyphCoord.xz = right ? bottomRight.xz : topLeft.xz;
+		glyphCoord.yw = bottom ? bottomRight.yw : topLeft.yw;
+		particleCenter_wordspace = labelPos;
+		billboardSize = labelSize;
+		vColour = labelColour;
+	}
 	
 	vec3 vertexPosition_worldspace = 
 		particleCenter_wordspace
-		+ CameraRight_worldspace * coord.x * BillboardSize.x
-		+ CameraUp_worldspace * coord.y * BillboardSize.y;
+		+ CameraRight_worldspace * glyphCoord.x * billboardSize.x
+		+ CameraUp_worldspace * glyphCoord.y * billboardSize.y;
 
 
 	// Output position of the vertex
@@ -37,5 +73,5 @@ void main()
 	// Or, if BillboardSize is in pixels : 
 	// Same thing, just use (ScreenSizeInPixels / BillboardSizeInPixels) instead of BillboardSizeInScreenPercentage.
 
-	uv = coord.zw;
+	uv = glyphCoord.zw;
 }
@@ -0,0 +1,23 @@
+#version 330 core
+
+// textStaticBatch.v.glsl
+// The batched version of textStaticBillboard.v.glsl. Every vertex carries
+// the position of its label and its colour so many labels can be drawn together.
+layout(location = 0) in vec4 coord;
+layout(location = 1) in vec3 anchor; // Position of the center of the label
+layout(location = 2) in vec4 colour;
+
+out vec2 uv;
+out vec4 vColour;
+
+uniform mat4 VP;
+uniform vec2 BillboardSize; // Size of the billboard, in percentage of the screen
+
+void main()
+{
+	gl_Position = VP * vec4(anchor, 1.0f);
+	gl_Position /= gl_Position.w;
+	gl_Position.xy += coord.xy * BillboardSize; 
+	uv = coord.zw;
+	vColour = colour;
+}